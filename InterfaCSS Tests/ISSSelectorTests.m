@@ -21,6 +21,9 @@
 #import "ISSPropertyRegistry.h"
 #import "ISSStylingContext.h"
 #import "ISSNestedElementSelector.h"
+#import "ISSAncestorFilter.h"
+#import "ISSElementStyleIdentity.h"
+#import "ISSStyleClassSet.h"
 
 
 @interface MyCustomView : UIView
@@ -49,6 +52,11 @@
 
 
 
+@interface ISSStyleSheet (RuleIndexTests)
+- (NSIndexSet*) candidateDeclarationIndicesForElement:(ISSUIElementDetails*)elementDetails;
+@end
+
+
 @interface ISSSelectorTests : XCTestCase
 @end
 
@@ -591,4 +599,142 @@
     XCTAssertEqual(context.containsPartiallyMatchedDeclarations, YES);
 }
 
+- (void) testAncestorFilter {
+    UIView* inbetweenView = [[UIView alloc] init];
+    [rootView addSubview:inbetweenView];
+
+    UILabel* label = [[UILabel alloc] init];
+    [inbetweenView addSubview:label];
+    [label addStyleClassISS:@"childClass"];
+    ISSUIElementDetails* labelDetails = [[InterfaCSS sharedInstance] detailsForUIElement:label];
+
+    ISSAncestorFilter* filter = [[ISSAncestorFilter alloc] init];
+    XCTAssertFalse([filter isValidForElement:labelDetails], @"Empty ancestor filter must not be valid for element");
+    XCTAssertEqual([filter pushAncestorsOfElement:labelDetails], (NSUInteger)3);
+    XCTAssertTrue([filter isValidForElement:labelDetails], @"Ancestor filter must be valid for element after pushing ancestors");
+
+    ISSStylingContext* context = [[ISSStylingContext alloc] init];
+    context.ancestorFilter = filter;
+
+    ISSSelectorChain* descendantChain = [self createSelectorChainWithChildType:@"uilabel" combinator:ISSSelectorCombinatorDescendant childPseudoClass:nil];
+    XCTAssertTrue([descendantChain matchesElement:labelDetails stylingContext:context], @"Descendant selector chain must match when using ancestor filter!");
+
+    ISSSelector* otherParentSelector = [ISSSelector selectorWithType:nil styleClass:@"otherParentClass" pseudoClasses:nil];
+    ISSSelector* labelSelector = [ISSSelector selectorWithType:@"uilabel" styleClass:@"childClass" pseudoClasses:nil];
+    ISSSelectorChain* otherChain = [ISSSelectorChain selectorChainWithComponents:@[otherParentSelector, @(ISSSelectorCombinatorDescendant), labelSelector]];
+    XCTAssertFalse([otherChain matchesElement:labelDetails stylingContext:context], @"Descendant selector chain must NOT match when ancestor is missing!");
+    XCTAssertTrue(context.containsPartiallyMatchedDeclarations, @"Rejection by ancestor filter must be reported as partial match");
+
+    [filter invalidate];
+    XCTAssertFalse([filter isValidForElement:labelDetails], @"Invalidated ancestor filter must not be valid for element");
+}
+
+- (void) testElementStyleIdentityInterning {
+    ISSElementStyleIdentity* parent = [ISSElementStyleIdentity identityWithElementId:@"parentId" styleClasses:nil];
+    ISSElementStyleIdentity* identity1 = [ISSElementStyleIdentity identityWithType:UILabel.class styleClasses:[ISSStyleClassSet styleClassSetWithStyleClasses:@[@"b", @"a"]] parent:parent];
+    ISSElementStyleIdentity* identity2 = [ISSElementStyleIdentity identityWithType:UILabel.class styleClasses:[ISSStyleClassSet styleClassSetWithStyleClasses:@[@"a", @"b"]] parent:parent];
+    ISSElementStyleIdentity* identity3 = [ISSElementStyleIdentity identityWithType:UILabel.class styleClasses:[ISSStyleClassSet styleClassSetWithStyleClasses:@[@"a"]] parent:parent];
+
+    XCTAssertTrue(identity1 == identity2, @"Equal style identities must be interned to the same instance");
+    XCTAssertEqual(identity1.identifier, identity2.identifier);
+    XCTAssertFalse(identity1 == identity3, @"Different style identities must not be interned to the same instance");
+    XCTAssertTrue(identity1.containsElementId);
+    XCTAssertFalse(identity1.containsCustomStyleIdentity);
+    XCTAssertEqualObjects(identity1.path, @"#parentId UILabel[a,b]");
+}
+
+- (void) testElementStyleIdentityPurging {
+    ISSElementStyleIdentity* liveIdentity = [ISSElementStyleIdentity identityWithType:UILabel.class styleClasses:[ISSStyleClassSet styleClassSetWithStyleClasses:@[@"purgeLive"]] parent:nil];
+    NSUInteger liveIdentifier = liveIdentity.identifier;
+    NSUInteger deadIdentifier;
+    @autoreleasepool {
+        ISSElementStyleIdentity* deadIdentity = [ISSElementStyleIdentity identityWithType:UILabel.class styleClasses:[ISSStyleClassSet styleClassSetWithStyleClasses:@[@"purgeDead"]] parent:nil];
+        deadIdentifier = deadIdentity.identifier;
+    }
+
+    [ISSElementStyleIdentity purgeUnusedIdentities];
+
+    // Identities still in use must survive purging (i.e. same style class set identifier must still be used)
+    XCTAssertTrue(liveIdentity == [ISSElementStyleIdentity identityWithType:UILabel.class styleClasses:[ISSStyleClassSet styleClassSetWithStyleClasses:@[@"purgeLive"]] parent:nil]);
+    XCTAssertEqual(liveIdentity.identifier, liveIdentifier);
+    // Purged identities are simply re-interned
+    ISSElementStyleIdentity* recreatedIdentity = [ISSElementStyleIdentity identityWithType:UILabel.class styleClasses:[ISSStyleClassSet styleClassSetWithStyleClasses:@[@"purgeDead"]] parent:nil];
+    XCTAssertNotEqual(recreatedIdentity.identifier, deadIdentifier);
+    XCTAssertFalse(recreatedIdentity == liveIdentity);
+}
+
+- (void) testStyleClassSet {
+    ISSStyleClassSet* elementClasses = [ISSStyleClassSet styleClassSetWithStyleClasses:@[@"ClassA", @"classB", @"classC"]];
+    XCTAssertEqualObjects(elementClasses.styleClasses, ([NSSet setWithArray:@[@"classa", @"classb", @"classc"]]));
+    XCTAssertTrue([elementClasses containsStyleClass:@"CLASSA"]);
+    XCTAssertFalse([elementClasses containsStyleClass:@"classD"]);
+
+    XCTAssertTrue([elementClasses containsStyleClassSet:[ISSStyleClassSet styleClassSetWithStyleClasses:@[@"classa", @"CLASSC"]]]);
+    XCTAssertFalse([elementClasses containsStyleClassSet:[ISSStyleClassSet styleClassSetWithStyleClasses:@[@"classa", @"classD"]]]);
+
+    ISSStyleClassSet* modifiedClasses = [[elementClasses styleClassSetByAddingStyleClass:@"ClassD"] styleClassSetByRemovingStyleClass:@"CLASSB"];
+    XCTAssertEqualObjects(modifiedClasses.styleClasses, ([NSSet setWithArray:@[@"classa", @"classc", @"classd"]]));
+    XCTAssertEqualObjects(modifiedClasses, ([ISSStyleClassSet styleClassSetWithStyleClasses:@[@"classd", @"classc", @"classa"]]));
+
+    // Purging remembered spellings must not affect atoms
+    NSUInteger atom = [ISSStyleClassSet atomForStyleClass:@"ClassA"];
+    [ISSStyleClassSet purgeStyleClassSpellings];
+    XCTAssertEqual([ISSStyleClassSet existingAtomForStyleClass:@"CLASSA"], atom);
+    XCTAssertEqualObjects([ISSStyleClassSet styleClassForAtom:atom], @"classa");
+    XCTAssertTrue([elementClasses containsStyleClass:@"ClassA"]);
+}
+
+- (ISSPropertyDeclarations*) declarationsWithSelector:(ISSSelector*)selector {
+    return [[ISSPropertyDeclarations alloc] initWithSelectorChains:@[[ISSSelectorChain selectorChainWithSelector:selector]] andProperties:nil];
+}
+
+- (void) testStyleSheetRuleIndex {
+    UILabel* label = [[UILabel alloc] init];
+    [rootView addSubview:label];
+    label.elementIdISS = @"indexedId";
+    [label addStyleClassISS:@"indexedClass"];
+    ISSUIElementDetails* labelDetails = [[InterfaCSS sharedInstance] detailsForUIElement:label];
+
+    NSArray* declarations = @[
+        [self declarationsWithSelector:[ISSSelector selectorWithType:@"uibutton" styleClass:nil pseudoClasses:nil]],                // 0: other type
+        [self declarationsWithSelector:[ISSSelector selectorWithType:nil elementId:@"indexedId" pseudoClasses:nil]],                // 1: element id
+        [self declarationsWithSelector:[ISSSelector selectorWithType:nil styleClass:@"indexedClass" pseudoClasses:nil]],            // 2: style class
+        [self declarationsWithSelector:[ISSSelector selectorWithType:@"uilabel" styleClass:nil pseudoClasses:nil]],                 // 3: type
+        [self declarationsWithSelector:[ISSSelector selectorWithType:@"*" styleClass:nil pseudoClasses:nil]],                       // 4: universal
+        [self declarationsWithSelector:[ISSNestedElementSelector selectorWithNestedElementKeyPath:@"titleLabel"]],                  // 5: nested element (universal)
+        [self declarationsWithSelector:[ISSSelector selectorWithType:nil styleClass:@"otherClass" pseudoClasses:nil]],              // 6: other style class
+        [self declarationsWithSelector:[ISSSelector selectorWithType:nil elementId:@"otherId" pseudoClasses:nil]],                  // 7: other element id
+        [self declarationsWithSelector:[ISSSelector selectorWithType:@"uilabel" styleClass:@"indexedClass" pseudoClasses:nil]],     // 8: type and style class (style class bucket)
+        [self declarationsWithSelector:[ISSSelector selectorWithType:@"uilabel" elementId:@"indexedId" pseudoClasses:nil]],         // 9: type and element id (element id bucket)
+    ];
+    ISSStyleSheet* styleSheet = [[ISSStyleSheet alloc] initWithStyleSheetURL:[NSURL URLWithString:@"test.css"] declarations:declarations];
+
+    NSMutableIndexSet* expectedCandidates = [NSMutableIndexSet indexSet];
+    for(NSNumber* index in @[@1, @2, @3, @4, @5, @8, @9]) [expectedCandidates addIndex:index.unsignedIntegerValue];
+    XCTAssertEqualObjects([styleSheet candidateDeclarationIndicesForElement:labelDetails], expectedCandidates);
+
+    // Matching declarations must be returned in declaration order, regardless of bucket
+    ISSStylingContext* context = [[ISSStylingContext alloc] init];
+    NSArray* matching = [styleSheet declarationsMatchingElement:labelDetails stylingContext:context];
+    NSArray* expectedMatching = @[declarations[1], declarations[2], declarations[3], declarations[4], declarations[8], declarations[9]];
+    XCTAssertEqual(matching.count, expectedMatching.count);
+    for(NSUInteger i=0; i<MIN(matching.count, expectedMatching.count); i++) {
+        XCTAssertTrue(matching[i] == expectedMatching[i], @"Matching declarations at index %lu not in cascade order", (unsigned long)i);
+    }
+}
+
+- (void) testStyleSheetInvalidationSets {
+    ISSSelectorChain* descendantChain = [self createSelectorChainWithChildType:@"uilabel" combinator:ISSSelectorCombinatorDescendant childPseudoClass:nil];
+    ISSSelector* siblingSelector = [ISSSelector selectorWithType:nil elementId:@"siblingId" pseudoClasses:nil];
+    ISSSelector* labelSelector = [ISSSelector selectorWithType:@"uilabel" pseudoClasses:nil];
+    ISSSelectorChain* siblingChain = [ISSSelectorChain selectorChainWithComponents:@[siblingSelector, @(ISSSelectorCombinatorAdjacentSibling), labelSelector]];
+    ISSPropertyDeclarations* declarations = [[ISSPropertyDeclarations alloc] initWithSelectorChains:@[descendantChain, siblingChain] andProperties:nil];
+    ISSStyleSheet* styleSheet = [[ISSStyleSheet alloc] initWithStyleSheetURL:[NSURL URLWithString:@"test.css"] declarations:@[declarations]];
+
+    XCTAssertEqual([styleSheet invalidationForStyleClass:@"parentclass"], ISSStyleInvalidationDescendants);
+    XCTAssertEqual([styleSheet invalidationForStyleClass:@"childclass"], ISSStyleInvalidationElement, @"Style class only used in rightmost selector must only invalidate element");
+    XCTAssertEqual([styleSheet invalidationForElementId:@"SiblingId"], ISSStyleInvalidationSiblings);
+    XCTAssertEqual([styleSheet invalidationForElementId:@"otherId"], ISSStyleInvalidationElement);
+}
+
 @end
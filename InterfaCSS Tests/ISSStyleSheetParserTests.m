@@ -23,6 +23,10 @@
 #import "ISSUIElementDetails.h"
 #import "ISSParser.h"
 #import "ISSParser+CSS.h"
+#import "ISSStyleSheetCompiler.h"
+#import "ISSStyleSheetTokenizer.h"
+#import "ISSMathExpression.h"
+#import "ISSTransformedValueCache.h"
 
 
 @interface ISSDefaultStyleSheetTestParser : ISSDefaultStyleSheetParser
@@ -226,6 +230,227 @@ static ISSDefaultStyleSheetTestParser* defaultParser;
     XCTAssertEqual((NSUInteger)0, expectedSelectors.count, @"Not all selectors were found (expectedSelectors left: %@)", expectedSelectors);
 }
 
+- (void) testParserNumberAndStringExtractors {
+    ISSParserStatus status = {};
+    XCTAssertEqualObjects([[ISSParser signedNumber] parse:@" - 12.5px" status:&status], @(-12.5));
+    XCTAssertTrue(status.match);
+    XCTAssertEqual(status.index, (NSUInteger)7);
+
+    status = (ISSParserStatus){};
+    XCTAssertEqualObjects([[ISSParser plainNumber] parse:@"42." status:&status], @"42");
+    XCTAssertEqual(status.index, (NSUInteger)2);
+
+    status = (ISSParserStatus){};
+    [[ISSParser signedNumber] parse:@"abc" status:&status];
+    XCTAssertFalse(status.match);
+
+    status = (ISSParserStatus){};
+    XCTAssertEqualObjects([[ISSParser stringWithEscapesUpToUnichar:'\''] parse:@"a\\nb\\'c\\\\d'" status:&status], @"a\nb'c\\d");
+    XCTAssertEqual(status.index, (NSUInteger)10);
+
+    status = (ISSParserStatus){};
+    XCTAssertEqualObjects([[[ISSParser digit] concatMany1] parse:@"123a" status:&status], @"123");
+}
+
+- (void) testMathExpressionEvaluation {
+    XCTAssertEqualObjects([ISSMathExpression evaluate:@"2 * 3 - (2*2.5 + 0.5)"], @(0.5));
+    XCTAssertEqualObjects([ISSMathExpression evaluate:@"10 ** (3 - 1)"], @(100));
+    XCTAssertEqualObjects([ISSMathExpression evaluate:@"2 ^ 3 ^ 2"], @(512));
+    XCTAssertEqualObjects([ISSMathExpression evaluate:@"-7 % 3 + 1/2"], @(-0.5));
+    XCTAssertTrue([ISSMathExpression expressionWithString:@"1 + 2 >= 3 && !(2 ≠ 2) || 0"].boolValue);
+    XCTAssertFalse([ISSMathExpression expressionWithString:@"1 < 2 == 0"].boolValue);
+    XCTAssertEqual([ISSMathExpression expressionWithString:@"1+1"], [ISSMathExpression expressionWithString:@"1+1"]);
+
+    for(NSString* malformed in @[@"", @"(1 + 2", @"1 +", @"1 / 0", @"2 ** ", @"1..2", @"%%", @"<>"]) {
+        XCTAssertNil([ISSMathExpression expressionWithString:malformed], @"Expected '%@' to be malformed", malformed);
+    }
+
+    ISSParserStatus status = {};
+    [[ISSParser iss_mathExpressionParser] parse:@"(1 +" status:&status];
+    XCTAssertFalse(status.match);
+}
+
+- (void) testTransformedValueCache {
+    ISSTransformedValueCache* cache = [[ISSTransformedValueCache alloc] initWithCapacity:16];
+    ISSPropertyDefinition* numberProperty = [[ISSPropertyDefinition alloc] initAnonymousPropertyDefinitionWithType:ISSPropertyTypeNumber];
+    ISSPropertyDefinition* stringProperty = [[ISSPropertyDefinition alloc] initAnonymousPropertyDefinitionWithType:ISSPropertyTypeString];
+
+    [cache setTransformedValue:@(1) forRawValue:@"1" property:numberProperty];
+    XCTAssertEqualObjects([cache transformedValueForRawValue:@"1" property:numberProperty], @(1));
+    XCTAssertNil([cache transformedValueForRawValue:@"1" property:stringProperty], @"Values must be cached per property type");
+    XCTAssertEqual(cache.hitCount, (NSUInteger)1);
+    XCTAssertEqual(cache.missCount, (NSUInteger)1);
+
+    for(NSUInteger i=0; i<100; i++) {
+        [cache setTransformedValue:@(i) forRawValue:[NSString stringWithFormat:@"%lu", (unsigned long)i] property:numberProperty];
+    }
+    XCTAssertTrue(cache.count <= 16, @"Expected cache to be bounded by its capacity");
+    XCTAssertEqual(cache.count + cache.evictionCount, (NSUInteger)100);
+    XCTAssertEqualObjects([cache transformedValueForRawValue:@"99" property:numberProperty], @(99), @"Expected most recently used value to be retained");
+
+    [cache removeAllValues];
+    XCTAssertEqual(cache.count, (NSUInteger)0);
+}
+
+- (void) testChoiceDispatchesOnFirstCharacter {
+    ISSParser* hex = [[ISSParser unichar:'#'] keepRight:[ISSParser takeWhileInSet:[NSCharacterSet alphanumericCharacterSet] minCount:1]];
+    ISSParser* rgb = [[ISSParser stringEQIgnoringCase:@"rgb"] skipSurroundingSpaces];
+    ISSParser* catchAll = [ISSParser takeUntilInSet:[NSCharacterSet whitespaceCharacterSet] minCount:1];
+    ISSParser* choice = [ISSParser choice:@[hex, rgb, catchAll]];
+
+    XCTAssertTrue([hex.firstCharacterSet characterIsMember:'#']);
+    XCTAssertFalse([hex.firstCharacterSet characterIsMember:'r']);
+    XCTAssertTrue([rgb.firstCharacterSet characterIsMember:'R']);
+    XCTAssertTrue([rgb.firstCharacterSet characterIsMember:' ']);
+    XCTAssertFalse(rgb.canMatchEmpty);
+
+    NSDictionary* expected = @{@"#fff": @"fff", @"  RGB ": @"RGB", @"red": @"red", @"öö": @"öö"};
+    for(NSString* input in expected) {
+        ISSParserStatus status = {};
+        XCTAssertEqualObjects([choice parse:input status:&status], expected[input]);
+        XCTAssertTrue(status.match);
+    }
+
+    // Unknown (wrapped) and optional parsers must always be tried
+    ISSParserWrapper* wrapper = [[ISSParserWrapper alloc] init];
+    ISSParser* choiceWithUnknown = [ISSParser choice:@[hex, wrapper, [ISSParser optional:rgb]]];
+    wrapper.wrappedParser = [ISSParser stringEQIgnoringCase:@"x"];
+    ISSParserStatus status = {};
+    XCTAssertEqualObjects([choiceWithUnknown parse:@"x" status:&status], @"x");
+    status = (ISSParserStatus){};
+    [choiceWithUnknown parse:@"y" status:&status];
+    XCTAssertTrue(status.match);
+    XCTAssertEqual(status.index, (NSUInteger)0);
+}
+
+- (void) testSplitStyleSheetIntoChunks {
+    NSString* path = [[NSBundle bundleForClass:self.class] pathForResource:@"styleSheetStructure" ofType:@"css"];
+    NSString* styleSheetData = [NSString stringWithContentsOfFile:path usedEncoding:nil error:nil];
+    NSArray* expected = [defaultParser parse:styleSheetData];
+
+    NSArray* chunks = [ISSStyleSheetTokenizer splitStyleSheet:styleSheetData intoChunksOfLength:64 variableDefinitions:nil];
+    XCTAssertTrue(chunks.count > 1, @"Expected stylesheet to be split into multiple chunks");
+    XCTAssertEqualObjects([chunks componentsJoinedByString:@""], styleSheetData);
+
+    NSMutableArray* result = [NSMutableArray array];
+    for(NSString* chunk in chunks) {
+        [result addObjectsFromArray:[defaultParser parse:chunk] ?: @[]];
+    }
+    XCTAssertEqualObjects([result valueForKey:@"displayDescription"], [expected valueForKey:@"displayDescription"]);
+
+    NSMutableArray* variableDefinitions = [NSMutableArray array];
+    chunks = [ISSStyleSheetTokenizer splitStyleSheet:@"@var1: 1;\n/* { */ .class1 { alpha: @var1; }\n@var2 = \"a;b\";\n.class2 { alpha: 1; }" intoChunksOfLength:1 variableDefinitions:variableDefinitions];
+    XCTAssertEqual(chunks.count, (NSUInteger)2);
+    XCTAssertEqualObjects(variableDefinitions, (@[@[@"var1", @"@var1: 1;"], @[@"var2", @"@var2 = \"a;b\";"]]));
+
+    NSMutableArray* variableUsages = [NSMutableArray array];
+    [ISSStyleSheetTokenizer splitStyleSheet:@".class1 { alpha: @var1; }\n@var1: @var2;\n@var2: 1;" intoChunksOfLength:NSUIntegerMax variableDefinitions:nil variableUsages:variableUsages];
+    XCTAssertEqualObjects(variableUsages, (@[@[@"var1", @NO], @[@"var2", @NO], @[@"var1", @YES], @[@"var2", @YES]]));
+}
+
+- (void) testTokenizerProducesSameResultAsCombinatorParser {
+    ISSDefaultStyleSheetTestParser* combinatorParser = [[ISSDefaultStyleSheetTestParser alloc] init];
+    combinatorParser.useCombinatorParser = YES;
+
+    for(NSString* name in @[@"styleSheetStructure", @"styleSheetPropertyValues", @"styleSheetWithBadData", @"interfaCSSTests", @"interfaCSSTests-variables", @"scopedStyles"]) {
+        NSString* path = [[NSBundle bundleForClass:self.class] pathForResource:name ofType:@"css"];
+        NSString* styleSheetData = [NSString stringWithContentsOfFile:path usedEncoding:nil error:nil];
+        NSArray* expected = [combinatorParser parse:styleSheetData];
+        NSArray* result = [defaultParser parse:styleSheetData];
+
+        XCTAssertEqual(result.count, expected.count, @"Unexpected number of declarations in %@", name);
+        for(NSUInteger i=0; i<MIN(result.count, expected.count); i++) {
+            ISSPropertyDeclarations* declarations = result[i];
+            ISSPropertyDeclarations* expectedDeclarations = expected[i];
+            XCTAssertEqualObjects([declarations displayDescription:NO], [expectedDeclarations displayDescription:NO], @"Mismatch in %@", name);
+            XCTAssertEqualObjects(declarations.extendedDeclarationSelectorChain, expectedDeclarations.extendedDeclarationSelectorChain, @"Mismatch in %@", name);
+            XCTAssertEqual(declarations.properties.count, expectedDeclarations.properties.count, @"Mismatch in %@", name);
+
+            for(NSUInteger p=0; p<MIN(declarations.properties.count, expectedDeclarations.properties.count); p++) {
+                ISSPropertyDeclaration* declaration = declarations.properties[p];
+                ISSPropertyDeclaration* expectedDeclaration = expectedDeclarations.properties[p];
+                XCTAssertEqual(declaration.property, expectedDeclaration.property, @"Mismatch in %@", name);
+                XCTAssertEqualObjects(declaration.unrecognizedName, expectedDeclaration.unrecognizedName, @"Mismatch in %@", name);
+                XCTAssertEqualObjects(declaration.nestedElementKeyPath, expectedDeclaration.nestedElementKeyPath, @"Mismatch in %@", name);
+                XCTAssertEqualObjects(declaration.parameters, expectedDeclaration.parameters, @"Mismatch in %@", name);
+                XCTAssertEqualObjects(declaration.propertyValue, expectedDeclaration.propertyValue, @"Mismatch in %@", name);
+            }
+        }
+    }
+}
+
+
+#pragma mark - Tests - compiled stylesheets
+
+- (void) testCompiledStyleSheetProducesSameDeclarations {
+    for(NSString* name in @[@"styleSheetStructure", @"styleSheetPropertyValues"]) {
+        NSString* path = [[NSBundle bundleForClass:self.class] pathForResource:name ofType:@"css"];
+        NSString* styleSheetData = [NSString stringWithContentsOfFile:path usedEncoding:nil error:nil];
+        NSData* compiledData = [ISSStyleSheetCompiler compileStyleSheetData:styleSheetData];
+        XCTAssertNotNil(compiledData, @"Unable to compile %@", name);
+
+        NSArray* expected = [defaultParser parse:styleSheetData];
+        NSArray* result = [ISSStyleSheetCompiler declarationsFromCompiledData:compiledData parser:defaultParser];
+
+        XCTAssertEqual(result.count, expected.count, @"Unexpected number of declarations in %@", name);
+        for(NSUInteger i=0; i<MIN(result.count, expected.count); i++) {
+            ISSPropertyDeclarations* declarations = result[i];
+            ISSPropertyDeclarations* expectedDeclarations = expected[i];
+            XCTAssertEqualObjects([declarations displayDescription:NO], [expectedDeclarations displayDescription:NO], @"Mismatch in %@", name);
+            XCTAssertEqual(declarations.properties.count, expectedDeclarations.properties.count, @"Mismatch in %@", name);
+
+            for(NSUInteger p=0; p<MIN(declarations.properties.count, expectedDeclarations.properties.count); p++) {
+                ISSPropertyDeclaration* declaration = declarations.properties[p];
+                ISSPropertyDeclaration* expectedDeclaration = expectedDeclarations.properties[p];
+                XCTAssertEqual(declaration.property, expectedDeclaration.property, @"Mismatch in %@", name);
+                XCTAssertEqualObjects(declaration.nestedElementKeyPath, expectedDeclaration.nestedElementKeyPath, @"Mismatch in %@", name);
+                XCTAssertEqualObjects(declaration.parameters, expectedDeclaration.parameters, @"Mismatch in %@", name);
+
+                [declaration transformValueIfNeeded];
+                [expectedDeclaration transformValueIfNeeded];
+                if( [expectedDeclaration.propertyValue isKindOfClass:NSNumber.class] || [expectedDeclaration.propertyValue isKindOfClass:NSString.class] ) {
+                    XCTAssertEqualObjects(declaration.propertyValue, expectedDeclaration.propertyValue, @"Mismatch in %@", name);
+                }
+            }
+        }
+    }
+}
+
+- (void) testInvalidCompiledStyleSheetData {
+    NSData* data = [@"uilabel { alpha: 0.5; }" dataUsingEncoding:NSUTF8StringEncoding];
+    XCTAssertNil([ISSStyleSheetCompiler declarationsFromCompiledData:data parser:defaultParser]);
+
+    NSMutableData* truncatedData = [[ISSStyleSheetCompiler compileStyleSheetData:@"uilabel { alpha: 0.5; }"] mutableCopy];
+    truncatedData.length = truncatedData.length - 2;
+    XCTAssertNil([ISSStyleSheetCompiler declarationsFromCompiledData:truncatedData parser:defaultParser]);
+}
+
+- (void) testCompiledStyleSheetUpToDateCheck {
+    NSURL* directory = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]] isDirectory:YES];
+    [[NSFileManager defaultManager] createDirectoryAtURL:directory withIntermediateDirectories:YES attributes:nil error:nil];
+    NSURL* styleSheetURL = [directory URLByAppendingPathComponent:@"compiled.css"];
+    NSURL* compiledStyleSheetURL = [ISSStyleSheetCompiler compiledStyleSheetURLForStyleSheetURL:styleSheetURL];
+
+    [@"uilabel { alpha: 0.5; }" writeToURL:styleSheetURL atomically:YES encoding:NSUTF8StringEncoding error:nil];
+    XCTAssertTrue([ISSStyleSheetCompiler compileStyleSheetAtURL:styleSheetURL toURL:compiledStyleSheetURL]);
+    XCTAssertEqual([ISSStyleSheetCompiler loadCompiledStyleSheetForStyleSheetURL:styleSheetURL parser:defaultParser].count, 1);
+
+    // Modification time changed, but not content - content hash must still match
+    NSDate* otherDate = [NSDate dateWithTimeIntervalSinceNow:-3600];
+    [[NSFileManager defaultManager] setAttributes:@{NSFileModificationDate: otherDate} ofItemAtPath:styleSheetURL.path error:nil];
+    XCTAssertEqual([ISSStyleSheetCompiler loadCompiledStyleSheetForStyleSheetURL:styleSheetURL parser:defaultParser].count, 1);
+
+    // Content changed (same length)
+    [@"uilabel { alpha: 0.6; }" writeToURL:styleSheetURL atomically:YES encoding:NSUTF8StringEncoding error:nil];
+    XCTAssertNil([ISSStyleSheetCompiler loadCompiledStyleSheetForStyleSheetURL:styleSheetURL parser:defaultParser]);
+
+    // Content changed (different length)
+    [@"uilabel { alpha: 0.75; }" writeToURL:styleSheetURL atomically:YES encoding:NSUTF8StringEncoding error:nil];
+    XCTAssertNil([ISSStyleSheetCompiler loadCompiledStyleSheetForStyleSheetURL:styleSheetURL parser:defaultParser]);
+
+    [[NSFileManager defaultManager] removeItemAtURL:directory error:nil];
+}
+
 
 #pragma mark - Tests - property values
 
@@ -19,6 +19,15 @@
 #import "ISSRectValue.h"
 #import "ISSPointValue.h"
 #import "ISSLayout.h"
+#import "ISSPropertyDeclaration.h"
+#import "NSMutableArray+ISSAdditions.h"
+#import "ISSStyleSheetCache.h"
+#import "ISSStyleSheetCompiler.h"
+#import "ISSDefaultStyleSheetParser.h"
+#import "ISSPropertyDeclarations.h"
+#import "ISSPropertyDefinition.h"
+#import "ISSViewPrototype.h"
+#import "ISSElementStyleIdentity.h"
 
 
 @interface CustomCollectionViewLayout : UICollectionViewFlowLayout
@@ -49,6 +58,26 @@
 @end
 
 
+@interface KVCOnlyTestObject : NSObject {
+    NSInteger _kvcOnlyNumber; // No accessor methods - only settable through KVC
+}
+@end
+@implementation KVCOnlyTestObject
+@end
+
+
+@interface PrewarmTestCell : UITableViewCell
+@end
+@implementation PrewarmTestCell
+- (instancetype) initWithStyle:(UITableViewCellStyle)style reuseIdentifier:(NSString*)reuseIdentifier {
+    if( (self = [super initWithStyle:style reuseIdentifier:reuseIdentifier]) ) {
+        self.styleClassISS = @"prewarmTestCell";
+    }
+    return self;
+}
+@end
+
+
 @interface TestFileOwner : NSObject
 @property (nonatomic, strong) UILabel* label1;
 @property (nonatomic, strong) UIButton* button1;
@@ -72,6 +101,22 @@
 @end
 
 
+/** Parser that (while parsing) defines a variable on another thread, to simulate concurrent parsing of another stylesheet. */
+@interface ConcurrentVariableDefiningParser : ISSDefaultStyleSheetParser
+@end
+@implementation ConcurrentVariableDefiningParser
+- (NSMutableArray*) parse:(NSString*)styleSheetData {
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    [NSThread detachNewThreadWithBlock:^{
+        [[InterfaCSS sharedInstance] setValue:@"1" forStyleSheetVariableWithName:@"parseCacheConcurrentVariable"];
+        dispatch_semaphore_signal(semaphore);
+    }];
+    dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+    return [super parse:styleSheetData];
+}
+@end
+
+
 @interface CustomViewController : UIViewController
 @end
 
@@ -81,7 +126,10 @@
 
 @interface InterfaCSS ()
 
+@property (nonatomic, strong) NSMapTable* cachedStyleDeclarationsForElements;
+
 - (void) initViewHierarchyForView:(UIView*)view;
+- (void) applyScheduledStyling;
 
 @end
 
@@ -158,6 +206,92 @@
     ISSAssertEqualFloats(rootView.alpha, 0.33, @"Unexpected property value");
 }
 
+- (void) testAsyncStyleSheetLoading {
+    NSURL* url = [[NSBundle bundleForClass:self.class] URLForResource:@"interfaCSSTests-variables" withExtension:@"css"];
+    XCTestExpectation* expectation = [self expectationWithDescription:@"Stylesheet loaded"];
+    [[InterfaCSS sharedInstance] loadStyleSheetFromFileURL:url withScope:nil completionHandler:^(ISSStyleSheet* styleSheet) {
+        XCTAssertTrue([NSThread isMainThread], @"Expected stylesheet to be published on the main thread");
+        XCTAssertNotNil(styleSheet);
+        XCTAssertTrue([[InterfaCSS sharedInstance].styleSheets containsObject:styleSheet]);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+
+    UIView* rootView = [[UIView alloc] init];
+    [rootView addStyleClassISS:@"reuseTest"];
+    [rootView applyStylingISS];
+
+    ISSAssertEqualFloats(rootView.alpha, 0.33, @"Unexpected property value");
+}
+
+- (void) testBatchStyleSheetLoadingWithVariableReferences {
+    InterfaCSS* interfaCSS = [InterfaCSS sharedInstance];
+    NSArray* variableNames = @[@"batchForwardVar", @"batchCrossVar", @"batchSharedVar"];
+    NSArray* styleSheetDatas = @[
+        @"@batchSharedVar: 0.3;\n.batchForward { alpha: @batchForwardVar; }\n@batchForwardVar: 0.25;", // Forward reference within stylesheet
+        @".batchCross { alpha: @batchCrossVar; }\n.batchShared { alpha: @batchSharedVar; }", // Reference to variable defined in later stylesheet, and in earlier stylesheet
+        @"@batchCrossVar: 0.5;\n.batchLater { alpha: @batchCrossVar; }"
+    ];
+
+    // Expected result - sequential parsing
+    for(NSString* name in variableNames) [interfaCSS setValue:nil forStyleSheetVariableWithName:name];
+    NSMutableArray* expected = [NSMutableArray array];
+    for(NSString* styleSheetData in styleSheetDatas) {
+        [expected addObject:[[interfaCSS.parser parse:styleSheetData] valueForKey:@"displayDescription"] ?: @[]];
+    }
+
+    NSURL* directory = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]] isDirectory:YES];
+    [[NSFileManager defaultManager] createDirectoryAtURL:directory withIntermediateDirectories:YES attributes:nil error:nil];
+    NSMutableArray* urls = [NSMutableArray array];
+    [styleSheetDatas enumerateObjectsUsingBlock:^(NSString* styleSheetData, NSUInteger i, BOOL* stop) {
+        NSURL* url = [directory URLByAppendingPathComponent:[NSString stringWithFormat:@"batch%lu.css", (unsigned long)i]];
+        [styleSheetData writeToURL:url atomically:YES encoding:NSUTF8StringEncoding error:nil];
+        [urls addObject:url];
+    }];
+
+    for(NSString* name in variableNames) [interfaCSS setValue:nil forStyleSheetVariableWithName:name];
+    XCTestExpectation* expectation = [self expectationWithDescription:@"Stylesheets loaded"];
+    __block NSArray* loadedStyleSheets = nil;
+    [interfaCSS loadStyleSheetsFromFileURLs:urls withScope:nil completionHandler:^(NSArray* styleSheets) {
+        loadedStyleSheets = styleSheets;
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+
+    // Batch loading must give the same result as sequential parsing
+    XCTAssertEqual(loadedStyleSheets.count, styleSheetDatas.count);
+    for(NSUInteger i=0; i<MIN(loadedStyleSheets.count, expected.count); i++) {
+        XCTAssertEqualObjects([[loadedStyleSheets[i] declarations] valueForKey:@"displayDescription"], expected[i], @"Mismatch in stylesheet %lu", (unsigned long)i);
+    }
+    XCTAssertEqualObjects([interfaCSS valueOfStyleSheetVariableWithName:@"batchForwardVar"], @"0.25");
+    XCTAssertEqualObjects([interfaCSS valueOfStyleSheetVariableWithName:@"batchCrossVar"], @"0.5");
+
+    for(ISSStyleSheet* styleSheet in loadedStyleSheets) [interfaCSS unloadStyleSheet:styleSheet refreshStyling:NO];
+    [[NSFileManager defaultManager] removeItemAtURL:directory error:nil];
+}
+
+- (void) testEagerPropertyValueTransformation {
+    ISSStyleSheetCache* styleSheetCache = [InterfaCSS sharedInstance].styleSheetCache;
+    [InterfaCSS sharedInstance].styleSheetCache = nil; // Cached parse results may contain pre-transformed values
+    [InterfaCSS sharedInstance].eagerlyTransformPropertyValues = YES;
+    XCTestExpectation* expectation = [self expectationWithDescription:@"Stylesheet parsed"];
+    __block NSArray* properties = nil;
+    [[InterfaCSS sharedInstance] parseStyleSheetData:@".eagerTest { alpha: 0.5; backgroundColor: #ff0000; textAlignment: center; frame: parent; }" completionHandler:^(NSMutableArray* declarations) {
+        properties = [declarations.firstObject properties];
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+    [InterfaCSS sharedInstance].eagerlyTransformPropertyValues = NO;
+    [InterfaCSS sharedInstance].styleSheetCache = styleSheetCache;
+
+    XCTAssertEqual(properties.count, (NSUInteger)4);
+    for(ISSPropertyDeclaration* decl in properties) {
+        BOOL expectEager = decl.property.type == ISSPropertyTypeNumber || decl.property.type == ISSPropertyTypeColor; // I.e. not enum or (relative) rect
+        XCTAssertEqual(decl.lazyPropertyTransformationBlock == nil, expectEager, @"Unexpected transformation state for %@", decl);
+        if( expectEager ) XCTAssertFalse([decl.propertyValue isKindOfClass:NSString.class], @"Expected transformed value for %@", decl);
+    }
+}
+
 - (void) testSetPropertyThatDoesntExistInTarget {
     UILabel* label = [[UILabel alloc] init];
     [label addStyleClassISS:@"class2"];
@@ -571,6 +705,60 @@
     XCTAssertFalse(hasCustomViewWithCustomSetter);
 }
 
+- (void) testIntrospectionInvokeSetter {
+    CustomView1* view = [[CustomView1 alloc] init];
+    CustomView2* customView = [[CustomView2 alloc] init];
+
+    XCTAssertTrue([ISSRuntimeIntrospectionUtils invokeSetterForProperty:@"customViewWithCustomSetter" withValue:customView inObject:view]);
+    XCTAssertEqual(view.customViewWithCustomSetter, customView);
+
+    XCTAssertTrue([ISSRuntimeIntrospectionUtils invokeSetterForProperty:@"alpha" withValue:@(0.5) inObject:view]);
+    ISSAssertEqualFloats(view.alpha, 0.5);
+    XCTAssertTrue([ISSRuntimeIntrospectionUtils invokeSetterForProperty:@"hidden" withValue:@YES inObject:view]);
+    XCTAssertTrue(view.hidden);
+    XCTAssertTrue([ISSRuntimeIntrospectionUtils invokeSetterForProperty:@"frame" withValue:[NSValue valueWithCGRect:CGRectMake(1, 2, 3, 4)] inObject:view]);
+    XCTAssertTrue(CGRectEqualToRect(view.frame, CGRectMake(1, 2, 3, 4)));
+
+    XCTAssertFalse([ISSRuntimeIntrospectionUtils invokeSetterForProperty:@"noSuchProperty" withValue:@(1) inObject:view]);
+    XCTAssertFalse([ISSRuntimeIntrospectionUtils invokeSetterForProperty:@"noSuchProperty" withValue:@(1) inObject:view], @"Expected missing setter to be cached as missing");
+}
+
+- (void) testPropertyDefinitionSetterPlans {
+    UIView* view = [[UIView alloc] init];
+
+    ISSPropertyDefinition* alpha = [[ISSPropertyDefinition alloc] initWithName:@"alpha" type:ISSPropertyTypeNumber];
+    XCTAssertTrue([alpha setValue:@(0.5) onTarget:view andParameters:nil]);
+    ISSAssertEqualFloats(view.alpha, 0.5);
+    XCTAssertTrue([alpha setValue:@(0.25) onTarget:view andParameters:nil]);
+    ISSAssertEqualFloats(view.alpha, 0.25);
+
+    ISSPropertyDefinition* cornerRadius = [[ISSPropertyDefinition alloc] initWithName:@"layer.cornerRadius" type:ISSPropertyTypeNumber];
+    XCTAssertTrue([cornerRadius setValue:@(3) onTarget:view andParameters:nil]);
+    ISSAssertEqualFloats(view.layer.cornerRadius, 3);
+
+    ISSPropertyDefinition* missing = [[ISSPropertyDefinition alloc] initWithName:@"noSuchProperty" type:ISSPropertyTypeNumber];
+    XCTAssertFalse([missing setValue:@(1) onTarget:view andParameters:nil]);
+    XCTAssertFalse([missing setValue:@(1) onTarget:view andParameters:nil], @"Expected unsupported property to be cached as unsupported");
+
+    // A value specific KVC failure must not cause the property to be treated as unsupported
+    KVCOnlyTestObject* kvcObject = [[KVCOnlyTestObject alloc] init];
+    ISSPropertyDefinition* kvcOnly = [[ISSPropertyDefinition alloc] initWithName:@"kvcOnlyNumber" type:ISSPropertyTypeNumber];
+    XCTAssertFalse([kvcOnly setValue:@[] onTarget:kvcObject andParameters:nil]);
+    XCTAssertTrue([kvcOnly setValue:@(3) onTarget:kvcObject andParameters:nil]);
+    XCTAssertEqualObjects([kvcObject valueForKey:@"kvcOnlyNumber"], @(3));
+}
+
+- (void) testAddAndReplaceUniqueObjectsInArrays {
+    NSMutableArray* merged = [NSMutableArray arrayWithObjects:@"a", @"b", nil];
+    [merged iss_addAndReplaceUniqueObjectsInArrays:@[@[@"c", @"a"], @[], @[@"d", @"c"]]];
+    XCTAssertEqualObjects(merged, (@[@"b", @"a", @"d", @"c"]));
+
+    NSMutableArray* expected = [NSMutableArray arrayWithObjects:@"a", @"b", nil];
+    [expected iss_addAndReplaceUniqueObjectsInArray:@[@"c", @"a"]];
+    [expected iss_addAndReplaceUniqueObjectsInArray:@[@"d", @"c"]];
+    XCTAssertEqualObjects(merged, expected);
+}
+
 - (void) testLayoutOfViewHierarchy {
     ISSRootView* view = [[ISSRootView alloc] initWithFrame:CGRectMake(0, 0, 500, 500)];
     
@@ -708,6 +896,27 @@
     ISSAssertEqualFloats(subView.alpha, 0.5f);
 }
 
+- (void) testResolvedStylesSharedByElementsWithSameIdentity {
+    UIView* root = [[UIView alloc] init];
+    root.elementIdISS = @"resolvedStylesRoot";
+    UILabel* label1 = [[UILabel alloc] init];
+    UILabel* label2 = [[UILabel alloc] init];
+    [root addSubview:label1];
+    [root addSubview:label2];
+    label1.styleClassISS = @"class10";
+    label2.styleClassISS = @"class10";
+
+    [label1 applyStylingISS];
+    [label2 applyStylingISS];
+    ISSAssertEqualFloats(label1.alpha, 0.1f);
+    ISSAssertEqualFloats(label2.alpha, 0.1f);
+
+    ISSUIElementDetails* details1 = [[InterfaCSS sharedInstance] detailsForUIElement:label1];
+    ISSUIElementDetails* details2 = [[InterfaCSS sharedInstance] detailsForUIElement:label2];
+    XCTAssertNotNil(details1.cachedEffectiveStyles);
+    XCTAssertEqual(details1.cachedEffectiveStyles, details2.cachedEffectiveStyles, @"Expected elements with the same style identity to share resolved styles");
+}
+
 - (void) testOverridePropertyDefinitionAndFallback {
     [InterfaCSS clearResetAndUnload]; // Need to reset again, to make sure property registration takes
     
@@ -736,6 +945,34 @@
     XCTAssertEqualObjects(@"Monday", label.text);
 }
 
+- (void) testPropertyOnlyAppliedIfChanged {
+    __block NSUInteger setterInvocationCount = 0;
+    ISSPropertyDefinition* def = [[ISSPropertyDefinition alloc] initWithName:@"countedText" aliases:nil type:ISSPropertyTypeString enumValues:nil enumBitMaskType:NO setterBlock:^BOOL(ISSPropertyDefinition *property, id viewObject, id value, NSArray *parameters) {
+        setterInvocationCount++;
+        return YES;
+    } parameterEnumValues:nil useIntrospection:NO];
+
+    UILabel* label = [[UILabel alloc] init];
+    ISSUIElementDetails* details = [[InterfaCSS sharedInstance] detailsForUIElement:label];
+    ISSPropertyDeclaration* declaration = [[ISSPropertyDeclaration alloc] initWithProperty:def nestedElementKeyPath:nil];
+    declaration.propertyValue = @"Monday";
+
+    [declaration applyPropertyValueOnTarget:details onlyIfChanged:YES];
+    [declaration applyPropertyValueOnTarget:details onlyIfChanged:YES];
+    XCTAssertEqual(setterInvocationCount, (NSUInteger)1, @"Expected unchanged value to be applied only once");
+
+    declaration.propertyValue = @"Tuesday";
+    [declaration applyPropertyValueOnTarget:details onlyIfChanged:YES];
+    XCTAssertEqual(setterInvocationCount, (NSUInteger)2, @"Expected changed value to be applied");
+
+    [declaration applyPropertyValueOnTarget:details onlyIfChanged:NO];
+    XCTAssertEqual(setterInvocationCount, (NSUInteger)3, @"Expected value to always be applied when not only applying changes");
+
+    [details resetCachedData];
+    [declaration applyPropertyValueOnTarget:details onlyIfChanged:YES];
+    XCTAssertEqual(setterInvocationCount, (NSUInteger)4, @"Expected value to be applied after reset of cached data");
+}
+
 - (void) testStyleSheetScoping {
     UIViewController* root = [[UIViewController alloc] init];
     UILabel* rootLabel = [ISSViewBuilder labelWithStyle:@"scopeTest"];
@@ -822,6 +1059,75 @@
     ISSAssertEqualFloats(0.5, customLabel.alpha);
 }
 
+- (void) testScopedStyleSheetInvalidationOnAncestorChange {
+    UIWindow* window = [[UIWindow alloc] init];
+    UIView* containerView = [[UIView alloc] init];
+    [window addSubview:containerView];
+    UILabel* classScopedLabel = [ISSViewBuilder labelWithStyle:@"scopeTest"];
+    [containerView addSubview:classScopedLabel];
+
+    UIView* idContainerView = [[UIView alloc] init];
+    [window addSubview:idContainerView];
+    UILabel* idScopedLabel = [ISSViewBuilder labelWithStyle:@"scopeTest"];
+    [idContainerView addSubview:idScopedLabel];
+
+    // Scope that depends on the style class or element id of the parent element
+    NSString* path = [[NSBundle bundleForClass:self.class] pathForResource:@"scopedStyles" ofType:@"css"];
+    ISSStyleSheetScope* scope = [ISSStyleSheetScope scopeWithMatcher:^BOOL(ISSUIElementDetails* elementDetails) {
+        UIView* superview = elementDetails.view.superview;
+        return [superview hasStyleClassISS:@"scopeInvalidationContainer"] || [superview.elementIdISS isEqualToString:@"scopeInvalidationContainerId"];
+    }];
+    ISSStyleSheet* stylesheet = [[InterfaCSS sharedInstance] loadStyleSheetFromFile:path withScope:scope];
+
+    [window applyStylingISS];
+    ISSAssertEqualFloats(1.0, classScopedLabel.alpha);
+    ISSAssertEqualFloats(1.0, idScopedLabel.alpha);
+
+    // Changing style class / element id of ancestor must invalidate descendants, even if not used in any selector
+    [containerView addStyleClassISS:@"scopeInvalidationContainer"];
+    idContainerView.elementIdISS = @"scopeInvalidationContainerId";
+    [window applyStylingISS];
+    ISSAssertEqualFloats(0.5, classScopedLabel.alpha);
+    ISSAssertEqualFloats(0.5, idScopedLabel.alpha);
+
+    [[InterfaCSS sharedInstance] unloadStyleSheet:stylesheet refreshStyling:NO];
+}
+
+- (void) testDescendantStyleIdentityResetOnAncestorChange {
+    UIWindow* window = [[UIWindow alloc] init];
+    UIView* parentView = [[UIView alloc] init];
+    [window addSubview:parentView];
+    UIView* childView = [[UIView alloc] init];
+    [parentView addSubview:childView];
+
+    // Inactive scoped stylesheets must not cause invalidation of descendants
+    NSString* path = [[NSBundle bundleForClass:self.class] pathForResource:@"scopedStyles" ofType:@"css"];
+    ISSStyleSheet* stylesheet = [[InterfaCSS sharedInstance] loadStyleSheetFromFile:path withScope:[ISSStyleSheetScope scopeWithElementId:@"someScope"]];
+    stylesheet.active = NO;
+
+    [window applyStylingISS];
+
+    ISSUIElementDetails* childDetails = [[InterfaCSS sharedInstance] detailsForUIElement:childView];
+    ISSElementStyleIdentity* initialIdentity = childDetails.styleIdentity;
+    NSMutableArray* initialDeclarations = childDetails.cachedDeclarations;
+    XCTAssertNotNil(initialDeclarations);
+
+    // Style class not used in any non-rightmost selector - only parent element is invalidated, but style identity of descendants must still be updated
+    [parentView addStyleClassISS:@"unusedAncestorClass"];
+    XCTAssertNotEqual(initialIdentity, childDetails.styleIdentity);
+    XCTAssertTrue([childDetails.styleIdentity.path containsString:@"unusedancestorclass"]);
+
+    // ...while the cached declarations of descendants are kept, and cached for the new style identity
+    XCTAssertEqual(initialDeclarations, childDetails.cachedDeclarations);
+    XCTAssertEqual(initialDeclarations, [[InterfaCSS sharedInstance].cachedStyleDeclarationsForElements objectForKey:childDetails.styleIdentity]);
+
+    [[InterfaCSS sharedInstance] unloadStyleSheet:stylesheet refreshStyling:NO];
+
+    parentView.elementIdISS = @"unusedAncestorId";
+    XCTAssertTrue(childDetails.ancestorHasElementId);
+    XCTAssertTrue(childDetails.stylesCacheable);
+}
+
 - (void) testViewControllerSelectorChains {
     UIView* parentView = [[UIView alloc] init];
     parentView.elementIdISS = @"rootView";
@@ -861,6 +1167,361 @@
     XCTAssertEqualObjects(@"UIView[parentswitcher_parentelement] UIView[parentswitcher_childelement]", childView.elementDetailsISS.elementStyleIdentityPath);
 }
 
+- (void) testScheduledStylingAppliedOncePerRunLoopTurn {
+    UIView* parentView = [[UIView alloc] init];
+    parentView.styleClassISS = @"parentSwitcher_parentElement";
+    UIView* childView = [[UIView alloc] init];
+    childView.styleClassISS = @"parentSwitcher_childElement";
+    [parentView addSubview:childView];
+
+    [[InterfaCSS sharedInstance] scheduleApplyStyling:childView animated:NO force:NO];
+    [[InterfaCSS sharedInstance] scheduleApplyStyling:parentView animated:NO force:YES];
+    ISSAssertEqualFloats(1, childView.alpha);
+
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+
+    ISSAssertEqualFloats(0.75, childView.alpha);
+
+    // Cancelled styling should not be applied
+    childView.alpha = 1;
+    [[InterfaCSS sharedInstance] scheduleApplyStyling:childView animated:NO force:YES];
+    [[InterfaCSS sharedInstance] cancelScheduledApplyStyling:childView];
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+
+    ISSAssertEqualFloats(1, childView.alpha);
+}
+
+- (void) testForcedScheduledStylingOfDescendantNotLost {
+    UIView* parentView = [[UIView alloc] init];
+    parentView.styleClassISS = @"parentSwitcher_parentElement";
+    UIView* childView = [[UIView alloc] init];
+    childView.styleClassISS = @"parentSwitcher_childElement";
+    [parentView addSubview:childView];
+    [parentView applyStylingISS];
+    ISSAssertEqualFloats(0.75, childView.alpha);
+
+    // Unforced styling only applies changed values - the forced styling of the child must not be absorbed by the unforced styling of the parent
+    childView.alpha = 1;
+    [[InterfaCSS sharedInstance] scheduleApplyStyling:parentView animated:NO force:NO];
+    [[InterfaCSS sharedInstance] scheduleApplyStyling:childView animated:NO force:YES];
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+
+    ISSAssertEqualFloats(0.75, childView.alpha);
+}
+
+- (void) testTimeSlicedScheduledStyling {
+    InterfaCSS* interfaCSS = [InterfaCSS sharedInstance];
+    interfaCSS.scheduledStylingTimeSlice = 0.000001;
+
+    UIView* parentView = [[UIView alloc] init];
+    parentView.styleClassISS = @"parentSwitcher_parentElement";
+    NSMutableArray* childViews = [NSMutableArray array];
+    for(NSUInteger i=0; i<10; i++) {
+        UIView* childView = [[UIView alloc] init];
+        childView.styleClassISS = @"parentSwitcher_childElement";
+        [parentView addSubview:childView];
+        [childViews addObject:childView];
+    }
+
+    // Child views aren't visible (not in a window) - styling of these should be deferred, but eventually applied
+    [interfaCSS scheduleApplyStyling:parentView animated:NO force:NO];
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+
+    for(UIView* childView in childViews) {
+        ISSAssertEqualFloats(0.75, childView.alpha);
+    }
+
+    interfaCSS.scheduledStylingTimeSlice = 0;
+}
+
+- (void) testForcedDeferredStylingAppliedIfScheduled {
+    InterfaCSS* interfaCSS = [InterfaCSS sharedInstance];
+    interfaCSS.scheduledStylingTimeSlice = 0.000001;
+
+    UIView* parentView = [[UIView alloc] init];
+    parentView.styleClassISS = @"parentSwitcher_parentElement";
+    UIView* childView = [[UIView alloc] init];
+    childView.styleClassISS = @"parentSwitcher_childElement";
+    [parentView addSubview:childView];
+    [parentView applyStylingISS];
+    ISSAssertEqualFloats(0.75, childView.alpha);
+
+    // Styling of the (non-visible) child is deferred when the forced scheduled styling of the parent is applied...
+    childView.alpha = 1;
+    [interfaCSS scheduleApplyStyling:parentView animated:NO force:YES];
+    [interfaCSS applyScheduledStyling];
+    ISSAssertEqualFloats(1, childView.alpha);
+
+    // ...and when the deferred styling is applied directly, it must still be forced
+    [interfaCSS applyStylingIfScheduled:childView];
+    ISSAssertEqualFloats(0.75, childView.alpha);
+
+    interfaCSS.scheduledStylingTimeSlice = 0;
+}
+
+- (void) testReentrantStyling {
+    UIView* parentView = [[UIView alloc] init];
+    UIView* firstChild = [[UIView alloc] init];
+    firstChild.styleClassISS = @"class10";
+    [parentView addSubview:firstChild];
+    UIView* secondChild = [[UIView alloc] init];
+    secondChild.styleClassISS = @"class2";
+    [parentView addSubview:secondChild];
+
+    // Re-entrant styling of an element currently being styled (i.e. on the current path) must be ignored...
+    __block NSUInteger parentStylingCount = 0;
+    __weak UIView* weakParentView = parentView;
+    parentView.didApplyStylingBlockISS = ^(NSArray* propertyDeclarations) {
+        parentStylingCount++;
+        [[InterfaCSS sharedInstance] applyStyling:weakParentView includeSubViews:YES force:YES];
+    };
+    // ...but not re-entrant styling of an element that has already been styled during the styling pass
+    __weak UIView* weakFirstChild = firstChild;
+    secondChild.didApplyStylingBlockISS = ^(NSArray* propertyDeclarations) {
+        weakFirstChild.styleClassISS = @"class13";
+        [[InterfaCSS sharedInstance] applyStyling:weakFirstChild includeSubViews:YES force:YES];
+    };
+
+    [parentView applyStylingISS];
+
+    XCTAssertEqual((NSUInteger)1, parentStylingCount);
+    ISSAssertEqualFloats(0.99, secondChild.alpha);
+    ISSAssertEqualFloats(0.4, firstChild.alpha);
+}
+
+- (void) resolveStylesInBackgroundForUIElement:(id)uiElement {
+    __block BOOL completed = NO;
+    [[InterfaCSS sharedInstance] resolveStylesForUIElement:uiElement completionHandler:^{
+        completed = YES;
+    }];
+    for(NSUInteger i=0; i<40 && !completed; i++) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+    }
+    XCTAssertTrue(completed);
+}
+
+- (void) testApplyStylingWithBackgroundStyleResolution {
+    UIView* parentView = [[UIView alloc] init];
+    parentView.elementIdISS = @"backgroundResolutionParent"; // Makes styles cacheable even though the view isn't in a window
+    parentView.styleClassISS = @"parentSwitcher_parentElement";
+    UIView* childView = [[UIView alloc] init];
+    childView.styleClassISS = @"parentSwitcher_childElement";
+    [parentView addSubview:childView];
+
+    // Styles must be cached by the background resolution, before any styling is applied
+    [self resolveStylesInBackgroundForUIElement:parentView];
+    ISSUIElementDetails* childDetails = [[InterfaCSS sharedInstance] detailsForUIElement:childView];
+    XCTAssertNotNil([[InterfaCSS sharedInstance].cachedStyleDeclarationsForElements objectForKey:childDetails.styleIdentity]);
+    ISSAssertEqualFloats(1, childView.alpha);
+
+    [parentView applyStylingISS];
+    ISSAssertEqualFloats(0.75, childView.alpha);
+
+    // Resolution and styling in one go
+    UIView* parentView2 = [[UIView alloc] init];
+    parentView2.styleClassISS = @"parentSwitcher_parentElement";
+    UIView* childView2 = [[UIView alloc] init];
+    childView2.styleClassISS = @"parentSwitcher_childElement";
+    [parentView2 addSubview:childView2];
+
+    __block BOOL completed = NO;
+    [[InterfaCSS sharedInstance] applyStylingAsynchronously:parentView2 force:NO completionHandler:^{
+        completed = YES;
+    }];
+    for(NSUInteger i=0; i<40 && !completed; i++) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+    }
+
+    XCTAssertTrue(completed);
+    ISSAssertEqualFloats(0.75, childView2.alpha);
+}
+
+- (void) testBackgroundStyleResolutionFallbackForSiblingCombinator {
+    UIView* parentView = [[UIView alloc] init];
+    parentView.elementIdISS = @"backgroundResolutionSiblingParent";
+    UIView* siblingView = [[UIView alloc] init];
+    siblingView.styleClassISS = @"backgroundResolution_sibling";
+    [parentView addSubview:siblingView];
+    UIView* targetView = [[UIView alloc] init];
+    targetView.styleClassISS = @"backgroundResolution_siblingTarget";
+    [parentView addSubview:targetView];
+
+    // Sibling combinators can't be matched against snapshots - styles of the target must be left for resolution on the main thread
+    [self resolveStylesInBackgroundForUIElement:parentView];
+    ISSUIElementDetails* targetDetails = [[InterfaCSS sharedInstance] detailsForUIElement:targetView];
+    XCTAssertNil([[InterfaCSS sharedInstance].cachedStyleDeclarationsForElements objectForKey:targetDetails.styleIdentity]);
+
+    [parentView applyStylingISS];
+    ISSAssertEqualFloats(0.25, targetView.alpha);
+}
+
+- (void) testBackgroundStyleResolutionFallbackForScopedStyleSheet {
+    UIView* parentView = [[UIView alloc] init];
+    parentView.elementIdISS = @"backgroundResolutionScope";
+    UILabel* label = [ISSViewBuilder labelWithStyle:@"scopeTest"];
+    [parentView addSubview:label];
+
+    NSString* path = [[NSBundle bundleForClass:self.class] pathForResource:@"scopedStyles" ofType:@"css"];
+    ISSStyleSheet* stylesheet = [[InterfaCSS sharedInstance] loadStyleSheetFromFile:path withScope:[ISSStyleSheetScope scopeWithElementId:@"backgroundResolutionScope"]];
+
+    // Scopes can only be evaluated using the actual UI elements - nothing must be resolved in the background
+    [self resolveStylesInBackgroundForUIElement:parentView];
+    ISSUIElementDetails* labelDetails = [[InterfaCSS sharedInstance] detailsForUIElement:label];
+    XCTAssertNil([[InterfaCSS sharedInstance].cachedStyleDeclarationsForElements objectForKey:labelDetails.styleIdentity]);
+
+    [parentView applyStylingISS];
+    ISSAssertEqualFloats(0.5, label.alpha);
+
+    [[InterfaCSS sharedInstance] unloadStyleSheet:stylesheet refreshStyling:NO];
+}
+
+- (void) testBackgroundStyleResolutionDiscardedWhenDeclarationsReplaced {
+    UIView* parentView = [[UIView alloc] init];
+    parentView.elementIdISS = @"backgroundResolutionReplacedParent";
+    parentView.styleClassISS = @"parentSwitcher_parentElement";
+    UIView* childView = [[UIView alloc] init];
+    childView.styleClassISS = @"parentSwitcher_childElement";
+    [parentView addSubview:childView];
+
+    // Replace the declarations of the stylesheet (as when it's refreshed) while styles are resolved - background matching must only use the rule index
+    // captured when resolution started, and the (stale) result must be discarded
+    ISSStyleSheet* styleSheet = [InterfaCSS sharedInstance].styleSheets.firstObject;
+    ISSStyleSheetRuleIndex* ruleIndex = styleSheet.ruleIndex;
+    __block BOOL completed = NO;
+    [[InterfaCSS sharedInstance] resolveStylesForUIElement:parentView completionHandler:^{
+        completed = YES;
+    }];
+    [styleSheet setValue:[styleSheet.declarations copy] forKey:@"declarations"];
+    XCTAssertNotEqual(ruleIndex, styleSheet.ruleIndex);
+    XCTAssertEqualObjects(ruleIndex.declarations, styleSheet.declarations);
+
+    for(NSUInteger i=0; i<40 && !completed; i++) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+    }
+    XCTAssertTrue(completed);
+    ISSUIElementDetails* childDetails = [[InterfaCSS sharedInstance] detailsForUIElement:childView];
+    XCTAssertNil([[InterfaCSS sharedInstance].cachedStyleDeclarationsForElements objectForKey:childDetails.styleIdentity]);
+
+    [parentView applyStylingISS];
+    ISSAssertEqualFloats(0.75, childView.alpha);
+}
+
+- (void) testBackgroundStyleResolutionOfNestedElement {
+    UITableViewCell* cell = [[UITableViewCell alloc] initWithStyle:UITableViewCellStyleSubtitle reuseIdentifier:@""];
+    cell.elementIdISS = @"backgroundResolutionCell";
+    [[InterfaCSS sharedInstance] addStyleClass:@"nestedPropertyNotDirectChildView" forUIElement:cell];
+
+    // Nested element selectors are matched using the nested element key paths recorded in the snapshots
+    [self resolveStylesInBackgroundForUIElement:cell];
+    ISSUIElementDetails* detailTextLabelDetails = [[InterfaCSS sharedInstance] detailsForUIElement:cell.detailTextLabel];
+    XCTAssertNotNil([[InterfaCSS sharedInstance].cachedStyleDeclarationsForElements objectForKey:detailTextLabelDetails.styleIdentity]);
+    ISSAssertEqualFloats(1.0f, cell.detailTextLabel.alpha);
+
+    [[InterfaCSS sharedInstance] applyStyling:cell];
+    XCTAssertEqual(cell.textLabel.enabled, NO);
+    ISSAssertEqualFloats(cell.textLabel.alpha, 1.0f);
+    ISSAssertEqualFloats(cell.detailTextLabel.alpha, 0.5f);
+}
+
+- (void) testPrewarmStylesForPrototype {
+    UIView* parentView = [[UIView alloc] init];
+    parentView.elementIdISS = @"prewarmPrototypeParent"; // Makes styles cacheable even though the view isn't in a window
+    parentView.styleClassISS = @"parentSwitcher_parentElement";
+    ISSViewPrototype* prototype = [ISSViewPrototype prototypeWithName:@"prewarmPrototype" propertyName:nil addAsSubView:YES viewBuilderBlock:^UIView*(UIView* superview) {
+        UIView* view = [[UIView alloc] init];
+        view.styleClassISS = @"parentSwitcher_childElement";
+        return view;
+    }];
+
+    __block BOOL completed = NO;
+    [[InterfaCSS sharedInstance] prewarmStylesForPrototype:prototype inParent:parentView completionHandler:^{
+        completed = YES;
+    }];
+    for(NSUInteger i=0; i<40 && !completed; i++) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+    }
+    XCTAssertTrue(completed);
+
+    UIView* childView = [prototype createViewObjectFromPrototypeWithParent:parentView];
+    [parentView addSubview:childView];
+    ISSUIElementDetails* childDetails = [[InterfaCSS sharedInstance] detailsForUIElement:childView];
+    XCTAssertNotNil([[InterfaCSS sharedInstance].cachedStyleDeclarationsForElements objectForKey:childDetails.styleIdentity]);
+
+    [parentView applyStylingISS];
+    ISSAssertEqualFloats(0.75, childView.alpha);
+}
+
+- (void) testPrewarmStylesForIdentityPaths {
+    __block BOOL completed = NO;
+    [[InterfaCSS sharedInstance] prewarmStylesForIdentityPaths:@[@"UIView[parentswitcher_parentelement] UIImageView[parentswitcher_childelement]", @"UIView[parentswitcher_childelement]"] completionHandler:^{
+        completed = YES;
+    }];
+    for(NSUInteger i=0; i<40 && !completed; i++) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+    }
+    XCTAssertTrue(completed);
+
+    UIView* parentView = [[UIView alloc] init];
+    parentView.styleClassISS = @"parentSwitcher_parentElement";
+    UIImageView* childView = [[UIImageView alloc] init];
+    childView.styleClassISS = @"parentSwitcher_childElement";
+    [parentView addSubview:childView];
+    UIView* partiallyMatchedView = [[UIView alloc] init];
+    partiallyMatchedView.styleClassISS = @"parentSwitcher_childElement";
+
+    // Styles fully resolved from the path are cached...
+    ISSUIElementDetails* childDetails = [[InterfaCSS sharedInstance] detailsForUIElement:childView];
+    XCTAssertNotNil([[InterfaCSS sharedInstance].cachedStyleDeclarationsForElements objectForKey:childDetails.styleIdentity]);
+    // ...but not styles containing partial matches (i.e. "UIViewController UIView"), since these depend on the actual element
+    ISSUIElementDetails* partiallyMatchedDetails = [[InterfaCSS sharedInstance] detailsForUIElement:partiallyMatchedView];
+    XCTAssertNil([[InterfaCSS sharedInstance].cachedStyleDeclarationsForElements objectForKey:partiallyMatchedDetails.styleIdentity]);
+
+    [parentView applyStylingISS];
+    ISSAssertEqualFloats(0.75, childView.alpha);
+    [partiallyMatchedView applyStylingISS];
+    ISSAssertEqualFloats(0.5, partiallyMatchedView.alpha);
+}
+
+- (void) testPrewarmStylesForPrototypeCell {
+    UITableView* tableView = [[UITableView alloc] init];
+    tableView.styleClassISS = @"prewarmTestTable";
+    [tableView registerClass:PrewarmTestCell.class forCellReuseIdentifier:@"prewarmTestCell"];
+
+    PrewarmTestCell* cell = [[PrewarmTestCell alloc] initWithStyle:UITableViewCellStyleDefault reuseIdentifier:@"prewarmTestCell"];
+    [tableView addSubview:cell];
+    ISSUIElementDetails* cellDetails = [[InterfaCSS sharedInstance] detailsForUIElement:cell];
+    XCTAssertNil([[InterfaCSS sharedInstance].cachedStyleDeclarationsForElements objectForKey:cellDetails.styleIdentity]);
+
+    [tableView prewarmStylesForPrototypeCellWithIdentifierISS:@"prewarmTestCell"];
+    for(NSUInteger i=0; i<40 && ![[InterfaCSS sharedInstance].cachedStyleDeclarationsForElements objectForKey:cellDetails.styleIdentity]; i++) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+    }
+    XCTAssertNotNil([[InterfaCSS sharedInstance].cachedStyleDeclarationsForElements objectForKey:cellDetails.styleIdentity]);
+    ISSAssertEqualFloats(1, cell.alpha);
+
+    [cell applyStylingISS];
+    ISSAssertEqualFloats(0.5, cell.alpha);
+}
+
+- (void) testStylingAndVisitingOfDeepViewHierarchy {
+    UIView* parentView = [[UIView alloc] init];
+    parentView.styleClassISS = @"parentSwitcher_parentElement";
+    UIView* view = parentView;
+    for(NSUInteger i=0; i<500; i++) {
+        UIView* subview = [[UIView alloc] init];
+        [view addSubview:subview];
+        view = subview;
+    }
+    UIView* childView = [[UIView alloc] init];
+    childView.styleClassISS = @"parentSwitcher_childElement";
+    childView.elementIdISS = @"deepChildElement";
+    [view addSubview:childView];
+
+    [parentView applyStylingISS];
+    ISSAssertEqualFloats(0.75, childView.alpha);
+    XCTAssertEqual([[InterfaCSS sharedInstance] subviewWithElementId:@"deepChildElement" inView:parentView], childView);
+}
+
 - (void) testStyleUpdatesWithElementIdAndStyleClass {
     UIView* view = [[UIView alloc] init];
     view.elementIdISS = @"elementIdAndClassTest";
@@ -884,4 +1545,80 @@
     ISSAssertEqualFloats(10.0, view.contentScaleFactor);
 }
 
+- (NSUInteger) waitForCachedStyleSheetCount:(NSUInteger)count inDirectory:(NSURL*)directoryURL {
+    NSArray* files = nil;
+    for(NSUInteger i=0; i<20; i++) {
+        files = [[NSFileManager defaultManager] contentsOfDirectoryAtURL:directoryURL includingPropertiesForKeys:nil options:0 error:nil];
+        if( files.count >= count ) break;
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+    }
+    return files.count;
+}
+
+- (void) testStyleSheetParseCache {
+    NSURL* cacheDirectoryURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:@"ISSStyleSheetCacheTests"] isDirectory:YES];
+    ISSStyleSheetCache* cache = [[ISSStyleSheetCache alloc] initWithCacheDirectoryURL:cacheDirectoryURL];
+    [cache removeAllCachedStyleSheets];
+
+    InterfaCSS* interfaCSS = [InterfaCSS sharedInstance];
+    NSString* styleSheetData = @"@parseCacheTestAlpha: 0.42; .parseCacheTest { alpha: @parseCacheTestAlpha; }";
+
+    NSArray* parsed = [cache declarationsForStyleSheetData:styleSheetData parser:interfaCSS.parser];
+    XCTAssertEqual([self waitForCachedStyleSheetCount:1 inDirectory:cacheDirectoryURL], (NSUInteger)1);
+
+    // Same data (and variables) - parse result should be loaded from cache, and variables defined by the stylesheet restored
+    [interfaCSS setValue:nil forStyleSheetVariableWithName:@"parseCacheTestAlpha"];
+    NSArray* cached = [cache declarationsForStyleSheetData:styleSheetData parser:interfaCSS.parser];
+    XCTAssertEqual(cached.count, parsed.count);
+    XCTAssertEqualObjects([cached.firstObject displayDescription:NO], [parsed.firstObject displayDescription:NO]);
+    XCTAssertEqualObjects([interfaCSS valueOfStyleSheetVariableWithName:@"parseCacheTestAlpha"], @"0.42");
+    XCTAssertEqual([self waitForCachedStyleSheetCount:1 inDirectory:cacheDirectoryURL], (NSUInteger)1);
+
+    // Registering a custom property should invalidate the cached parse result
+    [interfaCSS setValue:nil forStyleSheetVariableWithName:@"parseCacheTestAlpha"];
+    [interfaCSS.propertyRegistry registerCustomProperty:@"parseCacheTestProperty" propertyType:ISSPropertyTypeNumber];
+    [cache declarationsForStyleSheetData:styleSheetData parser:interfaCSS.parser];
+    XCTAssertEqual([self waitForCachedStyleSheetCount:2 inDirectory:cacheDirectoryURL], (NSUInteger)2);
+
+    [cache removeAllCachedStyleSheets];
+}
+
+- (void) testStyleSheetParseCacheVariableRecordingAndPruning {
+    NSURL* cacheDirectoryURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:@"ISSStyleSheetCachePruningTests"] isDirectory:YES];
+    ISSStyleSheetCache* cache = [[ISSStyleSheetCache alloc] initWithCacheDirectoryURL:cacheDirectoryURL];
+    [cache removeAllCachedStyleSheets];
+
+    InterfaCSS* interfaCSS = [InterfaCSS sharedInstance];
+    NSString* firstStyleSheetData = @"@parseCachePruneFirst: 0.1; .parseCachePruneFirst { alpha: @parseCachePruneFirst; }";
+    NSString* secondStyleSheetData = @"@parseCachePruneSecond: 0.2; .parseCachePruneSecond { alpha: @parseCachePruneSecond; }";
+
+    // Variables defined outside of the parsing (i.e. concurrently, on another thread) must not be recorded in the cached parse result
+    [cache declarationsForStyleSheetData:firstStyleSheetData parser:[[ConcurrentVariableDefiningParser alloc] init]];
+    XCTAssertEqual([self waitForCachedStyleSheetCount:1 inDirectory:cacheDirectoryURL], (NSUInteger)1);
+    NSURL* firstFile = [[[NSFileManager defaultManager] contentsOfDirectoryAtURL:cacheDirectoryURL includingPropertiesForKeys:nil options:0 error:nil] firstObject];
+    [interfaCSS setValue:nil forStyleSheetVariableWithName:@"parseCachePruneFirst"];
+    [interfaCSS setValue:nil forStyleSheetVariableWithName:@"parseCacheConcurrentVariable"];
+    NSArray* firstDeclarations = [ISSStyleSheetCompiler declarationsFromCompiledData:[NSData dataWithContentsOfURL:firstFile] parser:interfaCSS.parser];
+    XCTAssertEqual(firstDeclarations.count, (NSUInteger)1);
+    XCTAssertEqualObjects([interfaCSS valueOfStyleSheetVariableWithName:@"parseCachePruneFirst"], @"0.1");
+    XCTAssertNil([interfaCSS valueOfStyleSheetVariableWithName:@"parseCacheConcurrentVariable"]);
+
+    // Limit cache size to roughly one parse result - least recently used parse result should be pruned when the next one is written
+    NSNumber* fileSize = nil;
+    [firstFile getResourceValue:&fileSize forKey:NSURLFileSizeKey error:nil];
+    cache.maximumCacheSize = fileSize.unsignedLongLongValue + fileSize.unsignedLongLongValue / 2;
+    [cache declarationsForStyleSheetData:secondStyleSheetData parser:interfaCSS.parser];
+
+    NSArray* files = nil;
+    for(NSUInteger i=0; i<40; i++) {
+        files = [[NSFileManager defaultManager] contentsOfDirectoryAtURL:cacheDirectoryURL includingPropertiesForKeys:nil options:0 error:nil];
+        if( files.count == 1 && ![[files.firstObject lastPathComponent] isEqualToString:firstFile.lastPathComponent] ) break;
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+    }
+    XCTAssertEqual(files.count, (NSUInteger)1);
+    XCTAssertNotEqualObjects([files.firstObject lastPathComponent], firstFile.lastPathComponent);
+
+    [cache removeAllCachedStyleSheets];
+}
+
 @end
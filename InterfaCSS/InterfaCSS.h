@@ -28,6 +28,7 @@
 @protocol ISSStyleSheetParser;
 @class ISSViewPrototype;
 @class ISSPropertyRegistry;
+@class ISSStyleSheetCache;
 
 
 
@@ -120,6 +121,21 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (nonatomic) BOOL useManualStyling;
 
+/**
+ * Enables eager transformation of property values. If this property is set to `YES`, property values that can be transformed without a target element (i.e.
+ * all values except enums, images and relative rects and points) are transformed on a background queue as soon as a stylesheet has been loaded, instead of
+ * on the main thread the first time they are applied. Default value of this property is `NO`.
+ */
+@property (nonatomic) BOOL eagerlyTransformPropertyValues;
+
+/**
+ * The maximum time spent per run loop turn applying scheduled styling to elements that aren't currently visible. If this property is set to a value greater
+ * than `0`, scheduled styling is first applied only to visible elements (i.e. elements in a window, within the bounds of the window). Styling of the remaining
+ * elements is deferred, and then applied in time slices of this length across the following run loop turns. Deferred elements that are about to be
+ * displayed are always styled synchronously. Default value of this property is `0`, meaning that scheduled styling is applied to whole sub trees at once.
+ */
+@property (nonatomic) NSTimeInterval scheduledStylingTimeSlice;
+
 
 #pragma mark - Properties
 
@@ -138,6 +154,12 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (nonatomic, strong) id<ISSStyleSheetParser> parser;
 
+/**
+ * Persistent cache of stylesheet parse results, used when loading stylesheets that haven't been compiled at build time (including refreshable stylesheets).
+ * Default is a cache in `[ISSStyleSheetCache defaultCacheDirectoryURL]`. Set to `nil` to always parse stylesheets.
+ */
+@property (nonatomic, strong, nullable) ISSStyleSheetCache* styleSheetCache;
+
 
 #pragma mark - Styling
 
@@ -167,7 +189,8 @@ NS_ASSUME_NONNULL_BEGIN
 - (void) scheduleApplyStylingIfNeeded:(id)uiElement animated:(BOOL)animated force:(BOOL)force;
 
 /**
- * Schedules styling of the specified UI object.
+ * Schedules styling of the specified UI object. Scheduled styling is applied once per run loop turn (before any pending changes are committed to the screen),
+ * and only to the topmost scheduled elements, i.e. each scheduled sub tree is styled exactly once.
  */
 - (void) scheduleApplyStyling:(id)uiElement animated:(BOOL)animated force:(BOOL)force;
 
@@ -213,6 +236,34 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void) applyStylingIfScheduled:(id)uiElement;
 
+/**
+ * Resolves the styles of the specified UI object and all its children on background queues, i.e. performs selector matching, merging of declarations and
+ * transformation of property values, using a snapshot of the element hierarchy. The resolved styles are cached, which means that applying styling to the
+ * elements afterwards only involves setting property values. Styles that cannot be resolved from a snapshot (i.e. when scoped stylesheets or sibling
+ * combinators are used) are resolved on the main thread when styling is applied, as usual. The completion handler is invoked on the main thread.
+ */
+- (void) resolveStylesForUIElement:(id)uiElement completionHandler:(nullable void (^)(void))completionHandler;
+
+/**
+ * Resolves the styles of the specified UI object and all its children on background queues (see `resolveStylesForUIElement:completionHandler:`), and then
+ * applies styling on the main thread. The completion handler is invoked on the main thread when styling has been applied.
+ */
+- (void) applyStylingAsynchronously:(id)uiElement force:(BOOL)force completionHandler:(nullable void (^)(void))completionHandler;
+
+/**
+ * Prewarms the style caches for the specified UI object and all its children, before the element is added to `parent` (which may be `nil` if the element
+ * already has a parent). Styles are resolved in the same way as in `resolveStylesForUIElement:completionHandler:`, but work is only started when the main
+ * run loop is idle in the default mode (i.e. not while scrolling), and performed on a low priority queue. The completion handler is invoked on the main thread.
+ * Only the most recently prewarmed styles are retained, if not used by any element.
+ */
+- (void) prewarmStylesForUIElement:(id)uiElement inParent:(nullable id)parent completionHandler:(nullable void (^)(void))completionHandler;
+
+/**
+ * Prewarms the style caches for elements with the specified element style identity paths (see `-[ISSUIElementDetails elementStyleIdentityPath]`), for
+ * instance recorded during a previous run of the app. See `prewarmStylesForUIElement:inParent:completionHandler:` for details.
+ */
+- (void) prewarmStylesForIdentityPaths:(NSArray*)identityPaths completionHandler:(nullable void (^)(void))completionHandler;
+
 
 #pragma mark - Style classes
 
@@ -333,6 +384,28 @@ NS_ASSUME_NONNULL_BEGIN
 - (nullable ISSStyleSheet*) loadStyleSheetFromMainBundleFile:(NSString*)styleSheetFileName;
 - (nullable ISSStyleSheet*) loadStyleSheetFromMainBundleFile:(NSString*)styleSheetFileName withScope:(nullable ISSStyleSheetScope*)scope;
 
+/**
+ * Asynchronously loads a stylesheet from the main bundle. The stylesheet is read and parsed on a background queue, and then added (and styling refreshed)
+ * on the main thread, after which the completion handler is invoked, also on the main thread. Stylesheets loaded asynchronously are added in the order
+ * they were requested.
+ */
+- (void) loadStyleSheetFromMainBundleFile:(NSString*)styleSheetFileName withScope:(nullable ISSStyleSheetScope*)scope completionHandler:(nullable void (^)(ISSStyleSheet* _Nullable styleSheet))completionHandler;
+
+/**
+ * Asynchronously loads a stylesheet from a file URL.
+ * @see loadStyleSheetFromMainBundleFile:withScope:completionHandler:
+ */
+- (void) loadStyleSheetFromFileURL:(NSURL*)styleSheetFile withScope:(nullable ISSStyleSheetScope*)scope completionHandler:(nullable void (^)(ISSStyleSheet* _Nullable styleSheet))completionHandler;
+
+/**
+ * Asynchronously loads a batch of stylesheets from file URLs. Top level variable definitions are processed sequentially, in stylesheet order, after which the
+ * stylesheets are parsed concurrently (large stylesheets are also split at top level ruleset boundaries, and the chunks parsed concurrently). If a variable is
+ * redefined with a different value, or referenced before it is defined (within a stylesheet, or by an earlier stylesheet), the stylesheets are instead parsed
+ * sequentially. The loaded stylesheets are added in the specified order on the main thread,
+ * after which the completion handler is invoked (also on the main thread).
+ */
+- (void) loadStyleSheetsFromFileURLs:(NSArray*)styleSheetFiles withScope:(nullable ISSStyleSheetScope*)scope completionHandler:(nullable void (^)(NSArray* styleSheets))completionHandler;
+
 /**
  * Loads a stylesheet from an absolute file path.
  */
@@ -353,6 +426,16 @@ NS_ASSUME_NONNULL_BEGIN
 - (nullable ISSStyleSheet*) loadRefreshableStyleSheetFromLocalFile:(NSString*)styleSheetFilePath;
 - (nullable ISSStyleSheet*) loadRefreshableStyleSheetFromLocalFile:(NSString*)styleSheetFilePath withScope:(nullable ISSStyleSheetScope*)scope;
 
+/**
+ * Parses the specified stylesheet data using the current parser, or loads the previously cached parse result of the same data from `styleSheetCache`.
+ */
+- (nullable NSMutableArray*) parseStyleSheetData:(NSString*)styleSheetData;
+
+/**
+ * Parses the specified stylesheet data (see `parseStyleSheetData:`) on a background queue, and invokes the completion handler with the result on the main thread.
+ */
+- (void) parseStyleSheetData:(NSString*)styleSheetData completionHandler:(void (^)(NSMutableArray* _Nullable declarations))completionHandler;
+
 /** Reloads all (remote) refreshable stylesheets. If force is `YES`, stylesheets will be reloaded even if they haven't been modified. */
 - (void) reloadRefreshableStyleSheets:(BOOL)force;
 
@@ -410,6 +493,12 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (nullable UIView*) viewFromPrototypeWithName:(NSString*)prototypeName registeredInElement:(nullable id)registeredInElement prototypeParent:(nullable id)prototypeParent;
 
+/**
+ * Prewarms the style caches for views created from the specified prototype, when added to `parent`. See `prewarmStylesForUIElement:inParent:completionHandler:`
+ * for details. For table view cell prototypes, use `-[UITableView prewarmStylesForPrototypeCellWithIdentifierISS:]` instead.
+ */
+- (void) prewarmStylesForPrototype:(ISSViewPrototype*)prototype inParent:(nullable id)parent completionHandler:(nullable void (^)(void))completionHandler;
+
 
 #pragma mark - Variable access
 
@@ -10,6 +10,10 @@
 
 #import "ISSStyleSheetParser.h"
 #import "ISSDefaultStyleSheetParser.h"
+#import "ISSStyleSheetCompiler.h"
+#import "ISSStyleSheetCache.h"
+#import "ISSStyleSheetTokenizer.h"
+#import "ISSTransformedValueCache.h"
 #import "ISSPropertyDeclaration.h"
 #import "ISSViewPrototype.h"
 #import "ISSUIElementDetails.h"
@@ -19,6 +23,11 @@
 #import "ISSPropertyRegistry.h"
 #import "ISSRuntimeIntrospectionUtils.h"
 #import "ISSStylingContext.h"
+#import "ISSAncestorFilter.h"
+#import "ISSStyleClassSet.h"
+#import "ISSElementStyleIdentity.h"
+#import "ISSUIElementDetailsSnapshot.h"
+#import "ISSElementTraversal.h"
 
 
 typedef id (^ISSViewHierarchyVisitorBlock)(id viewObject, ISSUIElementDetails* elementDetails, BOOL* stop);
@@ -30,9 +39,20 @@ NSString* const ISSDidRefreshStyleSheetNotification = @"ISSDidRefreshStyleSheetN
 
 static InterfaCSS* singleton = nil;
 
+static const NSUInteger ISSMinimumStyleSheetChunkLength = 16 * 1024; // Minimum size of the chunks large stylesheets are split into when parsed concurrently
+
+static const CFIndex ISSScheduledStylingRunLoopObserverOrder = 1999000; // Just before the Core Animation commit observer (order 2000000)
+static const CFIndex ISSIdleRunLoopObserverOrder = 2100000; // After the Core Animation commit observer, i.e. when all work of the run loop turn is done
+
+static const NSUInteger ISSMaximumPrewarmedStyleIdentities = 1024; // Maximum number of prewarmed style identities retained (oldest are released first)
+
+static const void* const ISSStylingTraversalScope = &ISSStylingTraversalScope; // Scope of styling traversals (see ISSElementTraversal)
+
 // Private extension of ISSUIElementDetails
 @interface ISSUIElementDetailsInterfaCSS : ISSUIElementDetails
 @property (nonatomic) BOOL stylingScheduled;
+@property (nonatomic) BOOL scheduledStylingAnimated;
+@property (nonatomic) BOOL scheduledStylingForced;
 @end
 @implementation ISSUIElementDetailsInterfaCSS
 @end
@@ -46,7 +66,8 @@ static InterfaCSS* singleton = nil;
 
 @property (nonatomic, strong) NSMutableDictionary* styleSheetsVariables;
 
-@property (nonatomic, strong) NSMapTable* cachedStyleDeclarationsForElements; // Weak canonical element styling identity (NSString) -> NSMutableArray
+@property (nonatomic, strong) NSMapTable* cachedStyleDeclarationsForElements; // Weak interned element style identity (ISSElementStyleIdentity) -> NSMutableArray
+@property (nonatomic, strong) NSMapTable* cachedResolvedStylesForDeclarations; // Weak cached style declarations (NSMutableArray, in cachedStyleDeclarationsForElements) -> NSArray (merged and transformed ISSPropertyDeclaration objects)
 
 @property (nonatomic, strong) NSMutableDictionary* prototypes;
 
@@ -60,6 +81,14 @@ static InterfaCSS* singleton = nil;
 @implementation InterfaCSS {
     __nullable id<ISSStyleSheetParser> _parser;
     BOOL deviceIsRotating;
+    ISSAncestorFilter* _ancestorFilter; // Ancestors of the element currently being styled
+    dispatch_queue_t _styleSheetParsingQueue; // Serial queue used for asynchronous stylesheet loading and parsing (serial to preserve stylesheet order)
+    NSMutableOrderedSet* _scheduledStylingElements; // Elements (ISSUIElementDetailsInterfaCSS) with scheduled styling, flushed once per run loop turn
+    NSMutableOrderedSet* _deferredStylingElements; // Non-visible elements (ISSUIElementDetailsInterfaCSS) with deferred scheduled styling, styled in time slices
+    BOOL _deferStylingOfNonVisibleElements; // Set while applying time sliced scheduled styling
+    CFRunLoopObserverRef _scheduledStylingObserver;
+    NSUInteger _cachedStylesGeneration; // Incremented whenever all cached styles are cleared - used to discard stale results of background style resolution
+    NSMutableOrderedSet* _prewarmedStyleIdentities; // Strong references to the style identities of prewarmed styles (in the order they were prewarmed), since cachedStyleDeclarationsForElements only holds weak keys
 }
 
 
@@ -90,14 +119,18 @@ static void setupForInitialState(InterfaCSS* interfaCSS) {
     interfaCSS->_parser = nil;
 
     interfaCSS->_propertyRegistry = [[ISSPropertyRegistry alloc] init];
+    interfaCSS->_styleSheetCache = [[ISSStyleSheetCache alloc] initWithCacheDirectoryURL:[ISSStyleSheetCache defaultCacheDirectoryURL]];
 
     interfaCSS->_styleSheets = [[NSMutableArray alloc] init];
     interfaCSS->_styleSheetsVariables = [[NSMutableDictionary alloc] init];
 
     interfaCSS->_cachedStyleDeclarationsForElements = [NSMapTable weakToStrongObjectsMapTable];
+    interfaCSS->_cachedResolvedStylesForDeclarations = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsWeakMemory|NSPointerFunctionsObjectPointerPersonality valueOptions:NSPointerFunctionsStrongMemory];
     interfaCSS->_prototypes = [[NSMutableDictionary alloc] init];
 
     interfaCSS->_initializedWindows = [NSMapTable weakToStrongObjectsMapTable];
+
+    interfaCSS->_ancestorFilter = [[ISSAncestorFilter alloc] init];
 }
 
 + (void) clearResetAndUnload {
@@ -116,6 +149,18 @@ static void setupForInitialState(InterfaCSS* interfaCSS) {
     if( (self = [super init]) ) {
         setupForInitialState(self);
 
+        _styleSheetParsingQueue = dispatch_queue_create("InterfaCSS.styleSheetParsing", DISPATCH_QUEUE_SERIAL);
+
+        _scheduledStylingElements = [[NSMutableOrderedSet alloc] init];
+        _prewarmedStyleIdentities = [[NSMutableOrderedSet alloc] init];
+        _deferredStylingElements = [[NSMutableOrderedSet alloc] init];
+        __weak InterfaCSS* weakSelf = self;
+        _scheduledStylingObserver = CFRunLoopObserverCreateWithHandler(kCFAllocatorDefault, kCFRunLoopBeforeWaiting | kCFRunLoopExit, YES,
+                ISSScheduledStylingRunLoopObserverOrder, ^(CFRunLoopObserverRef observer, CFRunLoopActivity activity) {
+            [weakSelf applyScheduledStyling];
+        });
+        CFRunLoopAddObserver(CFRunLoopGetMain(), _scheduledStylingObserver, kCFRunLoopCommonModes);
+
         NSNotificationCenter* notificationCenter = [NSNotificationCenter defaultCenter];
         [notificationCenter addObserver:self selector:@selector(memoryWarning:) name:UIApplicationDidReceiveMemoryWarningNotification object:nil];
 #if TARGET_OS_TV == 0
@@ -134,10 +179,16 @@ static void setupForInitialState(InterfaCSS* interfaCSS) {
 #endif
     
     [[NSNotificationCenter defaultCenter] removeObserver:self];
+
+    if( _scheduledStylingObserver ) {
+        CFRunLoopObserverInvalidate(_scheduledStylingObserver);
+        CFRelease(_scheduledStylingObserver);
+    }
 }
 
 - (void) memoryWarning:(NSNotification*)notification {
     [self clearAllCachedStyles];
+    if( [_parser isKindOfClass:ISSDefaultStyleSheetParser.class] ) [((ISSDefaultStyleSheetParser*)_parser).transformedValueCache removeAllValues];
 }
 
 
@@ -210,9 +261,7 @@ static void setupForInitialState(InterfaCSS* interfaCSS) {
     return _parser;
 }
 
-- (ISSStyleSheet*) loadStyleSheetFromFileURL:(NSURL*)styleSheetFile withScope:(ISSStyleSheetScope*)scope {
-    ISSStyleSheet* styleSheet = nil;
-
+- (ISSStyleSheet*) loadedStyleSheetWithURL:(NSURL*)styleSheetFile scope:(ISSStyleSheetScope*)scope {
     for(ISSStyleSheet* existingStyleSheet in self.styleSheets) {
         if( [existingStyleSheet.styleSheetURL isEqual:styleSheetFile] ) {
             ISSLogDebug(@"Stylesheet %@ already loaded", styleSheetFile);
@@ -220,31 +269,346 @@ static void setupForInitialState(InterfaCSS* interfaCSS) {
             return existingStyleSheet;
         }
     }
-    
-    NSError* error = nil;
-    NSString* styleSheetData = [NSString stringWithContentsOfURL:styleSheetFile usedEncoding:nil error:&error];
+    return nil;
+}
+
+- (NSMutableArray*) declarationsFromStyleSheetFileURL:(NSURL*)styleSheetFile parser:(id<ISSStyleSheetParser>)parser cache:(ISSStyleSheetCache*)cache {
+    // Use compiled stylesheet, if available (and up to date)
+    NSTimeInterval t = [NSDate timeIntervalSinceReferenceDate];
+    NSMutableArray* declarations = [ISSStyleSheetCompiler loadCompiledStyleSheetForStyleSheetURL:styleSheetFile parser:parser];
+    if( declarations ) {
+        ISSLogDebug(@"Loaded compiled stylesheet '%@' in %f seconds", [styleSheetFile lastPathComponent], ([NSDate timeIntervalSinceReferenceDate] - t));
+    } else if( ![styleSheetFile.pathExtension isEqualToString:ISSCompiledStyleSheetFileExtension] ) {
+        NSError* error = nil;
+        NSString* styleSheetData = [NSString stringWithContentsOfURL:styleSheetFile usedEncoding:nil error:&error];
+
+        if( styleSheetData ) {
+            t = [NSDate timeIntervalSinceReferenceDate];
+            declarations = [self.class parseStyleSheetData:styleSheetData parser:parser cache:cache];
+            ISSLogDebug(@"Loaded stylesheet '%@' in %f seconds", [styleSheetFile lastPathComponent], ([NSDate timeIntervalSinceReferenceDate] - t));
+        } else {
+            ISSLogWarning(@"Error loading stylesheet data from '%@' - %@", styleSheetFile, error);
+        }
+    }
+    return declarations;
+}
 
-    if( styleSheetData ) {
+- (ISSStyleSheet*) addStyleSheetWithURL:(NSURL*)styleSheetFile declarations:(NSMutableArray*)declarations scope:(ISSStyleSheetScope*)scope {
+    ISSStyleSheet* styleSheet = [[ISSStyleSheet alloc] initWithStyleSheetURL:styleSheetFile declarations:declarations refreshable:NO scope:scope];
+    [self.styleSheets addObject:styleSheet];
+
+    [self refreshStylingForStyleSheet:styleSheet];
+
+    return styleSheet;
+}
+
+- (ISSStyleSheet*) loadStyleSheetFromFileURL:(NSURL*)styleSheetFile withScope:(ISSStyleSheetScope*)scope {
+    ISSStyleSheet* existingStyleSheet = [self loadedStyleSheetWithURL:styleSheetFile scope:scope];
+    if( existingStyleSheet ) return existingStyleSheet;
+
+    NSMutableArray* declarations = [self declarationsFromStyleSheetFileURL:styleSheetFile parser:self.parser cache:self.styleSheetCache];
+    if( declarations ) {
+        if( self.eagerlyTransformPropertyValues ) [self transformPropertyValuesInBackgroundForDeclarations:declarations];
+        return [self addStyleSheetWithURL:styleSheetFile declarations:declarations scope:scope];
+    }
+    else return nil;
+}
+
+- (void) loadStyleSheetFromFileURL:(NSURL*)styleSheetFile withScope:(ISSStyleSheetScope*)scope completionHandler:(void (^)(ISSStyleSheet* styleSheet))completionHandler {
+    [self loadStyleSheetsFromFileURLs:@[styleSheetFile] withScope:scope completionHandler:^(NSArray* styleSheets) {
+        if( completionHandler ) completionHandler(styleSheets.firstObject);
+    }];
+}
+
+- (void) loadStyleSheetsFromFileURLs:(NSArray*)styleSheetFiles withScope:(ISSStyleSheetScope*)scope completionHandler:(void (^)(NSArray* styleSheets))completionHandler {
+    NSMutableSet* loadedStyleSheetFiles = [NSMutableSet set];
+    for(ISSStyleSheet* styleSheet in self.styleSheets) {
+        if( styleSheet.styleSheetURL ) [loadedStyleSheetFiles addObject:styleSheet.styleSheetURL];
+    }
+
+    id<ISSStyleSheetParser> parser = self.parser;
+    ISSStyleSheetCache* cache = self.styleSheetCache;
+    BOOL eagerlyTransformPropertyValues = self.eagerlyTransformPropertyValues;
+    dispatch_async(_styleSheetParsingQueue, ^{
         NSTimeInterval t = [NSDate timeIntervalSinceReferenceDate];
-        NSMutableArray* declarations = [self.parser parse:styleSheetData];
-        ISSLogDebug(@"Loaded stylesheet '%@' in %f seconds", [styleSheetFile lastPathComponent], ([NSDate timeIntervalSinceReferenceDate] - t));
+        NSArray* declarationsForStyleSheets = [self declarationsFromStyleSheetFileURLs:styleSheetFiles skippingFileURLs:loadedStyleSheetFiles parser:parser cache:cache];
+        if( eagerlyTransformPropertyValues ) {
+            for(NSArray* declarations in declarationsForStyleSheets) {
+                if( declarations != (id)[NSNull null] ) [self.class transformPropertyValuesInDeclarations:declarations];
+            }
+        }
+        ISSLogDebug(@"Loaded %lu stylesheets in %f seconds", (unsigned long)styleSheetFiles.count, ([NSDate timeIntervalSinceReferenceDate] - t));
+
+        // Only publish the stylesheets (and refresh styling) on the main thread
+        dispatch_async(dispatch_get_main_queue(), ^{
+            NSMutableArray* styleSheets = [NSMutableArray array];
+            [styleSheetFiles enumerateObjectsUsingBlock:^(NSURL* styleSheetFile, NSUInteger i, BOOL* stop) {
+                ISSStyleSheet* styleSheet = [self loadedStyleSheetWithURL:styleSheetFile scope:scope]; // Stylesheet may have been loaded while parsing
+                NSMutableArray* declarations = declarationsForStyleSheets[i];
+                if( !styleSheet && declarations != (id)[NSNull null] ) styleSheet = [self addStyleSheetWithURL:styleSheetFile declarations:declarations scope:scope];
+                if( styleSheet ) [styleSheets addObject:styleSheet];
+            }];
+            if( completionHandler ) completionHandler(styleSheets);
+        });
+    });
+}
+
+- (NSArray*) declarationsFromStyleSheetFileURLs:(NSArray*)styleSheetFiles skippingFileURLs:(NSSet*)skippedStyleSheetFiles parser:(id<ISSStyleSheetParser>)parser cache:(ISSStyleSheetCache*)cache {
+    NSUInteger count = styleSheetFiles.count;
+    NSMutableArray* results = [NSMutableArray arrayWithCapacity:count];
+    NSMutableArray* styleSheetDatas = [NSMutableArray arrayWithCapacity:count];
+    for(NSUInteger i=0; i<count; i++) {
+        [results addObject:[NSNull null]];
+        [styleSheetDatas addObject:[NSNull null]];
+    }
 
+    // Custom parsers aren't necessarily thread safe, so concurrent parsing is only used with the default parser
+    BOOL parseConcurrently = [parser isKindOfClass:ISSDefaultStyleSheetParser.class];
+
+    // Sequential pre-pass, in stylesheet order: load compiled stylesheets, read stylesheet data and define all top level variables (applying the definitions of
+    // each stylesheet only after those of the preceding stylesheets), and collect all variable usages, in order
+    NSDictionary* initialVariables = [self styleSheetVariablesSnapshot];
+    NSDictionary* variables = initialVariables;
+    NSMutableArray* variableUsages = [NSMutableArray array]; // Usages of all stylesheets, in stylesheet order
+    for(NSUInteger i=0; i<count && parseConcurrently; i++) {
+        NSURL* styleSheetFile = styleSheetFiles[i];
+        if( [skippedStyleSheetFiles containsObject:styleSheetFile] ) continue;
+
+        __block NSMutableArray* declarations = nil;
+        NSArray* compiledVariableDefinitions = [self styleSheetVariableDefinitionsRecordedDuringBlock:^{
+            declarations = [ISSStyleSheetCompiler loadCompiledStyleSheetForStyleSheetURL:styleSheetFile parser:parser];
+        }];
         if( declarations ) {
-            styleSheet = [[ISSStyleSheet alloc] initWithStyleSheetURL:styleSheetFile declarations:declarations refreshable:NO scope:scope];
-            [self.styleSheets addObject:styleSheet];
+            results[i] = declarations;
+            for(NSArray* definition in compiledVariableDefinitions) [variableUsages addObject:@[definition[0], @YES]];
+        } else if( ![styleSheetFile.pathExtension isEqualToString:ISSCompiledStyleSheetFileExtension] ) {
+            NSError* error = nil;
+            NSString* styleSheetData = [NSString stringWithContentsOfURL:styleSheetFile usedEncoding:nil error:&error];
+            if( styleSheetData ) {
+                styleSheetDatas[i] = styleSheetData;
+
+                NSMutableArray* variableDefinitions = [NSMutableArray array];
+                [ISSStyleSheetTokenizer splitStyleSheet:styleSheetData intoChunksOfLength:NSUIntegerMax variableDefinitions:variableDefinitions variableUsages:variableUsages];
+                NSMutableDictionary* definitionStatements = [NSMutableDictionary dictionary];
+                NSMutableString* variableDefinitionsData = [NSMutableString string];
+                for(NSArray* definition in variableDefinitions) {
+                    if( definitionStatements[definition[0]] && ![definitionStatements[definition[0]] isEqualToString:definition[1]] ) parseConcurrently = NO; // Variable redefined in stylesheet
+                    definitionStatements[definition[0]] = definition[1];
+                    [variableDefinitionsData appendFormat:@"%@\n", definition[1]];
+                }
+                if( variableDefinitionsData.length ) [parser parse:variableDefinitionsData];
+            } else {
+                ISSLogWarning(@"Error loading stylesheet data from '%@' - %@", styleSheetFile, error);
+            }
+        }
 
-            [self refreshStylingForStyleSheet:styleSheet];
+        // If a variable is redefined with a different value, it may have been referenced before it was redefined - parse sequentially in that case
+        NSDictionary* currentVariables = [self styleSheetVariablesSnapshot];
+        for(NSString* name in currentVariables) {
+            if( variables[name] && ![variables[name] isEqualToString:currentVariables[name]] ) parseConcurrently = NO;
         }
+        variables = currentVariables;
+    }
+
+    // When parsing concurrently, all variables defined by the batch are in effect from the start - which only gives the same result as sequential parsing if no
+    // variable is referenced before it is defined (within the same stylesheet, or by a later stylesheet), unless its value was the same before the batch
+    NSMutableSet* definedVariables = [NSMutableSet set];
+    for(NSArray* usage in variableUsages) {
+        if( !parseConcurrently ) break;
+        NSString* name = usage[0];
+        if( [usage[1] boolValue] ) {
+            [definedVariables addObject:name];
+        } else if( ![definedVariables containsObject:name] && variables[name] && ![variables[name] isEqualToString:initialVariables[name] ?: @""] ) {
+            ISSLogDebug(@"Variable '%@' referenced before it is defined - loading stylesheets sequentially", name);
+            parseConcurrently = NO;
+        }
+    }
+
+    if( parseConcurrently ) {
+        // Parse stylesheets (and chunks of large stylesheets) concurrently
+        dispatch_apply(count, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+            NSString* styleSheetData = styleSheetDatas[i];
+            if( styleSheetData == (id)[NSNull null] ) return;
+            NSMutableArray* declarations = [self.class parseStyleSheetDataConcurrently:styleSheetData parser:parser cache:cache];
+            @synchronized(results) {
+                results[i] = declarations ?: [NSNull null];
+            }
+        });
     } else {
-        ISSLogWarning(@"Error loading stylesheet data from '%@' - %@", styleSheetFile, error);
+        // Restore the variables defined before the pre-pass (if any), and load all stylesheets sequentially
+        for(NSString* name in [self styleSheetVariablesSnapshot]) {
+            [self setValue:initialVariables[name] forStyleSheetVariableWithName:name];
+        }
+        for(NSUInteger i=0; i<count; i++) {
+            NSURL* styleSheetFile = styleSheetFiles[i];
+            if( [skippedStyleSheetFiles containsObject:styleSheetFile] ) continue;
+            results[i] = [self declarationsFromStyleSheetFileURL:styleSheetFile parser:parser cache:cache] ?: [NSNull null];
+        }
     }
 
-    return styleSheet;
+    return results;
+}
+
++ (NSMutableArray*) parseStyleSheetDataConcurrently:(NSString*)styleSheetData parser:(id<ISSStyleSheetParser>)parser cache:(ISSStyleSheetCache*)cache {
+    NSUInteger chunkLength = MAX(ISSMinimumStyleSheetChunkLength, styleSheetData.length / [NSProcessInfo processInfo].activeProcessorCount);
+    NSArray* chunks = styleSheetData.length >= 2 * ISSMinimumStyleSheetChunkLength ?
+        [ISSStyleSheetTokenizer splitStyleSheet:styleSheetData intoChunksOfLength:chunkLength variableDefinitions:nil] : nil;
+    if( chunks.count < 2 ) return [self parseStyleSheetData:styleSheetData parser:parser cache:cache];
+
+    // Parse chunks concurrently, and stitch the declarations back together in the original order
+    NSMutableArray* chunkResults = [NSMutableArray arrayWithCapacity:chunks.count];
+    for(NSUInteger i=0; i<chunks.count; i++) [chunkResults addObject:[NSNull null]];
+    dispatch_apply(chunks.count, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+        NSMutableArray* declarations = [self parseStyleSheetData:chunks[i] parser:parser cache:cache];
+        @synchronized(chunkResults) {
+            chunkResults[i] = declarations ?: [NSNull null];
+        }
+    });
+
+    NSMutableArray* declarations = nil;
+    for(NSMutableArray* chunkDeclarations in chunkResults) {
+        if( chunkDeclarations == (id)[NSNull null] ) continue;
+        if( !declarations ) declarations = [NSMutableArray array];
+        [declarations addObjectsFromArray:chunkDeclarations];
+    }
+    return declarations;
+}
+
+
+#pragma mark - Eager property value transformation
+
++ (NSArray*) eagerlyTransformablePropertyDeclarationsInDeclarations:(NSArray*)declarations {
+    NSHashTable* propertyDeclarations = [[NSHashTable alloc] initWithOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality capacity:declarations.count];
+    for(ISSPropertyDeclarations* ruleset in declarations) {
+        for(ISSPropertyDeclaration* decl in ruleset.properties) {
+            if( decl.canTransformValueEagerly ) [propertyDeclarations addObject:decl];
+        }
+    }
+    return propertyDeclarations.allObjects;
+}
+
+/*
+ * Concurrently transforms the property values in declarations that haven't been published yet (i.e. while still on the stylesheet parsing queue).
+ */
++ (void) transformPropertyValuesInDeclarations:(NSArray*)declarations {
+    NSTimeInterval t = [NSDate timeIntervalSinceReferenceDate];
+    NSArray* propertyDeclarations = [self eagerlyTransformablePropertyDeclarationsInDeclarations:declarations];
+    dispatch_apply(propertyDeclarations.count, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+        [propertyDeclarations[i] transformValueIfNeeded];
+    });
+    ISSLogTrace(@"Transformed %lu property values in %f seconds", (unsigned long)propertyDeclarations.count, ([NSDate timeIntervalSinceReferenceDate] - t));
+}
+
+/*
+ * Transforms the property values in declarations that may already be in use on a background queue, and sets the transformed values on the main thread (unless
+ * already transformed lazily in the meantime).
+ */
+- (void) transformPropertyValuesInBackgroundForDeclarations:(NSArray*)declarations {
+    [self transformPropertyValuesInBackgroundForDeclarations:declarations completionHandler:nil];
+}
+
+- (void) transformPropertyValuesInBackgroundForDeclarations:(NSArray*)declarations completionHandler:(void (^)(void))completionHandler {
+    NSArray* propertyDeclarations = [self.class eagerlyTransformablePropertyDeclarationsInDeclarations:declarations];
+    if( propertyDeclarations.count == 0 ) {
+        if( completionHandler ) completionHandler();
+        return;
+    }
+
+    NSMutableArray* transformationBlocks = [NSMutableArray arrayWithCapacity:propertyDeclarations.count];
+    for(ISSPropertyDeclaration* decl in propertyDeclarations) {
+        [transformationBlocks addObject:decl.lazyPropertyTransformationBlock];
+    }
+
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        NSMutableArray* transformedValues = [NSMutableArray arrayWithCapacity:propertyDeclarations.count];
+        for(NSUInteger i=0; i<propertyDeclarations.count; i++) [transformedValues addObject:[NSNull null]];
+
+        dispatch_apply(propertyDeclarations.count, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+            ISSLazyValueBlock transformationBlock = transformationBlocks[i];
+            id value = transformationBlock(propertyDeclarations[i]);
+            if( value ) {
+                @synchronized(transformedValues) {
+                    transformedValues[i] = value;
+                }
+            }
+        });
+
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [propertyDeclarations enumerateObjectsUsingBlock:^(ISSPropertyDeclaration* decl, NSUInteger i, BOOL* stop) {
+                if( decl.lazyPropertyTransformationBlock == transformationBlocks[i] && transformedValues[i] != [NSNull null] ) {
+                    decl.propertyValue = transformedValues[i];
+                    decl.lazyPropertyTransformationBlock = nil;
+                }
+            }];
+            if( completionHandler ) completionHandler();
+        });
+    });
 }
 
 
 #pragma mark - Styling - Style matching and application
 
+/**
+ * Finds all matching (or potentially matching, i.e. pseudo class) style declarations for the element in the specified stylesheets, sorted on selector
+ * specificity if enabled.
+ */
+- (NSMutableArray*) declarationsMatchingElement:(ISSUIElementDetails*)elementDetails inStyleSheets:(NSArray*)styleSheets stylingContext:(ISSStylingContext*)stylingContext {
+    NSMutableArray* matchingDeclarations = [[NSMutableArray alloc] init];
+    for (ISSStyleSheet* styleSheet in styleSheets) {
+        NSArray* styleSheetDeclarations = [styleSheet declarationsMatchingElement:elementDetails stylingContext:stylingContext];
+        if ( styleSheetDeclarations ) {
+            // We need to add scope along with declarations, otherwise the scope check won't be used below...
+            for(ISSPropertyDeclarations* declarations in styleSheetDeclarations) {
+                if( declarations.scope != styleSheet.scope ) declarations.scope = styleSheet.scope;
+
+                // Get reference to inherited declarations, if any:
+                if ( declarations.extendedDeclarationSelectorChain && !declarations.extendedDeclaration ) {
+                    [self resolveExtendedDeclarationForDeclarations:declarations inStyleSheets:styleSheets];
+                }
+            }
+            [matchingDeclarations addObjectsFromArray:styleSheetDeclarations];
+        }
+    }
+
+    return [self sortDeclarationsOnSpecificityIfEnabled:matchingDeclarations];
+}
+
+/**
+ * Finds all matching style declarations for an element snapshot in the specified rule indices (see `ruleIndicesForBackgroundStyleResolution:nestedElementKeyPaths:`).
+ * Invoked off the main thread - only the (immutable) rule indices captured on the main thread are used, never the stylesheets themselves.
+ */
+- (NSMutableArray*) declarationsMatchingSnapshot:(ISSUIElementDetailsSnapshot*)snapshot inRuleIndices:(NSArray*)ruleIndices stylingContext:(ISSStylingContext*)stylingContext {
+    NSMutableArray* matchingDeclarations = [[NSMutableArray alloc] init];
+    for(ISSStyleSheetRuleIndex* ruleIndex in ruleIndices) {
+        [matchingDeclarations addObjectsFromArray:[ruleIndex declarationsMatchingElement:snapshot stylingContext:stylingContext]];
+    }
+    return [self sortDeclarationsOnSpecificityIfEnabled:matchingDeclarations];
+}
+
+- (NSMutableArray*) sortDeclarationsOnSpecificityIfEnabled:(NSMutableArray*)matchingDeclarations {
+    // If selector specificity is enabled...
+    if( self.useSelectorSpecificity ) {
+        // ...sort declarations on specificity
+        [matchingDeclarations sortWithOptions:NSSortStable usingComparator:^NSComparisonResult(ISSPropertyDeclarations* ruleset1, ISSPropertyDeclarations* ruleset2) {
+            if ( ruleset1.specificity > ruleset2.specificity ) return NSOrderedDescending;
+            if ( ruleset1.specificity < ruleset2.specificity ) return NSOrderedAscending;
+            return NSOrderedSame;
+        }];
+    }
+
+    return matchingDeclarations;
+}
+
+- (void) resolveExtendedDeclarationForDeclarations:(ISSPropertyDeclarations*)declarations inStyleSheets:(NSArray*)styleSheets {
+    for (ISSStyleSheet* s in styleSheets) {
+        ISSPropertyDeclarations* extendedDeclaration = [s findPropertyDeclarationsWithSelectorChain:declarations.extendedDeclarationSelectorChain];
+        if (extendedDeclaration) {
+            declarations.extendedDeclaration = extendedDeclaration;
+            break;
+        }
+    }
+}
+
 - (NSArray*) effectiveStylesForUIElement:(ISSUIElementDetails*)elementDetails force:(BOOL)force {
     // First - get cached declarations stored using weak reference on ISSUIElementDetails object
     NSMutableArray* cachedDeclarations = elementDetails.cachedDeclarations;
@@ -252,52 +616,22 @@ static void setupForInitialState(InterfaCSS* interfaCSS) {
     // If not found - get cached declarations that matches element style identity (i.e. unique hierarchy/path of classes and style classes)
     // This makes it possible to reuse identical style information in sibling elements for instance.
     if( !cachedDeclarations ) {
-        cachedDeclarations = [self.cachedStyleDeclarationsForElements objectForKey:elementDetails.elementStyleIdentityPath];
+        cachedDeclarations = [self.cachedStyleDeclarationsForElements objectForKey:elementDetails.styleIdentity];
         elementDetails.cachedDeclarations = cachedDeclarations;
     }
     
     if ( !cachedDeclarations ) {
-        ISSLogTrace(@"FULL stylesheet scan for '%@'", elementDetails.elementStyleIdentityPath);
+        ISSLogTrace(@"FULL stylesheet scan for '%@'", elementDetails.styleIdentity);
 
         elementDetails.stylingApplied = NO; // Reset 'stylingApplied' flag if declaration cache has been cleared, to make sure element is re-styled
 
-        // Otherwise - build styles
-        cachedDeclarations = [[NSMutableArray alloc] init];
-        
-        // Perform full stylesheet scan to get matching style classes, but ignore pseudo classes at this stage
+        // Otherwise - build styles by performing a full stylesheet scan to get matching style classes, but ignore pseudo classes at this stage
         ISSStylingContext* stylingContext = [ISSStylingContext contextIgnoringPseudoClasses];
-        for (ISSStyleSheet* styleSheet in self.effectiveStylesheets) {
-            // Find all matching (or potentially matching, i.e. pseudo class) style declarations
-            NSArray* styleSheetDeclarations = [styleSheet declarationsMatchingElement:elementDetails stylingContext:stylingContext];
-            if ( styleSheetDeclarations ) {
-                // We need to add scope along with declarations, otherwise the scope check won't be used below...
-                for(ISSPropertyDeclarations* declarations in styleSheetDeclarations) {
-                    declarations.scope = styleSheet.scope;
-
-                    // Get reference to inherited declarations, if any:
-                    if ( declarations.extendedDeclarationSelectorChain && !declarations.extendedDeclaration ) {
-                        for (ISSStyleSheet* s in self.effectiveStylesheets) {
-                            declarations.extendedDeclaration = [s findPropertyDeclarationsWithSelectorChain:declarations.extendedDeclarationSelectorChain];
-                            if (declarations.extendedDeclaration) break;
-                        }
-                    }
-                }
-                [cachedDeclarations addObjectsFromArray:styleSheetDeclarations];
-            }
-        }
+        if( [_ancestorFilter isValidForElement:elementDetails] ) stylingContext.ancestorFilter = _ancestorFilter;
+        cachedDeclarations = [self declarationsMatchingElement:elementDetails inStyleSheets:self.effectiveStylesheets stylingContext:stylingContext];
         
-        if( stylingContext.containsPartiallyMatchedDeclarations ) ISSLogTrace(@"Found %d matching declarations, and at least one partially matching declaration, for '%@'.", cachedDeclarations.count, elementDetails.elementStyleIdentityPath);
-        else ISSLogTrace(@"Found %d matching declarations for '%@'", cachedDeclarations.count, elementDetails.elementStyleIdentityPath);
-        
-        // If selector specificity is enabled...
-        if( self.useSelectorSpecificity ) {
-            // ...sort declarations on specificity
-            [cachedDeclarations sortWithOptions:NSSortStable usingComparator:^NSComparisonResult(ISSPropertyDeclarations* ruleset1, ISSPropertyDeclarations* ruleset2) {
-                if ( ruleset1.specificity > ruleset2.specificity ) return NSOrderedDescending;
-                if ( ruleset1.specificity < ruleset2.specificity ) return NSOrderedAscending;
-                return NSOrderedSame;
-            }];
-        }
+        if( stylingContext.containsPartiallyMatchedDeclarations ) ISSLogTrace(@"Found %d matching declarations, and at least one partially matching declaration, for '%@'.", cachedDeclarations.count, elementDetails.styleIdentity);
+        else ISSLogTrace(@"Found %d matching declarations for '%@'", cachedDeclarations.count, elementDetails.styleIdentity);
         
         // If there are no style declarations that only partially matches the element - consider the styles fully resolved for the element
         elementDetails.stylesFullyResolved = !stylingContext.containsPartiallyMatchedDeclarations;
@@ -305,37 +639,76 @@ static void setupForInitialState(InterfaCSS* interfaCSS) {
         // Only add declarations to cache if styles are cacheable for element (i.e. either added to window, or part of a view hierachy that has an root element with an element Id), or,
         // if there were no styles that would match if the element was placed under a different parent (i.e. partial matches)
         if( elementDetails.stylesCacheable || elementDetails.stylesFullyResolved ) {
-            [self.cachedStyleDeclarationsForElements setObject:cachedDeclarations forKey:elementDetails.elementStyleIdentityPath];
+            [self.cachedStyleDeclarationsForElements setObject:cachedDeclarations forKey:elementDetails.styleIdentity];
             elementDetails.cachedDeclarations = cachedDeclarations;
         } else {
-            ISSLogTrace(@"Can NOT cache styles for '%@'", elementDetails.elementStyleIdentityPath);
+            ISSLogTrace(@"Can NOT cache styles for '%@'", elementDetails.styleIdentity);
         }
     } else {
-        ISSLogTrace(@"Cached declarations exists for '%@'", elementDetails.elementStyleIdentityPath);
+        ISSLogTrace(@"Cached declarations exists for '%@'", elementDetails.styleIdentity);
     }
 
     if( !force && elementDetails.stylingAppliedAndStatic ) { // Current styling information has already been applied, and declarations contain no pseudo classes
-        ISSLogTrace(@"Styles aleady applied for '%@'", elementDetails.elementStyleIdentityPath);
+        ISSLogTrace(@"Styles aleady applied for '%@'", elementDetails.styleIdentity);
         return nil;
     } else { // Styling information has not been applied, or declarations contains pseudo classes (in which case we need to re-evaluate the styles every time styling is initiated), or is forced
-        ISSLogTrace(@"Processing style declarations for '%@'", elementDetails.elementStyleIdentityPath);
+        ISSLogTrace(@"Processing style declarations for '%@'", elementDetails.styleIdentity);
         
+        // If declarations contain no pseudo classes, the merged styles can be reused as long as the cached declarations remain the same
+        if( elementDetails.cachedEffectiveStyles && elementDetails.cachedDeclarations == cachedDeclarations ) {
+            ISSLogTrace(@"Using cached effective styles for '%@'", elementDetails.styleIdentity);
+            if( elementDetails.stylesCacheable || elementDetails.stylesFullyResolved ) elementDetails.stylingApplied = YES;
+            return elementDetails.cachedEffectiveStyles;
+        }
+
+        // If the styles for the element style identity are fully static, they may already have been resolved (i.e. merged and transformed) by another element with the same identity
+        BOOL cachedForStyleIdentity = cachedDeclarations && elementDetails.cachedDeclarations == cachedDeclarations;
+        NSArray* resolvedStyles = cachedForStyleIdentity ? [self.cachedResolvedStylesForDeclarations objectForKey:cachedDeclarations] : nil;
+        if( resolvedStyles ) {
+            ISSLogTrace(@"Using resolved styles for '%@'", elementDetails.styleIdentity);
+            elementDetails.stylesContainPseudoClassesOrDynamicProperties = NO;
+            elementDetails.cachedEffectiveStyles = resolvedStyles;
+            if( elementDetails.stylesCacheable || elementDetails.stylesFullyResolved ) elementDetails.stylingApplied = YES;
+            return resolvedStyles;
+        }
+
         // Process declarations to see which styles currently match
+        BOOL hasPseudoClass = NO;
         BOOL hasPseudoClassOrDynamicProperty = NO;
+        BOOL hasScope = NO;
         ISSStylingContext* stylingContext = [[ISSStylingContext alloc] init];
-        NSMutableArray* viewStyles = [[NSMutableArray alloc] init];
+        if( [_ancestorFilter isValidForElement:elementDetails] ) stylingContext.ancestorFilter = _ancestorFilter;
+        NSMutableArray* matchingProperties = [[NSMutableArray alloc] init];
         for (ISSPropertyDeclarations* declarations in cachedDeclarations) {
+            hasScope = hasScope || declarations.scope != nil;
             // Verify that element is in scope:
             if ( declarations.scope != nil && ![declarations.scope elementInScope:elementDetails] ) {
                 continue;
             }
             // Add styles if declarations doesn't contain pseudo selector, or if matching against pseudo class selector is successful
             if ( !declarations.containsPseudoClassSelector || [declarations matchesElement:elementDetails stylingContext:stylingContext] ) {
-                [viewStyles iss_addAndReplaceUniqueObjectsInArray:declarations.properties];
+                [matchingProperties addObject:declarations.properties];
             }
 
+            hasPseudoClass = hasPseudoClass || declarations.containsPseudoClassSelector;
             hasPseudoClassOrDynamicProperty = hasPseudoClassOrDynamicProperty || declarations.containsPseudoClassSelectorOrDynamicProperties;
         }
+
+        // Merge properties (last declaration of a property wins)
+        NSMutableArray* viewStyles = [[NSMutableArray alloc] init];
+        [viewStyles iss_addAndReplaceUniqueObjectsInArrays:matchingProperties];
+        if( cachedForStyleIdentity && !hasScope && !hasPseudoClassOrDynamicProperty ) {
+            // Styles are fully determined by the element style identity - transform values up front and share the resolved styles between all elements with the same identity
+            for(ISSPropertyDeclaration* propertyDeclaration in viewStyles) {
+                [propertyDeclaration transformValueIfNeeded];
+            }
+            resolvedStyles = [viewStyles copy];
+            [self.cachedResolvedStylesForDeclarations setObject:resolvedStyles forKey:cachedDeclarations];
+            elementDetails.cachedEffectiveStyles = resolvedStyles;
+        } else if( !hasPseudoClass && cachedForStyleIdentity ) {
+            elementDetails.cachedEffectiveStyles = [viewStyles copy];
+        }
+
         elementDetails.stylesContainPseudoClassesOrDynamicProperties = hasPseudoClassOrDynamicProperty; // Record in elementDetails if declarations contain pseudo classes or dynamic properties
 
         // Set 'stylingApplied' flag to indicate that styles have been fully applied, but only if element is part of a defined view
@@ -343,7 +716,7 @@ static void setupForInitialState(InterfaCSS* interfaCSS) {
         if( elementDetails.stylesCacheable || elementDetails.stylesFullyResolved ) {
             elementDetails.stylingApplied = YES;
         } else {
-            ISSLogTrace(@"Cannot mark element '%@' as styled", elementDetails.elementStyleIdentityPath);
+            ISSLogTrace(@"Cannot mark element '%@' as styled", elementDetails.styleIdentity);
         }
 
         return viewStyles;
@@ -358,11 +731,16 @@ static void setupForInitialState(InterfaCSS* interfaCSS) {
             styles = elementDetails.willApplyStylingBlock(styles);
         }
 
+        // Forget values of properties that are no longer part of the styles, so that they will be applied again if they should reappear
+        [elementDetails retainLastAppliedValuesForProperties:styles];
+
         for (ISSPropertyDeclaration* propertyDeclaration in styles) {
             if( [elementDetails.disabledProperties containsObject:propertyDeclaration.property] ) {
                 ISSLogTrace(@"Skipping setting of %@ - property disabled on %@", propertyDeclaration, elementDetails.uiElement);
+                [elementDetails setLastAppliedValue:nil forProperty:propertyDeclaration];
             } else {
-                [propertyDeclaration applyPropertyValueOnTarget:elementDetails];
+                // Unless forced, only apply properties whose values have changed since they were last applied
+                [propertyDeclaration applyPropertyValueOnTarget:elementDetails onlyIfChanged:!force];
             }
         }
 
@@ -373,6 +751,264 @@ static void setupForInitialState(InterfaCSS* interfaCSS) {
 }
 
 
+#pragma mark - Styling - Background style resolution
+
+/*
+ * Styles are resolved in the background using snapshots (ISSUIElementDetailsSnapshot) of the elements - one for each element style identity that isn't
+ * already cached. The matching declarations (and, if fully determined by the style identity, the merged styles) are then added to the style caches on the
+ * main thread, so that styles don't have to be resolved again when styling is applied.
+ */
+
+- (ISSUIElementDetailsSnapshot*) snapshotForUIElement:(id)uiElement snapshots:(NSMapTable*)snapshots nestedElementKeyPaths:(NSSet*)nestedElementKeyPaths {
+    if( !uiElement ) return nil;
+
+    ISSUIElementDetailsSnapshot* snapshot = [snapshots objectForKey:uiElement];
+    if( !snapshot ) {
+        ISSUIElementDetails* elementDetails = [self detailsForUIElement:uiElement];
+        snapshot = [[ISSUIElementDetailsSnapshot alloc] initWithElementDetails:elementDetails];
+        [snapshots setObject:snapshot forKey:uiElement];
+
+        id parentElement = elementDetails.parentElement;
+        id ownerElement = elementDetails.ownerElement;
+        snapshot.parentSnapshot = [self snapshotForUIElement:parentElement snapshots:snapshots nestedElementKeyPaths:nestedElementKeyPaths];
+        if( ownerElement == parentElement ) snapshot.ownerSnapshot = snapshot.parentSnapshot;
+        else snapshot.ownerSnapshot = [self snapshotForUIElement:ownerElement snapshots:snapshots nestedElementKeyPaths:nestedElementKeyPaths];
+
+        // Record by which of the nested element key paths used in the stylesheets the element is known in its owner element (see ISSNestedElementSelector)
+        if( ownerElement && nestedElementKeyPaths.count ) {
+            NSDictionary* validNestedElements = [self detailsForUIElement:ownerElement].validNestedElements;
+            NSMutableSet* keyPaths = nil;
+            for(NSString* nestedElementKeyPath in nestedElementKeyPaths) {
+                NSString* validKeyPath = validNestedElements[nestedElementKeyPath];
+                if( validKeyPath && [ownerElement valueForKey:validKeyPath] == uiElement ) {
+                    if( !keyPaths ) keyPaths = [NSMutableSet set];
+                    [keyPaths addObject:nestedElementKeyPath];
+                }
+            }
+            snapshot.nestedElementKeyPaths = keyPaths;
+        }
+    }
+    return snapshot;
+}
+
+- (void) addSnapshotsForUIElement:(id)uiElement snapshots:(NSMapTable*)snapshots nestedElementKeyPaths:(NSSet*)nestedElementKeyPaths
+                 unresolvedSnapshots:(NSMutableArray*)unresolvedSnapshots unresolvedStyleIdentities:(NSHashTable*)unresolvedStyleIdentities {
+    ISSUIElementDetails* elementDetails = [self detailsForUIElement:uiElement];
+    if( elementDetails.stylingAppliedAndDisabled ) return;
+
+    // Update element details in the same way as when styling is applied, to make sure the style identity is up to date
+    [elementDetails checkForUpdatedParentElement];
+    if ( elementDetails.cachedStylingInformationDirty ) {
+        [self clearCachedInformationForUIElementDetails:elementDetails];
+        elementDetails.cachedStylingInformationDirty = NO;
+    }
+
+    ISSUIElementDetailsSnapshot* snapshot = [self snapshotForUIElement:uiElement snapshots:snapshots nestedElementKeyPaths:nestedElementKeyPaths];
+    ISSElementStyleIdentity* styleIdentity = snapshot.styleIdentity;
+    if( styleIdentity && ![unresolvedStyleIdentities containsObject:styleIdentity] && ![self.cachedStyleDeclarationsForElements objectForKey:styleIdentity] ) {
+        [unresolvedStyleIdentities addObject:styleIdentity];
+        [unresolvedSnapshots addObject:snapshot];
+    }
+
+    for(id childElement in elementDetails.childElementsForElement) {
+        [self addSnapshotsForUIElement:childElement snapshots:snapshots nestedElementKeyPaths:nestedElementKeyPaths unresolvedSnapshots:unresolvedSnapshots
+                unresolvedStyleIdentities:unresolvedStyleIdentities];
+    }
+}
+
+/*
+ * Resolves the styles of an element snapshot - invoked on a background queue.
+ */
+- (void) resolveStylesForSnapshot:(ISSUIElementDetailsSnapshot*)snapshot inRuleIndices:(NSArray*)ruleIndices {
+    ISSStylingContext* stylingContext = [ISSStylingContext contextIgnoringPseudoClasses];
+    stylingContext.snapshotMatching = YES;
+    NSMutableArray* declarations = [self declarationsMatchingSnapshot:snapshot inRuleIndices:ruleIndices stylingContext:stylingContext];
+    if( stylingContext.containsDeclarationsRequiringUIElement ) {
+        ISSLogTrace(@"Styles for '%@' can only be resolved using actual UI element", snapshot.styleIdentity);
+        return;
+    }
+
+    // Only cache declarations if they would be cached on the main thread (see effectiveStylesForUIElement:force:)
+    snapshot.stylesFullyResolved = !stylingContext.containsPartiallyMatchedDeclarations;
+    if( !snapshot.stylesCacheable && !snapshot.stylesFullyResolved ) return;
+    snapshot.resolvedDeclarations = declarations;
+
+    // If styles are fully determined by the element style identity (i.e. no pseudo classes or dynamic properties), the merged styles can be shared between all elements with the same identity
+    NSMutableArray* matchingProperties = [[NSMutableArray alloc] init];
+    for (ISSPropertyDeclarations* propertyDeclarations in declarations) {
+        if( propertyDeclarations.scope || propertyDeclarations.containsPseudoClassSelectorOrDynamicProperties ) return;
+        [matchingProperties addObject:propertyDeclarations.properties];
+    }
+    NSMutableArray* styles = [[NSMutableArray alloc] init];
+    [styles iss_addAndReplaceUniqueObjectsInArrays:matchingProperties];
+    snapshot.resolvedStyles = [styles copy];
+}
+
+/*
+ * Prepares the stylesheets for selector matching in the background, and collects the nested element key paths used in them. Returns the current rule
+ * indices (i.e. immutable snapshots of the declarations and rule index) of the stylesheets, which are used for matching in the background, since the
+ * declarations of a stylesheet may be replaced (on the main thread) at any time. Returns nil if the stylesheets cannot be matched using snapshots.
+ */
+- (NSArray*) ruleIndicesForBackgroundStyleResolution:(NSArray*)styleSheets nestedElementKeyPaths:(NSMutableSet*)nestedElementKeyPaths {
+    NSMutableArray* ruleIndices = [NSMutableArray array];
+    for(ISSStyleSheet* styleSheet in styleSheets) {
+        if( styleSheet.scope ) return nil; // Scopes can only be evaluated using actual UI elements
+        ISSStyleSheetRuleIndex* ruleIndex = styleSheet.ruleIndex;
+        [ruleIndices addObject:ruleIndex];
+        [nestedElementKeyPaths unionSet:ruleIndex.nestedElementKeyPaths];
+
+        // Make sure all references to extended declarations are resolved (and no stale scopes remain) before matching in the background
+        for(ISSPropertyDeclarations* declarations in ruleIndex.declarations) {
+            if( declarations.scope ) declarations.scope = nil;
+            if ( declarations.extendedDeclarationSelectorChain && !declarations.extendedDeclaration ) {
+                [self resolveExtendedDeclarationForDeclarations:declarations inStyleSheets:styleSheets];
+            }
+        }
+    }
+    return ruleIndices;
+}
+
+/*
+ * Resolves the styles of element snapshots in the background. Prewarming is performed on a low priority queue, and the style identities of the prewarmed
+ * styles are retained (until all cached styles are cleared), since there may not yet be any elements with those identities.
+ */
+- (void) resolveStylesForSnapshots:(NSArray*)snapshots inStyleSheets:(NSArray*)styleSheets ruleIndices:(NSArray*)ruleIndices prewarm:(BOOL)prewarm
+                 completionHandler:(void (^)(void))completionHandler {
+    if( snapshots.count == 0 ) {
+        if( completionHandler ) completionHandler();
+        return;
+    }
+
+    NSUInteger cachedStylesGeneration = _cachedStylesGeneration;
+    NSTimeInterval t = [NSDate timeIntervalSinceReferenceDate];
+    dispatch_queue_t queue = dispatch_get_global_queue(prewarm ? DISPATCH_QUEUE_PRIORITY_LOW : DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    dispatch_async(queue, ^{
+        // Resolve styles of each unique style identity concurrently
+        dispatch_apply(snapshots.count, queue, ^(size_t i) {
+            [self resolveStylesForSnapshot:snapshots[i] inRuleIndices:ruleIndices];
+        });
+
+        dispatch_async(dispatch_get_main_queue(), ^{
+            // Discard the result if cached styles have been cleared (or stylesheets or their declarations changed) while styles were resolved
+            BOOL styleSheetsChanged = ![self.effectiveStylesheets isEqualToArray:styleSheets];
+            for(NSUInteger i=0; i<styleSheets.count && !styleSheetsChanged; i++) {
+                styleSheetsChanged = [styleSheets[i] ruleIndex] != ruleIndices[i];
+            }
+            if( cachedStylesGeneration != self->_cachedStylesGeneration || styleSheetsChanged ) {
+                ISSLogDebug(@"Stylesheets changed during background style resolution - discarding resolved styles");
+                if( completionHandler ) completionHandler();
+                return;
+            }
+
+            NSMutableArray* resolvedDeclarations = [NSMutableArray array];
+            for(ISSUIElementDetailsSnapshot* snapshot in snapshots) {
+                if( !snapshot.resolvedDeclarations || [self.cachedStyleDeclarationsForElements objectForKey:snapshot.styleIdentity] ) continue;
+
+                [self.cachedStyleDeclarationsForElements setObject:snapshot.resolvedDeclarations forKey:snapshot.styleIdentity];
+                if( prewarm ) [self retainPrewarmedStyleIdentity:snapshot.styleIdentity];
+                if( snapshot.resolvedStyles ) [self.cachedResolvedStylesForDeclarations setObject:snapshot.resolvedStyles forKey:snapshot.resolvedDeclarations];
+                [resolvedDeclarations addObjectsFromArray:snapshot.resolvedDeclarations];
+            }
+            ISSLogDebug(@"Resolved styles for %lu style identities in %f seconds", (unsigned long)snapshots.count, ([NSDate timeIntervalSinceReferenceDate] - t));
+
+            // Finally, transform the property values of the resolved declarations (also in the background)
+            [self transformPropertyValuesInBackgroundForDeclarations:resolvedDeclarations completionHandler:completionHandler];
+        });
+    });
+}
+
+/*
+ * Resolves the styles of an element and all its children in the background. If parentElement is specified, it will be used as the parent of the element
+ * (which may not yet have been added to it).
+ */
+- (void) resolveStylesForUIElement:(id)uiElement parentElement:(id)parentElement prewarm:(BOOL)prewarm completionHandler:(void (^)(void))completionHandler {
+    NSArray* styleSheets = self.effectiveStylesheets;
+    NSMutableSet* nestedElementKeyPaths = [NSMutableSet set];
+    NSArray* ruleIndices = [self ruleIndicesForBackgroundStyleResolution:styleSheets nestedElementKeyPaths:nestedElementKeyPaths];
+
+    NSMutableArray* snapshots = [NSMutableArray array];
+    if( ruleIndices && uiElement ) {
+        NSMapTable* snapshotsForElements = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsStrongMemory|NSPointerFunctionsObjectPointerPersonality valueOptions:NSPointerFunctionsStrongMemory];
+        NSHashTable* styleIdentities = [[NSHashTable alloc] initWithOptions:NSPointerFunctionsStrongMemory|NSPointerFunctionsObjectPointerPersonality capacity:0];
+        if( parentElement ) {
+            ISSUIElementDetailsSnapshot* snapshot = [[ISSUIElementDetailsSnapshot alloc] initWithElementDetails:[self detailsForUIElement:uiElement]];
+            snapshot.parentSnapshot = [self snapshotForUIElement:parentElement snapshots:snapshotsForElements nestedElementKeyPaths:nestedElementKeyPaths];
+            snapshot.ownerSnapshot = snapshot.parentSnapshot;
+            [snapshotsForElements setObject:snapshot forKey:uiElement];
+        }
+        [self addSnapshotsForUIElement:uiElement snapshots:snapshotsForElements nestedElementKeyPaths:nestedElementKeyPaths unresolvedSnapshots:snapshots unresolvedStyleIdentities:styleIdentities];
+    }
+    [self resolveStylesForSnapshots:snapshots inStyleSheets:styleSheets ruleIndices:ruleIndices prewarm:prewarm completionHandler:completionHandler];
+}
+
+- (void) resolveStylesForUIElement:(id)uiElement completionHandler:(void (^)(void))completionHandler {
+    [self resolveStylesForUIElement:uiElement parentElement:nil prewarm:NO completionHandler:completionHandler];
+}
+
+- (void) applyStylingAsynchronously:(id)uiElement force:(BOOL)force completionHandler:(void (^)(void))completionHandler {
+    __weak id weakUIElement = uiElement;
+    [self resolveStylesForUIElement:uiElement completionHandler:^{
+        [self applyStyling:weakUIElement includeSubViews:YES force:force];
+        if( completionHandler ) completionHandler();
+    }];
+}
+
+/*
+ * Prewarming is started when the main run loop is about to wait for events in the default mode (i.e. not while scrolling or tracking touches), after
+ * all other work of the run loop turn (including scheduled styling and Core Animation commits) has been done.
+ */
+- (void) performWhenMainRunLoopIdle:(dispatch_block_t)block {
+    CFRunLoopObserverRef observer = CFRunLoopObserverCreateWithHandler(kCFAllocatorDefault, kCFRunLoopBeforeWaiting, NO, ISSIdleRunLoopObserverOrder,
+            ^(CFRunLoopObserverRef observer, CFRunLoopActivity activity) {
+        block();
+    });
+    CFRunLoopAddObserver(CFRunLoopGetMain(), observer, kCFRunLoopDefaultMode); // Non-repeating observers are removed from the run loop after firing
+    CFRelease(observer);
+    CFRunLoopWakeUp(CFRunLoopGetMain());
+}
+
+/*
+ * Retains the style identity of prewarmed styles (which may not yet be used by any element), releasing the oldest ones if there are too many.
+ */
+- (void) retainPrewarmedStyleIdentity:(ISSElementStyleIdentity*)styleIdentity {
+    [_prewarmedStyleIdentities removeObject:styleIdentity];
+    [_prewarmedStyleIdentities addObject:styleIdentity];
+    while( _prewarmedStyleIdentities.count > ISSMaximumPrewarmedStyleIdentities ) {
+        [_prewarmedStyleIdentities removeObjectAtIndex:0];
+    }
+}
+
+- (void) prewarmStylesForUIElement:(id)uiElement inParent:(id)parentElement completionHandler:(void (^)(void))completionHandler {
+    [self performWhenMainRunLoopIdle:^{
+        [self resolveStylesForUIElement:uiElement parentElement:parentElement prewarm:YES completionHandler:completionHandler];
+    }];
+}
+
+- (void) prewarmStylesForIdentityPaths:(NSArray*)identityPaths completionHandler:(void (^)(void))completionHandler {
+    [self performWhenMainRunLoopIdle:^{
+        NSArray* styleSheets = self.effectiveStylesheets;
+        NSMutableArray* snapshots = [NSMutableArray array];
+        NSArray* ruleIndices = [self ruleIndicesForBackgroundStyleResolution:styleSheets nestedElementKeyPaths:[NSMutableSet set]];
+        if( ruleIndices ) {
+            NSHashTable* styleIdentities = [[NSHashTable alloc] initWithOptions:NSPointerFunctionsStrongMemory|NSPointerFunctionsObjectPointerPersonality capacity:0];
+            for(NSString* identityPath in identityPaths) {
+                ISSUIElementDetailsSnapshot* snapshot = [ISSUIElementDetailsSnapshot snapshotWithStyleIdentityPath:identityPath];
+                if( !snapshot ) {
+                    ISSLogWarning(@"Unable to prewarm styles for invalid style identity path: '%@'", identityPath);
+                    continue;
+                }
+                ISSElementStyleIdentity* styleIdentity = snapshot.styleIdentity;
+                if( ![styleIdentities containsObject:styleIdentity] && ![self.cachedStyleDeclarationsForElements objectForKey:styleIdentity] ) {
+                    [styleIdentities addObject:styleIdentity];
+                    [snapshots addObject:snapshot];
+                }
+            }
+        }
+        [self resolveStylesForSnapshots:snapshots inStyleSheets:styleSheets ruleIndices:ruleIndices prewarm:YES completionHandler:completionHandler];
+    }];
+}
+
+
 #pragma mark - Styling - Elememt details
 
 - (ISSUIElementDetailsInterfaCSS*) detailsForUIElement:(id)uiElement create:(BOOL)create {
@@ -418,7 +1054,55 @@ static void setupForInitialState(InterfaCSS* interfaCSS) {
 }
 
 - (void) clearCachedInformationIfNeededForUIElementDetails:(ISSUIElementDetails*)uiElementDetails {
-    [self clearCachedInformationForUIElementDetails:uiElementDetails includeSubViews:YES clearCachedInformationOnlyIfNeeded:YES clearCachedStyleDeclarations:NO];
+    [self clearCachedInformationIfNeededForUIElementDetails:uiElementDetails invalidation:ISSStyleInvalidationDescendants];
+}
+
+- (void) clearCachedInformationIfNeededForUIElementDetails:(ISSUIElementDetails*)uiElementDetails invalidation:(ISSStyleInvalidation)invalidation {
+    [_ancestorFilter invalidate]; // Element may be an ancestor of the element currently being styled, so ancestor filter can no longer be trusted
+    BOOL includeSubViews = (invalidation & ISSStyleInvalidationDescendants) != 0;
+    [self clearCachedInformationForUIElementDetails:uiElementDetails includeSubViews:includeSubViews clearCachedInformationOnlyIfNeeded:YES clearCachedStyleDeclarations:NO];
+
+    // Even if the styling of descendants is unaffected, their style identities (which include the style identity of this element) are not
+    if( !includeSubViews || !uiElementDetails.addedToViewHierarchy ) {
+        [self visitViewHierarchyFromElementDetails:uiElementDetails scope:_cmd onlyChildren:YES visitorBlock:^id(id viewObject, ISSUIElementDetails* subViewDetails, BOOL* stop) {
+            if( includeSubViews ) {
+                [subViewDetails resetCachedStyleIdentity:YES];
+            } else {
+                // The change cannot affect which declarations match the descendant - keep its cached styles, and make the declarations available under its new style identity
+                NSMutableArray* cachedDeclarations = subViewDetails.cachedDeclarations;
+                [subViewDetails resetCachedStyleIdentity:NO];
+                ISSElementStyleIdentity* styleIdentity = subViewDetails.styleIdentity;
+                if( cachedDeclarations && styleIdentity && (subViewDetails.stylesCacheable || subViewDetails.stylesFullyResolved) && ![self.cachedStyleDeclarationsForElements objectForKey:styleIdentity] ) {
+                    [self.cachedStyleDeclarationsForElements setObject:cachedDeclarations forKey:styleIdentity];
+                }
+            }
+            return nil;
+        } stop:nil createDetails:NO];
+    }
+
+    if( invalidation & ISSStyleInvalidationSiblings ) {
+        ISSUIElementDetails* parentDetails = uiElementDetails.parentElement ? [self detailsForUIElement:uiElementDetails.parentElement create:NO] : nil;
+        for(id sibling in parentDetails.childElementsForElement) {
+            if( sibling == uiElementDetails.uiElement ) continue;
+            ISSUIElementDetails* siblingDetails = [self detailsForUIElement:sibling create:NO];
+            if( siblingDetails ) [self clearCachedInformationForUIElementDetails:siblingDetails includeSubViews:YES clearCachedInformationOnlyIfNeeded:YES clearCachedStyleDeclarations:NO];
+        }
+    }
+}
+
+/**
+ * Determines which elements may be affected by a change of the specified style classes and/or element ids, using the invalidation sets of the loaded
+ * (active) stylesheets. Unless a style class or element id is used in a non-rightmost selector, only the element itself needs to be invalidated. Stylesheet
+ * scopes are arbitrary predicates on elements (and their ancestors), so any active scoped stylesheet means that descendants must always be invalidated.
+ */
+- (ISSStyleInvalidation) invalidationForChangedStyleClasses:(id<NSFastEnumeration>)styleClasses elementIds:(NSArray*)elementIds {
+    ISSStyleInvalidation invalidation = ISSStyleInvalidationElement;
+    for(ISSStyleSheet* styleSheet in self.effectiveStylesheets) {
+        if( styleSheet.scope ) invalidation |= ISSStyleInvalidationDescendants;
+        for(NSString* styleClass in styleClasses) invalidation |= [styleSheet invalidationForStyleClass:styleClass];
+        for(NSString* elementId in elementIds) invalidation |= [styleSheet invalidationForElementId:elementId];
+    }
+    return invalidation;
 }
 
 - (void) clearCachedInformationForUIElementDetails:(ISSUIElementDetails*)uiElementDetails clearCachedInformationOnlyIfNeeded:(BOOL)clearCachedInformationOnlyIfNeeded clearCachedStyleDeclarations:(BOOL)clearCachedStyleDeclarations {
@@ -430,7 +1114,7 @@ static void setupForInitialState(InterfaCSS* interfaCSS) {
     } else {
         ISSLogTrace(@"Clearing cached information for '%@'", uiElementDetails);
         // Only clear actual cached style declarations if clearCachedStyles is YES (since there is no need to clear this information in normal cases)
-        if( clearCachedStyleDeclarations ) [self.cachedStyleDeclarationsForElements removeObjectForKey:uiElementDetails.elementStyleIdentityPath];
+        if( clearCachedStyleDeclarations ) [self.cachedStyleDeclarationsForElements removeObjectForKey:uiElementDetails.styleIdentity];
     }
     [uiElementDetails resetCachedData:NO];
 }
@@ -451,12 +1135,17 @@ static void setupForInitialState(InterfaCSS* interfaCSS) {
 }
 
 - (void) clearAllCachedStyles {
+    _cachedStylesGeneration++;
+    [_prewarmedStyleIdentities removeAllObjects];
     if( self.cachedStyleDeclarationsForElements.count ) {
         ISSLogTrace(@"Clearing all cached styles");
         [self.cachedStyleDeclarationsForElements removeAllObjects];
+        [self.cachedResolvedStylesForDeclarations removeAllObjects];
 
         [ISSUIElementDetails resetAllCachedData];
     }
+    [ISSElementStyleIdentity purgeUnusedIdentities];
+    [ISSStyleClassSet purgeStyleClassSpellings];
 }
 
 
@@ -477,14 +1166,36 @@ static void setupForInitialState(InterfaCSS* interfaCSS) {
 }
 
 - (BOOL) elementHasScheduledStyling:(id)element {
-    while( element ) {
-        ISSUIElementDetailsInterfaCSS* details = (ISSUIElementDetailsInterfaCSS*)[self detailsForUIElement:element];
-        if( details.stylingScheduled ) return YES;
-        else element = details.parentElement;
+    if( _scheduledStylingElements.count == 0 && _deferredStylingElements.count == 0 ) return NO; // Nothing scheduled - no need to look at the ancestors
+
+    for(ISSUIElementDetailsInterfaCSS* details = [self detailsForUIElement:element create:YES]; details; details = [self detailsForUIElement:details.parentElement create:YES]) {
+        if( [_scheduledStylingElements containsObject:details] || [_deferredStylingElements containsObject:details] ) return YES;
     }
     return NO;
 }
 
+/**
+ * Returns the topmost element of `scheduledElements` among the ancestors of the specified element, or nil if no ancestor is scheduled. The result for each
+ * visited ancestor is recorded in `scheduledRoots` (NSNull meaning none), so that ancestors shared by several scheduled elements are only visited once.
+ */
+- (ISSUIElementDetailsInterfaCSS*) scheduledRootOfElement:(ISSUIElementDetailsInterfaCSS*)uiElementDetails scheduledElements:(NSSet*)scheduledElements scheduledRoots:(NSMapTable*)scheduledRoots {
+    NSMutableArray* path = [NSMutableArray array];
+    id root = nil;
+    for(ISSUIElementDetailsInterfaCSS* ancestor = [self detailsForUIElement:uiElementDetails.parentElement create:YES]; ancestor; ancestor = [self detailsForUIElement:ancestor.parentElement create:YES]) {
+        root = [scheduledRoots objectForKey:ancestor];
+        if( root ) break;
+        [path addObject:ancestor];
+    }
+    if( root == [NSNull null] ) root = nil;
+
+    // Record the topmost scheduled element for each visited ancestor, starting from the top
+    for(ISSUIElementDetailsInterfaCSS* ancestor in path.reverseObjectEnumerator) {
+        if( !root && [scheduledElements containsObject:ancestor] ) root = ancestor;
+        [scheduledRoots setObject:(root ?: [NSNull null]) forKey:ancestor];
+    }
+    return root;
+}
+
 - (void) scheduleApplyStyling:(id)uiElement animated:(BOOL)animated {
     [self scheduleApplyStyling:uiElement animated:animated force:NO];
 }
@@ -501,30 +1212,147 @@ static void setupForInitialState(InterfaCSS* interfaCSS) {
     if( !uiElement ) return;
     
     ISSUIElementDetailsInterfaCSS* uiElementDetails = (ISSUIElementDetailsInterfaCSS*)[self detailsForUIElement:uiElement]; // Create details if not found, to ensure stylingScheduled is set correctly
-    if( uiElementDetails.stylingAppliedAndDisabled || uiElementDetails.stylingScheduled ) return;
+    if( uiElementDetails.stylingAppliedAndDisabled ) return;
+    if( uiElementDetails.stylingScheduled ) {
+        uiElementDetails.scheduledStylingForced |= force; // Make sure a forced styling request isn't lost
+        return;
+    }
     
     if( deviceIsRotating && uiElementDetails.view.window ) { // If device is rotating, we need to apply styles directly, to ensure they are performed within the animation used during the rotation
         [self applyStyling:uiElement includeSubViews:YES];
     } else {
         uiElementDetails.stylingScheduled = YES; // Flag reset in [applyStyling:includeSubViews:force:]
+        uiElementDetails.scheduledStylingAnimated = animated;
+        uiElementDetails.scheduledStylingForced = force;
 
-        if ( animated && force ) {
-            [[InterfaCSS sharedInstance] performSelector:@selector(applyStylingWithAnimationAndForce:) withObject:uiElement afterDelay:0];
-        } else if ( animated ) {
-            [[InterfaCSS sharedInstance] performSelector:@selector(applyStylingWithAnimation:) withObject:uiElement afterDelay:0];
-        } else if ( force ) {
-            [[InterfaCSS sharedInstance] performSelector:@selector(applyStylingWithForce:) withObject:uiElement afterDelay:0];
-        } else {
-            [[InterfaCSS sharedInstance] performSelector:@selector(applyStyling:) withObject:uiElement afterDelay:0];
-        }
+        [_scheduledStylingElements addObject:uiElementDetails];
+        if( _scheduledStylingElements.count == 1 ) CFRunLoopWakeUp(CFRunLoopGetMain()); // Make sure the run loop observer fires even if the run loop is currently idle
     }
 }
 
 - (void) cancelScheduledApplyStyling:(id)uiElement {
-    [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(applyStyling:) object:uiElement];
-    [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(applyStylingWithForce:) object:uiElement];
-    [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(applyStylingWithAnimation:) object:uiElement];
-    [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(applyStylingWithAnimationAndForce:) object:uiElement];
+    ISSUIElementDetailsInterfaCSS* uiElementDetails = (ISSUIElementDetailsInterfaCSS*)[self detailsForUIElement:uiElement create:NO];
+    [self cancelScheduledApplyStylingWithDetails:uiElementDetails];
+}
+
+- (void) cancelScheduledApplyStylingWithDetails:(ISSUIElementDetailsInterfaCSS*)uiElementDetails {
+    if( uiElementDetails.stylingScheduled ) {
+        [_scheduledStylingElements removeObject:uiElementDetails];
+        [_deferredStylingElements removeObject:uiElementDetails];
+        uiElementDetails.stylingScheduled = NO;
+    }
+}
+
+/**
+ * Applies all scheduled styling - invoked once per run loop turn (before Core Animation commits any changes to the render tree) by the scheduled styling run
+ * loop observer. Only the topmost scheduled elements are styled, since scheduled descendants are styled as part of the sub tree of their scheduled ancestor.
+ */
+- (void) applyScheduledStyling {
+    if( _deferredStylingElements.count ) [self applyDeferredStyling];
+    if( _scheduledStylingElements.count == 0 ) return;
+
+    NSArray* scheduledElements = _scheduledStylingElements.array;
+    [_scheduledStylingElements removeAllObjects]; // Elements scheduled during styling are handled in the next run loop turn
+
+    NSSet* scheduledElementSet = [NSSet setWithArray:scheduledElements];
+    NSMapTable* scheduledRoots = [NSMapTable strongToStrongObjectsMapTable];
+    NSMutableArray* rootElements = [NSMutableArray array];
+    for(ISSUIElementDetailsInterfaCSS* uiElementDetails in scheduledElements) {
+        if( !uiElementDetails.uiElement ) continue;
+        ISSUIElementDetailsInterfaCSS* rootElement = [self scheduledRootOfElement:uiElementDetails scheduledElements:scheduledElementSet scheduledRoots:scheduledRoots];
+        if( rootElement ) rootElement.scheduledStylingForced |= uiElementDetails.scheduledStylingForced; // Descendant is styled as part of the sub tree of the root - make sure a forced styling request isn't lost
+        else [rootElements addObject:uiElementDetails];
+    }
+    ISSLogTrace(@"Applying scheduled styling to %lu root elements (of %lu scheduled elements)", (unsigned long)rootElements.count, (unsigned long)scheduledElements.count);
+
+    _deferStylingOfNonVisibleElements = self.scheduledStylingTimeSlice > 0;
+    @try {
+        for(ISSUIElementDetailsInterfaCSS* uiElementDetails in rootElements) {
+            [self applyScheduledStylingWithDetails:uiElementDetails];
+        }
+
+        // Style any remaining elements not reached during styling of their ancestor (for instance if styling was disabled for the ancestor)
+        for(ISSUIElementDetailsInterfaCSS* uiElementDetails in scheduledElements) {
+            if( [_deferredStylingElements containsObject:uiElementDetails] ) continue;
+            else if( uiElementDetails.stylingScheduled && uiElementDetails.uiElement ) [self applyScheduledStylingWithDetails:uiElementDetails];
+            else uiElementDetails.stylingScheduled = NO;
+        }
+    } @finally {
+        _deferStylingOfNonVisibleElements = NO;
+    }
+
+    if( _deferredStylingElements.count ) CFRunLoopWakeUp(CFRunLoopGetMain()); // Make sure deferred styling continues in the next run loop turn
+}
+
+static BOOL ISSElementIsVisible(ISSUIElementDetails* elementDetails) {
+    UIView* view = elementDetails.view;
+    if( !view ) return YES; // Non-view elements (such as bar button items) are always considered visible
+    UIWindow* window = view.window;
+    if( !window || view.hidden ) return NO;
+    return CGRectIntersectsRect([view convertRect:view.bounds toView:nil], window.bounds);
+}
+
+/**
+ * Defers styling of the specified (non-visible) element, which is scheduled as a descendant of the element currently being styled.
+ */
+- (void) deferStylingWithDetails:(ISSUIElementDetailsInterfaCSS*)uiElementDetails force:(BOOL)force {
+    uiElementDetails.stylingScheduled = YES; // Ensures element is styled synchronously if it is moved to a window (see -[applyStylingIfScheduled:])
+    uiElementDetails.scheduledStylingAnimated = NO;
+    uiElementDetails.scheduledStylingForced = force;
+    [_deferredStylingElements addObject:uiElementDetails];
+}
+
+/**
+ * Applies deferred styling - deferred elements that have become visible are styled directly, and remaining elements are styled until the time slice is used up.
+ */
+- (void) applyDeferredStyling {
+    NSArray* deferredElements = _deferredStylingElements.array;
+    [_deferredStylingElements removeAllObjects];
+    NSMutableOrderedSet* remainingElements = [[NSMutableOrderedSet alloc] initWithCapacity:deferredElements.count];
+
+    _deferStylingOfNonVisibleElements = YES;
+    @try {
+        // First, style all deferred elements that are about to be displayed
+        for(ISSUIElementDetailsInterfaCSS* uiElementDetails in deferredElements) {
+            if( !uiElementDetails.stylingScheduled || !uiElementDetails.uiElement ) continue;
+            else if( ISSElementIsVisible(uiElementDetails) ) [self applyScheduledStylingWithDetails:uiElementDetails];
+            else [remainingElements addObject:uiElementDetails];
+        }
+
+        // Then style the remaining elements (non-visible descendants are deferred again) until the time slice is used up
+        CFTimeInterval deadline = CACurrentMediaTime() + self.scheduledStylingTimeSlice;
+        NSUInteger index = 0;
+        for(; index < remainingElements.count && (index == 0 || CACurrentMediaTime() < deadline); index++) { // Always make some progress
+            [self applyScheduledStylingWithDetails:remainingElements[index]];
+        }
+        ISSLogTrace(@"Applied deferred styling to %lu elements (%lu remaining)", (unsigned long)index, (unsigned long)(remainingElements.count - index + _deferredStylingElements.count));
+
+        // Keep remaining elements (before any elements deferred during this slice, to preserve the order of the elements). Elements already deferred again
+        // during this slice (i.e. elements reached as descendants of styled elements) are skipped, since inserting duplicates into an ordered set is undefined.
+        NSMutableArray* keptElements = [NSMutableArray arrayWithCapacity:remainingElements.count - index];
+        for(; index < remainingElements.count; index++) {
+            ISSUIElementDetailsInterfaCSS* uiElementDetails = remainingElements[index];
+            if( uiElementDetails.stylingScheduled && ![_deferredStylingElements containsObject:uiElementDetails] ) [keptElements addObject:uiElementDetails];
+        }
+        if( keptElements.count ) {
+            [_deferredStylingElements insertObjects:keptElements atIndexes:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, keptElements.count)]];
+        }
+    } @finally {
+        _deferStylingOfNonVisibleElements = NO;
+    }
+
+    if( _deferredStylingElements.count ) CFRunLoopWakeUp(CFRunLoopGetMain()); // Make sure deferred styling continues in the next run loop turn
+}
+
+- (void) applyScheduledStylingWithDetails:(ISSUIElementDetailsInterfaCSS*)uiElementDetails {
+    if( !uiElementDetails.stylingScheduled ) return; // Already styled as part of the sub tree of another element
+
+    id uiElement = uiElementDetails.uiElement;
+    if( uiElementDetails.scheduledStylingAnimated ) {
+        [self applyStylingWithAnimation:uiElement includeSubViews:YES force:uiElementDetails.scheduledStylingForced];
+    } else {
+        [self applyStylingWithDetails:uiElementDetails includeSubViews:YES force:uiElementDetails.scheduledStylingForced];
+    }
 }
 
 - (void) applyStylingWithForce:(id)uiElement {
@@ -540,7 +1368,7 @@ static void setupForInitialState(InterfaCSS* interfaCSS) {
     }
     
     if( uiElementDetails.stylingScheduled ) {
-        [self applyStylingWithDetails:uiElementDetails includeSubViews:YES force:NO];
+        [self applyStylingWithDetails:uiElementDetails includeSubViews:YES force:uiElementDetails.scheduledStylingForced];
     }
 }
 
@@ -570,20 +1398,62 @@ static void setupForInitialState(InterfaCSS* interfaCSS) {
         return;
     }
     
-    [uiElementDetails visitExclusivelyWithScope:_cmd visitorBlock:^id (ISSUIElementDetails* _) { // Prevent recursive styling calls for uiElement during styling
+    // Prevent recursive styling calls for uiElement during styling (of uiElement or its sub tree)
+    if( !ISSElementTraversalIsOnPath(uiElementDetails, ISSStylingTraversalScope) ) {
         [self applyStylingInternal:uiElementDetails includeSubViews:includeSubViews force:force];
-        return nil;
-    }];
-    
-    // Cancel scheduled calls after styling has been applied, to avoid "loop"
-    if( uiElementDetails.stylingScheduled ) {
-        [self cancelScheduledApplyStyling:uiElementDetails.uiElement];
-        uiElementDetails.stylingScheduled = NO;
     }
+    
+    // Cancel scheduled styling after styling has been applied, to avoid "loop"
+    [self cancelScheduledApplyStylingWithDetails:uiElementDetails];
 }
 
-// Internal styling method ("inner") - should only be called by -[doApplyStylingInternal:includeSubViews:force:].
+// Internal styling method ("inner") - should only be called by -[applyStylingWithDetails:includeSubViews:force:]. Styles the element and (optionally) its
+// subtree using an iterative traversal (see ISSElementTraversal), while maintaining the ancestor filter.
 - (void) applyStylingInternal:(ISSUIElementDetailsInterfaCSS*)uiElementDetails includeSubViews:(BOOL)includeSubViews force:(BOOL)force {
+    // If this is the root of the styling pass - seed the ancestor filter with the ancestors of the element
+    NSUInteger seededAncestors = 0;
+    if( _ancestorFilter.depth == 0 ) seededAncestors = [_ancestorFilter pushAncestorsOfElement:uiElementDetails];
+
+    ISSElementTraversal traversal = ISSElementTraversalBegin(ISSStylingTraversalScope);
+    NSUInteger pushedAncestors = 0; // Elements of the current path in the traversal, pushed onto the ancestor filter
+    @try {
+        ISSElementTraversalPush(&traversal, uiElementDetails, 0);
+        ISSUIElementDetailsInterfaCSS* elementDetails;
+        NSUInteger depth;
+        while( (elementDetails = (ISSUIElementDetailsInterfaCSS*)ISSElementTraversalPop(&traversal, &depth)) ) {
+            // Remove elements no longer on the current path from the ancestor filter
+            for(; pushedAncestors > depth; pushedAncestors--) [_ancestorFilter popElement];
+
+            if( elementDetails != uiElementDetails ) {
+                if( _deferStylingOfNonVisibleElements && !ISSElementIsVisible(elementDetails) ) {
+                    if( !elementDetails.stylingAppliedAndDisabled ) [self deferStylingWithDetails:elementDetails force:force];
+                    continue;
+                }
+                if( elementDetails.stylingAppliedAndDisabled ) {
+                    ISSLogTrace(@"Styling disabled for %@", elementDetails.view);
+                    continue;
+                }
+            }
+            if( !ISSElementTraversalMarkVisited(&traversal, elementDetails) ) continue; // Already styled in this traversal, or sub tree being styled by an enclosing one
+
+            [self styleElementInternal:elementDetails force:force];
+
+            // Process subviews (with element added to ancestor filter)
+            if( includeSubViews && ISSElementTraversalPushChildren(&traversal, elementDetails, depth + 1, YES) ) {
+                [_ancestorFilter pushElement:elementDetails];
+                pushedAncestors++;
+            }
+
+            if( elementDetails != uiElementDetails ) [self cancelScheduledApplyStylingWithDetails:elementDetails];
+        }
+    } @finally {
+        for(; pushedAncestors > 0; pushedAncestors--) [_ancestorFilter popElement];
+        ISSElementTraversalEnd(&traversal);
+        for(NSUInteger i=0; i<seededAncestors; i++) [_ancestorFilter popElement];
+    }
+}
+
+- (void) styleElementInternal:(ISSUIElementDetailsInterfaCSS*)uiElementDetails force:(BOOL)force {
     ISSLogTrace(@"Applying style to %@", uiElementDetails.uiElement);
     
     [uiElementDetails checkForUpdatedParentElement]; // Reset cached styles if parent/superview has changed...
@@ -595,17 +1465,6 @@ static void setupForInitialState(InterfaCSS* interfaCSS) {
     }
 
     [self styleUIElement:uiElementDetails force:force];
-
-    if( includeSubViews ) {
-        NSArray* subViews = uiElementDetails.childElementsForElement;
-
-        // Process subviews
-        for(id subView in subViews) {
-            ISSUIElementDetailsInterfaCSS* subViewDetails = (ISSUIElementDetailsInterfaCSS*)[self detailsForUIElement:subView];
-
-            [self applyStylingWithDetails:(ISSUIElementDetailsInterfaCSS*)subViewDetails includeSubViews:YES force:force];
-        }
-    }
 }
 
 - (void) applyStylingWithAnimationAndForce:(id)uiElement {
@@ -638,46 +1497,43 @@ static void setupForInitialState(InterfaCSS* interfaCSS) {
 
 - (void) setStyleClasses:(NSSet*)styleClasses forUIElement:(id)uiElement {
     ISSUIElementDetails* uiElementDetails = [self detailsForUIElement:uiElement];
-    if( styleClasses.count ) {
-        NSMutableSet* lcStyleClasses = [[NSMutableSet alloc] init];
-        for(NSString* styleClass in styleClasses) [lcStyleClasses addObject:[styleClass lowercaseString]];
-        uiElementDetails.styleClasses = lcStyleClasses;
-    } else {
-        uiElementDetails.styleClasses = nil;
-    }
+    NSSet* existingClasses = uiElementDetails.styleClasses;
+    uiElementDetails.styleClassSet = [ISSStyleClassSet styleClassSetWithStyleClasses:styleClasses]; // Style classes are mapped to (case insensitive) atoms
 
-    [self clearCachedInformationIfNeededForUIElementDetails:uiElementDetails];
+    // Only the added and removed style classes need to be considered when determining what to invalidate
+    NSSet* newClasses = uiElementDetails.styleClasses ?: [NSSet set];
+    NSMutableSet* changedClasses = [NSMutableSet setWithSet:existingClasses ?: [NSSet set]];
+    NSMutableSet* unchangedClasses = [changedClasses mutableCopy];
+    [unchangedClasses intersectSet:newClasses];
+    [changedClasses unionSet:newClasses];
+    [changedClasses minusSet:unchangedClasses];
+
+    [self clearCachedInformationIfNeededForUIElementDetails:uiElementDetails invalidation:[self invalidationForChangedStyleClasses:changedClasses elementIds:nil]];
 }
 
 - (BOOL) uiElement:(id)uiElement hasStyleClass:(NSString*)styleClass {
-    return [[self styleClassesForUIElement:uiElement] containsObject:[styleClass lowercaseString]];
+    return [[self detailsForUIElement:uiElement].styleClassSet containsStyleClass:styleClass];
 }
 
 - (void) addStyleClass:(NSString*)styleClass forUIElement:(id)uiElement {
-    styleClass = [styleClass lowercaseString];
     ISSUIElementDetails* uiElementDetails = [self detailsForUIElement:uiElement];
-    
-    NSSet* newClasses = [NSSet setWithObject:styleClass];
-    NSSet* existingClasses = uiElementDetails.styleClasses;
-    if( existingClasses ) newClasses = [newClasses setByAddingObjectsFromSet:existingClasses];
-    uiElementDetails.styleClasses = newClasses;
 
-    [self clearCachedInformationIfNeededForUIElementDetails:uiElementDetails];
+    ISSStyleClassSet* existingClasses = uiElementDetails.styleClassSet;
+    if( existingClasses ) uiElementDetails.styleClassSet = [existingClasses styleClassSetByAddingStyleClass:styleClass];
+    else uiElementDetails.styleClassSet = [ISSStyleClassSet styleClassSetWithStyleClasses:@[styleClass]];
+
+    NSString* canonicalStyleClass = [ISSStyleClassSet styleClassForAtom:[ISSStyleClassSet atomForStyleClass:styleClass]];
+    [self clearCachedInformationIfNeededForUIElementDetails:uiElementDetails invalidation:[self invalidationForChangedStyleClasses:@[canonicalStyleClass] elementIds:nil]];
 }
 
 - (void) removeStyleClass:(NSString*)styleClass forUIElement:(id)uiElement {
-    styleClass = [styleClass lowercaseString];
     ISSUIElementDetails* uiElementDetails = [self detailsForUIElement:uiElement];
 
-    NSSet* existingClasses = uiElementDetails.styleClasses;
-    if( existingClasses ) {
-        NSPredicate* predicate = [NSPredicate predicateWithBlock:^(id o, NSDictionary *b) {
-            return (BOOL)![styleClass isEqual:o];
-        }];
-        uiElementDetails.styleClasses = [existingClasses filteredSetUsingPredicate:predicate];
-    }
+    ISSStyleClassSet* existingClasses = uiElementDetails.styleClassSet;
+    if( existingClasses ) uiElementDetails.styleClassSet = [existingClasses styleClassSetByRemovingStyleClass:styleClass];
 
-    [self clearCachedInformationIfNeededForUIElementDetails:uiElementDetails];
+    NSString* canonicalStyleClass = [ISSStyleClassSet styleClassForAtom:[ISSStyleClassSet atomForStyleClass:styleClass]];
+    [self clearCachedInformationIfNeededForUIElementDetails:uiElementDetails invalidation:[self invalidationForChangedStyleClasses:@[canonicalStyleClass] elementIds:nil]];
 }
 
 
@@ -685,7 +1541,10 @@ static void setupForInitialState(InterfaCSS* interfaCSS) {
 
 - (void) setElementId:(NSString*)elementId forUIElement:(id)uiElement {
     ISSUIElementDetails* uiElementDetails = [self detailsForUIElement:uiElement];
-    [self clearCachedInformationIfNeededForUIElementDetails:uiElementDetails];
+    NSMutableArray* changedElementIds = [NSMutableArray array];
+    if( uiElementDetails.elementId ) [changedElementIds addObject:uiElementDetails.elementId];
+    if( elementId ) [changedElementIds addObject:elementId];
+    [self clearCachedInformationIfNeededForUIElementDetails:uiElementDetails invalidation:[self invalidationForChangedStyleClasses:nil elementIds:changedElementIds]];
     uiElementDetails.elementId = elementId;
 }
 
@@ -756,24 +1615,29 @@ static void setupForInitialState(InterfaCSS* interfaCSS) {
 
 - (id) visitViewHierarchyFromElementDetails:(ISSUIElementDetails*)uiElementDetails scope:(void*)scope onlyChildren:(BOOL)onlyChildren visitorBlock:(ISSViewHierarchyVisitorBlock)visitorBlock stop:(BOOL*)stop createDetails:(BOOL)createDetails {
     BOOL visitRootElement = !onlyChildren;
-    ISSUIElementDetailsInterfaCSS* details = (ISSUIElementDetailsInterfaCSS*)uiElementDetails;
-    if( !details || (visitRootElement && details.isVisiting) ) return nil; // Prevent recursive loops...
-    
-    return [details visitExclusivelyWithScope:scope visitorBlock:^id (ISSUIElementDetails* details) {
-        id result = nil;
-        if( visitRootElement ) {
-            result = visitorBlock(details.uiElement, details, stop);
-            if( stop && *stop ) return result;
-        }
+    if( !uiElementDetails || (visitRootElement && ISSElementTraversalIsOnPath(uiElementDetails, NULL)) ) return nil; // Prevent recursive loops...
+
+    id result = nil;
+    ISSElementTraversal traversal = ISSElementTraversalBegin(scope);
+    @try {
+        ISSElementTraversalPush(&traversal, uiElementDetails, 0);
+        ISSUIElementDetails* details;
+        NSUInteger depth;
+        while( (details = ISSElementTraversalPop(&traversal, &depth)) ) {
+            if( !ISSElementTraversalMarkVisited(&traversal, details) ) continue;
+
+            if( visitRootElement || details != uiElementDetails ) {
+                result = visitorBlock(details.uiElement, details, stop);
+                if( stop && *stop ) return result;
+            }
 
-        // Drill down
-        for(UIView* subview in details.childElementsForElement) {
-            ISSUIElementDetails* subviewDetails = [self detailsForUIElement:subview create:createDetails];
-            result = [self visitViewHierarchyFromElementDetails:subviewDetails scope:scope onlyChildren:NO visitorBlock:visitorBlock stop:stop createDetails:createDetails];
-            if( stop && *stop ) return result;
+            // Drill down
+            ISSElementTraversalPushChildren(&traversal, details, depth + 1, createDetails);
         }
-        return nil;
-    }];
+    } @finally {
+        ISSElementTraversalEnd(&traversal);
+    }
+    return nil;
 }
 
 - (id) visitReversedViewHierarchyFromView:(id)view visitorBlock:(ISSViewHierarchyVisitorBlock)visitorBlock {
@@ -871,6 +1735,18 @@ static void setupForInitialState(InterfaCSS* interfaCSS) {
     }
 }
 
+- (void) prewarmStylesForPrototype:(ISSViewPrototype*)prototype inParent:(id)parent completionHandler:(void (^)(void))completionHandler {
+    [self performWhenMainRunLoopIdle:^{
+        // Create a throwaway view from the prototype, without assigning it to any property of the parent
+        UIView* view = [prototype createViewObjectFromPrototypeWithParent:nil];
+        if( view ) {
+            [self resolveStylesForUIElement:view parentElement:parent prewarm:YES completionHandler:completionHandler];
+        } else if( completionHandler ) {
+            completionHandler();
+        }
+    }];
+}
+
 
 #pragma mark - Stylesheets
 
@@ -906,6 +1782,16 @@ static void setupForInitialState(InterfaCSS* interfaCSS) {
     }
 }
 
+- (void) loadStyleSheetFromMainBundleFile:(NSString*)styleSheetFileName withScope:(ISSStyleSheetScope*)scope completionHandler:(void (^)(ISSStyleSheet* styleSheet))completionHandler {
+    NSURL* url = [[NSBundle mainBundle] URLForResource:styleSheetFileName withExtension:nil];
+    if( url ) {
+        [self loadStyleSheetFromFileURL:url withScope:scope completionHandler:completionHandler];
+    } else {
+        ISSLogWarning(@"Unable to load stylesheet '%@' - file not found in main bundle!", styleSheetFileName);
+        if( completionHandler ) completionHandler(nil);
+    }
+}
+
 - (ISSStyleSheet*) loadStyleSheetFromFile:(NSString*)styleSheetFilePath {
     return [self loadStyleSheetFromFile:styleSheetFilePath withScope:nil];
 }
@@ -952,6 +1838,28 @@ static void setupForInitialState(InterfaCSS* interfaCSS) {
     return [self loadRefreshableStyleSheetFromURL:[NSURL fileURLWithPath:styleSheetFilePath] withScope:scope];
 }
 
++ (NSMutableArray*) parseStyleSheetData:(NSString*)styleSheetData parser:(id<ISSStyleSheetParser>)parser cache:(ISSStyleSheetCache*)cache {
+    if( cache ) return [cache declarationsForStyleSheetData:styleSheetData parser:parser];
+    else return [parser parse:styleSheetData];
+}
+
+- (NSMutableArray*) parseStyleSheetData:(NSString*)styleSheetData {
+    return [self.class parseStyleSheetData:styleSheetData parser:self.parser cache:self.styleSheetCache];
+}
+
+- (void) parseStyleSheetData:(NSString*)styleSheetData completionHandler:(void (^)(NSMutableArray* declarations))completionHandler {
+    id<ISSStyleSheetParser> parser = self.parser;
+    ISSStyleSheetCache* cache = self.styleSheetCache;
+    BOOL eagerlyTransformPropertyValues = self.eagerlyTransformPropertyValues;
+    dispatch_async(_styleSheetParsingQueue, ^{
+        NSMutableArray* declarations = [self.class parseStyleSheetData:styleSheetData parser:parser cache:cache];
+        if( declarations && eagerlyTransformPropertyValues ) [self.class transformPropertyValuesInDeclarations:declarations];
+        dispatch_async(dispatch_get_main_queue(), ^{
+            completionHandler(declarations);
+        });
+    });
+}
+
 - (void) reloadRefreshableStyleSheets:(BOOL)force {
     [[NSNotificationCenter defaultCenter] postNotificationName:ISSWillRefreshStyleSheetsNotification object:nil];
     
@@ -1034,24 +1942,62 @@ static void setupForInitialState(InterfaCSS* interfaCSS) {
 
 #pragma mark - Variables
 
+// Variables are accessed under a lock, since they may be defined and referenced when parsing stylesheets on a background queue
+
+static NSString* const ISSStyleSheetVariableDefinitionsRecorderKey = @"InterfaCSS.styleSheetVariableDefinitionsRecorder";
+
+- (NSDictionary*) styleSheetVariablesSnapshot {
+    NSMutableDictionary* variables = self.styleSheetsVariables;
+    @synchronized(variables) {
+        return [variables copy];
+    }
+}
+
 - (NSString*) valueOfStyleSheetVariableWithName:(NSString*)variableName {
-    return self.styleSheetsVariables[variableName];
+    NSMutableDictionary* variables = self.styleSheetsVariables;
+    @synchronized(variables) {
+        return variables[variableName];
+    }
 }
 
 - (id) transformedValueOfStyleSheetVariableWithName:(NSString*)variableName asPropertyType:(ISSPropertyType)propertyType {
-    NSString* value = self.styleSheetsVariables[variableName];
+    NSString* value = [self valueOfStyleSheetVariableWithName:variableName];
     if( value ) return [self.parser transformValue:value asPropertyType:propertyType];
     else return nil;
 }
 
 - (id) transformedValueOfStyleSheetVariableWithName:(NSString*)variableName forPropertyDefinition:(ISSPropertyDefinition*)propertyDefinition {
-    NSString* value = self.styleSheetsVariables[variableName];
+    NSString* value = [self valueOfStyleSheetVariableWithName:variableName];
     if( value ) return [self.parser transformValue:value forPropertyDefinition:propertyDefinition];
     else return nil;
 }
 
 - (void) setValue:(NSString*)value forStyleSheetVariableWithName:(NSString*)variableName {
-    self.styleSheetsVariables[variableName] = value;
+    NSMutableDictionary* variables = self.styleSheetsVariables;
+    @synchronized(variables) {
+        variables[variableName] = value;
+    }
+
+    NSMutableArray* recordedDefinitions = [NSThread currentThread].threadDictionary[ISSStyleSheetVariableDefinitionsRecorderKey];
+    if( recordedDefinitions && value ) [recordedDefinitions addObject:@[variableName, value]];
+}
+
+/**
+ * Returns the variables defined (in order of definition) on the current thread while executing `block`, i.e. the variables defined by a stylesheet parsed by
+ * the block, regardless of any variables defined concurrently on other threads. Recordings may be nested.
+ */
+- (NSArray*) styleSheetVariableDefinitionsRecordedDuringBlock:(void (^)(void))block {
+    NSMutableDictionary* threadDictionary = [NSThread currentThread].threadDictionary;
+    NSMutableArray* enclosingRecordedDefinitions = threadDictionary[ISSStyleSheetVariableDefinitionsRecorderKey];
+    NSMutableArray* recordedDefinitions = [NSMutableArray array];
+    threadDictionary[ISSStyleSheetVariableDefinitionsRecorderKey] = recordedDefinitions;
+    @try {
+        block();
+    } @finally {
+        threadDictionary[ISSStyleSheetVariableDefinitionsRecorderKey] = enclosingRecordedDefinitions;
+        [enclosingRecordedDefinitions addObjectsFromArray:recordedDefinitions];
+    }
+    return recordedDefinitions;
 }
 
 
@@ -0,0 +1,48 @@
+//
+//  ISSAncestorFilter.h
+//  Part of InterfaCSS - http://www.github.com/tolo/InterfaCSS
+//
+//  Copyright (c) Tobias Löfstrand, Leafnode AB.
+//  License: MIT (http://www.github.com/tolo/InterfaCSS/LICENSE)
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+@class ISSUIElementDetails;
+@class ISSSelector;
+
+
+/**
+ * Counting Bloom filter containing the hashes of the element ids, style classes and types of the ancestors of the element currently being styled. Maintained
+ * while descending the view hierarchy during styling, and used by ISSSelectorChain to quickly reject selector chains requiring ancestors that cannot be present.
+ */
+@interface ISSAncestorFilter : NSObject
+
+@property (nonatomic, readonly) NSUInteger depth;
+
+/** Adds the element to the top of the ancestor stack. */
+- (void) pushElement:(ISSUIElementDetails*)elementDetails;
+/** Pushes all the ancestors of the specified element (but not the element itself). Returns the number of pushed ancestors. */
+- (NSUInteger) pushAncestorsOfElement:(ISSUIElementDetails*)elementDetails;
+/** Removes the element at the top of the ancestor stack. */
+- (void) popElement;
+
+/** Marks the current contents of the filter as stale (for instance when the style classes of an ancestor are modified during styling). */
+- (void) invalidate;
+
+/** Returns `YES` if the filter contains exactly the ancestors of the specified element, i.e. if it can be used when matching the element. */
+- (BOOL) isValidForElement:(ISSUIElementDetails*)elementDetails;
+
+/** Returns `NO` if at least one of the specified hashes is definitely not present in the filter. */
+- (BOOL) mayContainHashes:(const uint32_t*)hashes count:(NSUInteger)count;
+
+/** Appends the ancestor filter hashes of the specified selector (i.e. hashes of element id, style classes and type) to the array `hashes`. */
++ (void) addHashesForSelector:(ISSSelector*)selector toArray:(NSMutableArray*)hashes;
+
+@end
+
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,189 @@
+//
+//  ISSAncestorFilter.m
+//  Part of InterfaCSS - http://www.github.com/tolo/InterfaCSS
+//
+//  Copyright (c) Tobias Löfstrand, Leafnode AB.
+//  License: MIT (http://www.github.com/tolo/InterfaCSS/LICENSE)
+//
+
+#import "ISSAncestorFilter.h"
+
+#import "ISSUIElementDetails.h"
+#import "ISSSelector.h"
+#import "ISSNestedElementSelector.h"
+
+
+#define ISS_ANCESTOR_FILTER_KEY_BITS 12
+#define ISS_ANCESTOR_FILTER_TABLE_SIZE (1 << ISS_ANCESTOR_FILTER_KEY_BITS)
+#define ISS_ANCESTOR_FILTER_KEY_MASK (ISS_ANCESTOR_FILTER_TABLE_SIZE - 1)
+
+static const uint32_t ISSAncestorFilterElementIdSalt = 0x5f3759dfu;
+static const uint32_t ISSAncestorFilterStyleClassSalt = 0x9e3779b9u;
+static const uint32_t ISSAncestorFilterTypeSalt = 0x85ebca6bu;
+
+
+static uint32_t mixHash(NSUInteger value, uint32_t salt) {
+    uint64_t h = (uint64_t)value ^ salt;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return (uint32_t)h ?: 1;
+}
+
+static uint32_t elementIdHash(NSString* elementId) {
+    return mixHash(elementId.hash, ISSAncestorFilterElementIdSalt);
+}
+
+static uint32_t styleClassHash(NSString* styleClass) {
+    return mixHash(styleClass.hash, ISSAncestorFilterStyleClassSalt);
+}
+
+static uint32_t typeHash(Class type) {
+    return mixHash((NSUInteger)(__bridge void*)type, ISSAncestorFilterTypeSalt);
+}
+
+
+@implementation ISSAncestorFilter {
+    uint8_t _counters[ISS_ANCESTOR_FILTER_TABLE_SIZE];
+
+    NSMutableArray* _elements; // Stack of pushed ISSUIElementDetails
+    NSMutableIndexSet* _inconsistentLevels; // Levels at which the pushed element wasn't a child of the element below it
+
+    uint32_t* _hashes; // Hashes added for each level, in push order
+    NSUInteger _hashCount;
+    NSUInteger _hashCapacity;
+    NSUInteger* _levelHashCounts;
+    NSUInteger _levelCapacity;
+}
+
+- (instancetype) init {
+    if( self = [super init] ) {
+        _elements = [[NSMutableArray alloc] init];
+        _inconsistentLevels = [[NSMutableIndexSet alloc] init];
+    }
+    return self;
+}
+
+- (void) dealloc {
+    free(_hashes);
+    free(_levelHashCounts);
+}
+
+
+#pragma mark - Filter table
+
+- (void) addHash:(uint32_t)hash {
+    uint8_t* c1 = &_counters[hash & ISS_ANCESTOR_FILTER_KEY_MASK];
+    uint8_t* c2 = &_counters[(hash >> 16) & ISS_ANCESTOR_FILTER_KEY_MASK];
+    if( *c1 < UINT8_MAX ) (*c1)++;
+    if( *c2 < UINT8_MAX ) (*c2)++;
+
+    if( _hashCount == _hashCapacity ) {
+        _hashCapacity = _hashCapacity ? _hashCapacity * 2 : 64;
+        _hashes = realloc(_hashes, _hashCapacity * sizeof(uint32_t));
+    }
+    _hashes[_hashCount++] = hash;
+}
+
+- (void) removeHash:(uint32_t)hash {
+    uint8_t* c1 = &_counters[hash & ISS_ANCESTOR_FILTER_KEY_MASK];
+    uint8_t* c2 = &_counters[(hash >> 16) & ISS_ANCESTOR_FILTER_KEY_MASK];
+    // Saturated counters are never decremented, since the actual count is unknown
+    if( *c1 > 0 && *c1 < UINT8_MAX ) (*c1)--;
+    if( *c2 > 0 && *c2 < UINT8_MAX ) (*c2)--;
+}
+
+- (BOOL) mayContainHash:(uint32_t)hash {
+    return _counters[hash & ISS_ANCESTOR_FILTER_KEY_MASK] && _counters[(hash >> 16) & ISS_ANCESTOR_FILTER_KEY_MASK];
+}
+
+
+#pragma mark - Ancestor stack
+
+- (NSUInteger) depth {
+    return _elements.count;
+}
+
+- (void) pushElement:(ISSUIElementDetails*)elementDetails {
+    NSUInteger level = _elements.count;
+    ISSUIElementDetails* top = [_elements lastObject];
+    if( top && top.uiElement != elementDetails.parentElement ) {
+        [_inconsistentLevels addIndex:level];
+    }
+    [_elements addObject:elementDetails];
+
+    NSUInteger hashCountBefore = _hashCount;
+    if( elementDetails.elementId ) [self addHash:elementIdHash([elementDetails.elementId lowercaseString])];
+    for(NSString* styleClass in elementDetails.styleClasses) {
+        [self addHash:styleClassHash(styleClass)];
+    }
+    if( elementDetails.canonicalType ) [self addHash:typeHash(elementDetails.canonicalType)];
+
+    if( level == _levelCapacity ) {
+        _levelCapacity = _levelCapacity ? _levelCapacity * 2 : 32;
+        _levelHashCounts = realloc(_levelHashCounts, _levelCapacity * sizeof(NSUInteger));
+    }
+    _levelHashCounts[level] = _hashCount - hashCountBefore;
+}
+
+- (NSUInteger) pushAncestorsOfElement:(ISSUIElementDetails*)elementDetails {
+    NSMutableArray* ancestors = [NSMutableArray array];
+    NSMutableSet* visited = [NSMutableSet set]; // Guard against circular parent relationships
+    id parent = elementDetails.parentElement;
+    while( parent && ![visited containsObject:parent] ) {
+        [visited addObject:parent];
+        ISSUIElementDetails* parentDetails = [[InterfaCSS sharedInstance] detailsForUIElement:parent];
+        [ancestors insertObject:parentDetails atIndex:0];
+        parent = parentDetails.parentElement;
+    }
+
+    for(ISSUIElementDetails* ancestorDetails in ancestors) {
+        [self pushElement:ancestorDetails];
+    }
+    return ancestors.count;
+}
+
+- (void) popElement {
+    if( !_elements.count ) return;
+
+    NSUInteger level = _elements.count - 1;
+    NSUInteger levelHashCount = _levelHashCounts[level];
+    for(NSUInteger i=0; i<levelHashCount; i++) {
+        [self removeHash:_hashes[--_hashCount]];
+    }
+
+    [_inconsistentLevels removeIndex:level];
+    [_elements removeLastObject];
+}
+
+- (void) invalidate {
+    if( _elements.count ) [_inconsistentLevels addIndexesInRange:NSMakeRange(0, _elements.count)];
+}
+
+
+#pragma mark - Matching
+
+- (BOOL) isValidForElement:(ISSUIElementDetails*)elementDetails {
+    if( !_elements.count || _inconsistentLevels.count ) return NO;
+    return ((ISSUIElementDetails*)[_elements lastObject]).uiElement == elementDetails.parentElement;
+}
+
+- (BOOL) mayContainHashes:(const uint32_t*)hashes count:(NSUInteger)count {
+    for(NSUInteger i=0; i<count; i++) {
+        if( ![self mayContainHash:hashes[i]] ) return NO;
+    }
+    return YES;
+}
+
++ (void) addHashesForSelector:(ISSSelector*)selector toArray:(NSMutableArray*)hashes {
+    // The element id of a nested element selector is really a key path, so it can't be used for filtering
+    if( [selector isKindOfClass:ISSNestedElementSelector.class] ) return;
+
+    if( selector.elementId ) [hashes addObject:@(elementIdHash(selector.elementId))];
+    for(NSString* styleClass in selector.styleClasses) {
+        [hashes addObject:@(styleClassHash(styleClass))];
+    }
+    if( selector.type ) [hashes addObject:@(typeHash(selector.type))];
+}
+
+@end
@@ -0,0 +1,51 @@
+//
+//  ISSElementStyleIdentity.h
+//  Part of InterfaCSS - http://www.github.com/tolo/InterfaCSS
+//
+//  Copyright (c) Tobias Löfstrand, Leafnode AB.
+//  License: MIT (http://www.github.com/tolo/InterfaCSS/LICENSE)
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+@class ISSStyleClassSet;
+
+
+/**
+ * Interned (hash-consed) representation of the style identity path of an element, i.e. the unique hierarchy/path of types, element ids and style classes
+ * leading up to the element. Identities are unique, which means that they can be compared and hashed by pointer (or `identifier`), and are therefore
+ * suitable for use as a cache key. A readable representation of the path is built lazily (see `path`).
+ */
+@interface ISSElementStyleIdentity : NSObject
+
+/** Unique integer identifier of this identity. */
+@property (nonatomic, readonly) NSUInteger identifier;
+
+@property (nonatomic, readonly, nullable) ISSElementStyleIdentity* parent;
+
+/** `YES` if this identity, or any of its ancestors, is based on an element id. */
+@property (nonatomic, readonly) BOOL containsElementId;
+/** `YES` if this identity, or any of its ancestors, is based on a custom style identity. */
+@property (nonatomic, readonly) BOOL containsCustomStyleIdentity;
+
+/** Readable representation of the style identity path (i.e. "UIView[someclass] UILabel"). Built lazily. */
+@property (nonatomic, readonly) NSString* path;
+
++ (instancetype) identityWithType:(Class)type styleClasses:(nullable ISSStyleClassSet*)styleClasses parent:(nullable ISSElementStyleIdentity*)parent;
++ (instancetype) identityWithElementId:(NSString*)elementId styleClasses:(nullable ISSStyleClassSet*)styleClasses;
++ (instancetype) identityWithCustomStyleIdentity:(NSString*)customStyleIdentity styleClasses:(nullable ISSStyleClassSet*)styleClasses;
++ (instancetype) identityWithNestedElementKeyPath:(NSString*)nestedElementKeyPath parent:(nullable ISSElementStyleIdentity*)parent;
+
+/**
+ * Removes entries for identities that are no longer in use from the interning tables (identities are only weakly referenced by the table, but the keys, as well
+ * as the identifiers assigned to style class sets, are not). Invoked when the style caches are cleared.
+ */
++ (void) purgeUnusedIdentities;
+
+@end
+
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,212 @@
+//
+//  ISSElementStyleIdentity.m
+//  Part of InterfaCSS - http://www.github.com/tolo/InterfaCSS
+//
+//  Copyright (c) Tobias Löfstrand, Leafnode AB.
+//  License: MIT (http://www.github.com/tolo/InterfaCSS/LICENSE)
+//
+
+#import "ISSElementStyleIdentity.h"
+
+#import "ISSStyleClassSet.h"
+#import "NSObject+ISSLogSupport.h"
+
+
+typedef NS_ENUM(NSInteger, ISSElementStyleIdentityKind) {
+    ISSElementStyleIdentityKindType,
+    ISSElementStyleIdentityKindElementId,
+    ISSElementStyleIdentityKindCustom,
+    ISSElementStyleIdentityKindNestedElement
+};
+
+
+#pragma mark - ISSElementStyleIdentityKey
+
+/**
+ * Key used for interning identities - combines the kind of identity, the name/type, the (interned) style class set and the identifier of the parent identity.
+ */
+@interface ISSElementStyleIdentityKey : NSObject <NSCopying>
+@end
+
+@implementation ISSElementStyleIdentityKey {
+    @package
+    ISSElementStyleIdentityKind _kind;
+    id _name; // Class or NSString
+    NSUInteger _styleClassSetIdentifier;
+    NSUInteger _parentIdentifier;
+}
+
+- (id) copyWithZone:(NSZone*)zone {
+    return self;
+}
+
+- (NSUInteger) hash {
+    NSUInteger h = [_name hash];
+    h = h * 31 + _styleClassSetIdentifier;
+    h = h * 31 + _parentIdentifier;
+    return h * 31 + (NSUInteger)_kind;
+}
+
+- (BOOL) isEqual:(id)object {
+    if( object == self ) return YES;
+    if( ![object isKindOfClass:ISSElementStyleIdentityKey.class] ) return NO;
+    ISSElementStyleIdentityKey* other = object;
+    return _kind == other->_kind && _styleClassSetIdentifier == other->_styleClassSetIdentifier && _parentIdentifier == other->_parentIdentifier &&
+        (_name == other->_name || [_name isEqual:other->_name]);
+}
+
+@end
+
+
+#pragma mark - ISSElementStyleIdentity
+
+static NSMapTable* internedIdentities; // ISSElementStyleIdentityKey -> ISSElementStyleIdentity (weak)
+static NSMutableDictionary* internedStyleClassSets; // ISSStyleClassSet -> identifier
+static NSUInteger identifierCounter = 0;
+static NSUInteger styleClassSetIdentifierCounter = 0;
+
+
+@interface ISSElementStyleIdentity ()
+@property (nonatomic, readwrite) NSUInteger identifier;
+@property (nonatomic, strong, readwrite, nullable) ISSElementStyleIdentity* parent;
+@property (nonatomic, readwrite) BOOL containsElementId;
+@property (nonatomic, readwrite) BOOL containsCustomStyleIdentity;
+@end
+
+@implementation ISSElementStyleIdentity {
+    ISSElementStyleIdentityKind _kind;
+    id _name;
+    ISSStyleClassSet* _styleClasses;
+    NSString* _path;
+}
+
++ (void) initialize {
+    if( self == ISSElementStyleIdentity.class ) {
+        internedIdentities = [NSMapTable strongToWeakObjectsMapTable];
+        internedStyleClassSets = [[NSMutableDictionary alloc] init];
+    }
+}
+
+
+#pragma mark - Interning
+
++ (NSUInteger) styleClassSetIdentifierForStyleClasses:(ISSStyleClassSet*)styleClasses {
+    if( !styleClasses.count ) return 0;
+
+    NSNumber* setIdentifier = internedStyleClassSets[styleClasses];
+    if( !setIdentifier ) {
+        setIdentifier = @(++styleClassSetIdentifierCounter); // Not based on count, since entries may be purged
+        internedStyleClassSets[styleClasses] = setIdentifier;
+    }
+    return [setIdentifier unsignedIntegerValue];
+}
+
++ (instancetype) internedIdentityWithKind:(ISSElementStyleIdentityKind)kind name:(id)name styleClasses:(ISSStyleClassSet*)styleClasses parent:(ISSElementStyleIdentity*)parent {
+    @synchronized(ISSElementStyleIdentity.class) {
+        ISSElementStyleIdentityKey* key = [[ISSElementStyleIdentityKey alloc] init];
+        key->_kind = kind;
+        key->_name = name;
+        key->_styleClassSetIdentifier = [self styleClassSetIdentifierForStyleClasses:styleClasses];
+        key->_parentIdentifier = parent.identifier;
+
+        ISSElementStyleIdentity* identity = [internedIdentities objectForKey:key];
+        if( !identity ) {
+            identity = [[self alloc] init];
+            identity.identifier = ++identifierCounter;
+            identity.parent = parent;
+            identity->_kind = kind;
+            identity->_name = name;
+            identity->_styleClasses = styleClasses.count ? styleClasses : nil;
+            identity.containsElementId = kind == ISSElementStyleIdentityKindElementId || parent.containsElementId;
+            identity.containsCustomStyleIdentity = kind == ISSElementStyleIdentityKindCustom || parent.containsCustomStyleIdentity;
+            [internedIdentities setObject:identity forKey:key];
+        }
+        return identity;
+    }
+}
+
++ (void) purgeUnusedIdentities {
+    @synchronized(ISSElementStyleIdentity.class) {
+        NSUInteger identityCount = internedIdentities.count;
+        NSUInteger styleClassSetCount = internedStyleClassSets.count;
+
+        // Collect keys of deallocated identities, along with the style class set identifiers still referenced by live identities
+        NSMutableArray* deadKeys = [NSMutableArray array];
+        NSMutableIndexSet* liveStyleClassSetIdentifiers = [NSMutableIndexSet indexSet];
+        for(ISSElementStyleIdentityKey* key in [[internedIdentities keyEnumerator] allObjects]) {
+            if( [internedIdentities objectForKey:key] ) {
+                if( key->_styleClassSetIdentifier ) [liveStyleClassSetIdentifiers addIndex:key->_styleClassSetIdentifier];
+            } else {
+                [deadKeys addObject:key];
+            }
+        }
+        for(ISSElementStyleIdentityKey* key in deadKeys) {
+            [internedIdentities removeObjectForKey:key];
+        }
+
+        // Identifiers of remaining style class sets are left untouched, since they are part of the keys of live identities
+        NSSet* deadStyleClassSets = [internedStyleClassSets keysOfEntriesPassingTest:^BOOL(ISSStyleClassSet* styleClassSet, NSNumber* setIdentifier, BOOL* stop) {
+            return ![liveStyleClassSetIdentifiers containsIndex:setIdentifier.unsignedIntegerValue];
+        }];
+        [internedStyleClassSets removeObjectsForKeys:[deadStyleClassSets allObjects]];
+
+        ISSLogTrace(@"Purged %lu unused style identities and %lu unused style class sets", (unsigned long)(identityCount - internedIdentities.count), (unsigned long)(styleClassSetCount - internedStyleClassSets.count));
+    }
+}
+
++ (instancetype) identityWithType:(Class)type styleClasses:(ISSStyleClassSet*)styleClasses parent:(ISSElementStyleIdentity*)parent {
+    return [self internedIdentityWithKind:ISSElementStyleIdentityKindType name:type styleClasses:styleClasses parent:parent];
+}
+
++ (instancetype) identityWithElementId:(NSString*)elementId styleClasses:(ISSStyleClassSet*)styleClasses {
+    return [self internedIdentityWithKind:ISSElementStyleIdentityKindElementId name:elementId styleClasses:styleClasses parent:nil];
+}
+
++ (instancetype) identityWithCustomStyleIdentity:(NSString*)customStyleIdentity styleClasses:(ISSStyleClassSet*)styleClasses {
+    return [self internedIdentityWithKind:ISSElementStyleIdentityKindCustom name:customStyleIdentity styleClasses:styleClasses parent:nil];
+}
+
++ (instancetype) identityWithNestedElementKeyPath:(NSString*)nestedElementKeyPath parent:(ISSElementStyleIdentity*)parent {
+    return [self internedIdentityWithKind:ISSElementStyleIdentityKindNestedElement name:nestedElementKeyPath styleClasses:nil parent:parent];
+}
+
+
+#pragma mark - Path
+
+- (NSString*) styleClassesPathFragment {
+    if( _styleClasses.count ) {
+        NSArray* styleClasses = [[_styleClasses.styleClasses allObjects] sortedArrayUsingComparator:^NSComparisonResult(NSString* obj1, NSString* obj2) {
+            return [obj1 compare:obj2];
+        }];
+        return [NSString stringWithFormat:@"[%@]", [styleClasses componentsJoinedByString:@","]];
+    }
+    return @"";
+}
+
+- (NSString*) localPath {
+    switch (_kind) {
+        case ISSElementStyleIdentityKindCustom: return [NSString stringWithFormat:@"@%@%@", _name, [self styleClassesPathFragment]];
+        case ISSElementStyleIdentityKindElementId: return [NSString stringWithFormat:@"#%@%@", _name, [self styleClassesPathFragment]];
+        case ISSElementStyleIdentityKindNestedElement: return [NSString stringWithFormat:@"$%@", _name];
+        default: return [NSString stringWithFormat:@"%@%@", NSStringFromClass(_name), [self styleClassesPathFragment]];
+    }
+}
+
+- (NSString*) path {
+    @synchronized(self) {
+        if( !_path ) {
+            NSString* localPath = [self localPath];
+            _path = self.parent ? [NSString stringWithFormat:@"%@ %@", self.parent.path, localPath] : localPath;
+        }
+        return _path;
+    }
+}
+
+
+#pragma mark - NSObject overrides
+
+- (NSString*) description {
+    return self.path;
+}
+
+@end
@@ -0,0 +1,77 @@
+//
+//  ISSElementTraversal.h
+//  Part of InterfaCSS - http://www.github.com/tolo/InterfaCSS
+//
+//  Copyright (c) Tobias Löfstrand, Leafnode AB.
+//  License: MIT (http://www.github.com/tolo/InterfaCSS/LICENSE)
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+@class ISSUIElementDetails;
+
+
+/**
+ * Iterative, depth first traversal of an element hierarchy, using an explicit stack of element details.
+ *
+ * Each thread has a single stack buffer, which is reused by all traversals on that thread (nested traversals, i.e. traversals started while another
+ * traversal is in progress, simply use the part of the buffer above the enclosing traversal). This means that no memory is allocated by a traversal, once
+ * the buffer has grown large enough.
+ *
+ * Every traversal is assigned a unique epoch, which is recorded in the `traversalEpoch` of each visited element. Cycle protection within a traversal is then
+ * just a matter of comparing the epoch of an element with the epoch of the traversal - since epochs are never reused, there are no flags that need to be
+ * reset when a traversal ends (or is aborted). Recursion protection (i.e. for traversals started while visiting an element) is based on the path of each
+ * traversal, which consists of the elements whose sub trees are currently being visited (see `ISSElementTraversalIsOnPath`). Elements that have already
+ * been completely visited by an enclosing traversal can thus be visited again by a nested traversal.
+ *
+ * Usage:
+ *
+ *     ISSElementTraversal traversal = ISSElementTraversalBegin(scope);
+ *     ISSElementTraversalPush(&traversal, rootDetails, 0);
+ *     NSUInteger depth;
+ *     ISSUIElementDetails* details;
+ *     while( (details = ISSElementTraversalPop(&traversal, &depth)) ) {
+ *         if( !ISSElementTraversalMarkVisited(&traversal, details) ) continue;
+ *         ...
+ *         ISSElementTraversalPushChildren(&traversal, details, depth + 1, YES);
+ *     }
+ *     ISSElementTraversalEnd(&traversal);
+ */
+typedef struct ISSElementTraversal {
+    void* state; // Traversal state of the current thread (opaque)
+    NSUInteger base; // Stack position of the enclosing traversal
+    NSUInteger pathBase; // Path position of the enclosing traversal
+    NSUInteger depth; // Depth of the element last popped from the stack
+    NSUInteger epoch;
+    const void* scope;
+} ISSElementTraversal;
+
+
+/** Begins a new traversal on the current thread. The scope identifies the kind of traversal (see `ISSElementTraversalIsOnPath`). Every call to this function must be balanced by a call to `ISSElementTraversalEnd`. */
+extern ISSElementTraversal ISSElementTraversalBegin(const void* scope);
+/** Ends a traversal, discarding any elements remaining on the stack. Traversals must be ended in the reverse order they were begun. */
+extern void ISSElementTraversalEnd(ISSElementTraversal* traversal);
+
+/** Pushes an element onto the stack of the traversal. */
+extern void ISSElementTraversalPush(ISSElementTraversal* traversal, ISSUIElementDetails* elementDetails, NSUInteger depth);
+/**
+ * Pushes the child elements of an element (in reverse order, so that they are popped in order) onto the stack of the traversal, and returns the number of
+ * pushed children. If `createDetails` is `NO`, children without element details are skipped.
+ */
+extern NSUInteger ISSElementTraversalPushChildren(ISSElementTraversal* traversal, ISSUIElementDetails* elementDetails, NSUInteger depth, BOOL createDetails);
+/** Pops the next element from the stack of the traversal, or returns `nil` if there are no more elements. */
+extern ISSUIElementDetails* _Nullable ISSElementTraversalPop(ISSElementTraversal* traversal, NSUInteger* _Nullable depth);
+
+/**
+ * Marks an element (the one last popped from the stack) as visited by the traversal, and adds it to the path of the traversal until its sub tree has been
+ * visited. Returns `NO` if the element has already been visited by this traversal, or is on the path of an active traversal with the same scope.
+ */
+extern BOOL ISSElementTraversalMarkVisited(ISSElementTraversal* traversal, ISSUIElementDetails* elementDetails);
+/** Returns `YES` if the sub tree of the element is currently being visited by a traversal on the current thread, which has the specified scope (or any scope, if `scope` is `NULL`). */
+extern BOOL ISSElementTraversalIsOnPath(ISSUIElementDetails* elementDetails, const void* _Nullable scope);
+
+
+NS_ASSUME_NONNULL_END
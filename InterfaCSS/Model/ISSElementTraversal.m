@@ -0,0 +1,163 @@
+//
+//  ISSElementTraversal.m
+//  Part of InterfaCSS - http://www.github.com/tolo/InterfaCSS
+//
+//  Copyright (c) Tobias Löfstrand, Leafnode AB.
+//  License: MIT (http://www.github.com/tolo/InterfaCSS/LICENSE)
+//
+
+#import "ISSElementTraversal.h"
+
+#import <pthread.h>
+#import <stdatomic.h>
+
+#import "InterfaCSS.h"
+#import "ISSUIElementDetails.h"
+
+
+typedef struct ISSElementTraversalFrame {
+    CFTypeRef elementDetails; // Retained
+    NSUInteger depth;
+} ISSElementTraversalFrame;
+
+typedef struct ISSElementTraversalPathEntry {
+    CFTypeRef elementDetails; // Retained
+    NSUInteger depth;
+    NSUInteger epoch;
+    const void* scope;
+} ISSElementTraversalPathEntry;
+
+typedef struct ISSElementTraversalState {
+    ISSElementTraversalFrame* frames; // Stack shared by all (nested) traversals on the thread
+    NSUInteger frameCount;
+    NSUInteger frameCapacity;
+    ISSElementTraversalPathEntry* path; // Elements whose sub trees are currently being visited, by all (nested) traversals on the thread
+    NSUInteger pathCount;
+    NSUInteger pathCapacity;
+} ISSElementTraversalState;
+
+
+static pthread_key_t stateKey;
+static pthread_once_t stateKeyOnce = PTHREAD_ONCE_INIT;
+static atomic_ulong epochCounter; // Epoch 0 is never used, i.e. it means "never visited"
+
+
+#pragma mark - Thread state
+
+static void ISSElementTraversalDestroyState(void* value) {
+    ISSElementTraversalState* state = value;
+    for(NSUInteger i=0; i<state->frameCount; i++) CFRelease(state->frames[i].elementDetails);
+    for(NSUInteger i=0; i<state->pathCount; i++) CFRelease(state->path[i].elementDetails);
+    free(state->frames);
+    free(state->path);
+    free(state);
+}
+
+static void ISSElementTraversalCreateStateKey(void) {
+    pthread_key_create(&stateKey, ISSElementTraversalDestroyState);
+}
+
+static ISSElementTraversalState* ISSElementTraversalCurrentState(BOOL create) {
+    pthread_once(&stateKeyOnce, ISSElementTraversalCreateStateKey);
+    ISSElementTraversalState* state = pthread_getspecific(stateKey);
+    if( !state && create ) {
+        state = calloc(1, sizeof(ISSElementTraversalState));
+        pthread_setspecific(stateKey, state);
+    }
+    return state;
+}
+
+
+#pragma mark - Traversal
+
+ISSElementTraversal ISSElementTraversalBegin(const void* scope) {
+    ISSElementTraversalState* state = ISSElementTraversalCurrentState(YES);
+    NSUInteger epoch = (NSUInteger)atomic_fetch_add(&epochCounter, 1) + 1;
+    return (ISSElementTraversal){ .state = state, .base = state->frameCount, .pathBase = state->pathCount, .epoch = epoch, .scope = scope };
+}
+
+/* Removes the elements of the traversal path with a depth greater than or equal to the specified depth, i.e. elements whose sub trees have been visited. */
+static void ISSElementTraversalTruncatePath(ISSElementTraversal* traversal, NSUInteger depth) {
+    ISSElementTraversalState* state = traversal->state;
+    while( state->pathCount > traversal->pathBase && state->path[state->pathCount - 1].depth >= depth ) {
+        CFRelease(state->path[--state->pathCount].elementDetails);
+    }
+}
+
+void ISSElementTraversalEnd(ISSElementTraversal* traversal) {
+    ISSElementTraversalState* state = traversal->state;
+    while( state->frameCount > traversal->base ) {
+        CFRelease(state->frames[--state->frameCount].elementDetails);
+    }
+    ISSElementTraversalTruncatePath(traversal, 0);
+}
+
+void ISSElementTraversalPush(ISSElementTraversal* traversal, ISSUIElementDetails* elementDetails, NSUInteger depth) {
+    ISSElementTraversalState* state = traversal->state;
+    if( state->frameCount == state->frameCapacity ) {
+        state->frameCapacity = state->frameCapacity ? state->frameCapacity * 2 : 64;
+        state->frames = realloc(state->frames, state->frameCapacity * sizeof(ISSElementTraversalFrame));
+    }
+    state->frames[state->frameCount++] = (ISSElementTraversalFrame){ .elementDetails = CFBridgingRetain(elementDetails), .depth = depth };
+}
+
+NSUInteger ISSElementTraversalPushChildren(ISSElementTraversal* traversal, ISSUIElementDetails* elementDetails, NSUInteger depth, BOOL createDetails) {
+    // Plain views without nested elements - use subviews directly, instead of building a list of child elements
+    NSArray* childElements = elementDetails.childElementsAreSubviews ? elementDetails.view.subviews : elementDetails.childElementsForElement;
+
+    NSUInteger count = 0;
+    for(NSUInteger i = childElements.count; i > 0; i--) {
+        id childElement = childElements[i - 1];
+        ISSUIElementDetails* childDetails = createDetails ? [[InterfaCSS sharedInstance] detailsForUIElement:childElement] : [childElement elementDetailsISS];
+        if( childDetails ) {
+            ISSElementTraversalPush(traversal, childDetails, depth);
+            count++;
+        }
+    }
+    return count;
+}
+
+ISSUIElementDetails* ISSElementTraversalPop(ISSElementTraversal* traversal, NSUInteger* depth) {
+    ISSElementTraversalState* state = traversal->state;
+    if( state->frameCount <= traversal->base ) return nil;
+
+    ISSElementTraversalFrame frame = state->frames[--state->frameCount];
+    ISSElementTraversalTruncatePath(traversal, frame.depth); // Sub trees of elements at the same or a greater depth have been visited
+    traversal->depth = frame.depth;
+    if( depth ) *depth = frame.depth;
+    return CFBridgingRelease(frame.elementDetails);
+}
+
+
+#pragma mark - Cycle protection
+
+BOOL ISSElementTraversalMarkVisited(ISSElementTraversal* traversal, ISSUIElementDetails* elementDetails) {
+    if( elementDetails.traversalEpoch == traversal->epoch || ISSElementTraversalIsOnPath(elementDetails, traversal->scope) ) return NO;
+
+    elementDetails.traversalEpoch = traversal->epoch;
+
+    // Add element to the path of the traversal, until its sub tree has been visited
+    ISSElementTraversalState* state = traversal->state;
+    if( state->pathCount == state->pathCapacity ) {
+        state->pathCapacity = state->pathCapacity ? state->pathCapacity * 2 : 32;
+        state->path = realloc(state->path, state->pathCapacity * sizeof(ISSElementTraversalPathEntry));
+    }
+    state->path[state->pathCount++] = (ISSElementTraversalPathEntry){ .elementDetails = CFBridgingRetain(elementDetails), .depth = traversal->depth,
+        .epoch = traversal->epoch, .scope = traversal->scope };
+    return YES;
+}
+
+BOOL ISSElementTraversalIsOnPath(ISSUIElementDetails* elementDetails, const void* scope) {
+    ISSElementTraversalState* state = ISSElementTraversalCurrentState(NO);
+    if( !state || state->pathCount == 0 ) return NO;
+
+    // Elements on a path have the epoch of the traversal that visited them, and the outermost traversal (i.e. the first path entry) has the lowest epoch
+    NSUInteger epoch = elementDetails.traversalEpoch;
+    if( epoch < state->path[0].epoch ) return NO;
+
+    for(NSUInteger i = state->pathCount; i > 0; i--) {
+        ISSElementTraversalPathEntry entry = state->path[i - 1];
+        if( entry.elementDetails == (__bridge CFTypeRef)elementDetails && (scope == NULL || entry.scope == scope) ) return YES;
+    }
+    return NO;
+}
@@ -10,6 +10,8 @@
 
 #import "ISSUIElementDetails.h"
 #import "ISSRuntimeIntrospectionUtils.h"
+#import "ISSStylingContext.h"
+#import "ISSUIElementDetailsSnapshot.h"
 
 
 @implementation ISSNestedElementSelector
@@ -24,6 +26,10 @@
 }
 
 - (BOOL) matchesElement:(ISSUIElementDetails*)elementDetails stylingContext:(ISSStylingContext*)stylingContext {
+    if( stylingContext.snapshotMatching ) { // Snapshots record the nested element key paths (used in stylesheets) by which the element is known in its owner element
+        return [((ISSUIElementDetailsSnapshot*)elementDetails).nestedElementKeyPaths containsObject:self.nestedElementKeyPath];
+    }
+
     ISSUIElementDetails* parentDetails = [[InterfaCSS sharedInstance] detailsForUIElement:elementDetails.ownerElement];
     NSString* validParentKeyPath = parentDetails.validNestedElements[self.nestedElementKeyPath];
     
@@ -33,9 +33,17 @@ extern NSObject* const ISSPropertyDefinitionUseCurrentValue;
 - (instancetype) initWithProperty:(ISSPropertyDefinition*)property parameters:(nullable NSArray*)parameters nestedElementKeyPath:(nullable NSString*)nestedElementKeyPath;
 - (instancetype) initWithUnrecognizedProperty:(NSString*)unrecognizedPropertyName;
 
+/**
+ * Indicates if the value of this declaration is pending (lazy) transformation, and can be transformed ahead of time, i.e. without a target element and off the
+ * main thread. Enum values, images (which may be remote resources) and values that may be relative (rects and points) are always transformed lazily.
+ */
+@property (nonatomic, readonly) BOOL canTransformValueEagerly;
+
 - (BOOL) transformValueIfNeeded;
 
 - (BOOL) applyPropertyValueOnTarget:(ISSUIElementDetails*)targetDetails;
+/** Applies the property value on the target. If `onlyIfChanged` is `YES`, the value is not set if it's the same as the value last applied to the target for this property (dynamic and updatable values are always applied). */
+- (BOOL) applyPropertyValueOnTarget:(ISSUIElementDetails*)targetDetails onlyIfChanged:(BOOL)onlyIfChanged;
 
 @end
 
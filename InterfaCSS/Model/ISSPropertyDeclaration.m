@@ -68,6 +68,12 @@ NSObject* const ISSPropertyDefinitionUseCurrentValue = @"<current>";
     return self.property.supportsDynamicValue;
 }
 
+- (BOOL) canTransformValueEagerly {
+    if( !self.lazyPropertyTransformationBlock || !self.property ) return NO;
+    ISSPropertyType type = self.property.type;
+    return type != ISSPropertyTypeEnumType && type != ISSPropertyTypeImage && !self.property.supportsDynamicValue;
+}
+
 - (BOOL) transformValueIfNeeded {
     if( self.lazyPropertyTransformationBlock ) {
         self.propertyValue = self.lazyPropertyTransformationBlock(self);
@@ -78,6 +84,10 @@ NSObject* const ISSPropertyDefinitionUseCurrentValue = @"<current>";
 }
 
 - (BOOL) applyPropertyValueOnTarget:(ISSUIElementDetails*)targetDetails {
+    return [self applyPropertyValueOnTarget:targetDetails onlyIfChanged:NO];
+}
+
+- (BOOL) applyPropertyValueOnTarget:(ISSUIElementDetails*)targetDetails onlyIfChanged:(BOOL)onlyIfChanged {
     if( !self.property ) {
         ISSLogWarning(@"Cannot apply property value - unknown property!");
         return NO;
@@ -100,7 +110,8 @@ NSObject* const ISSPropertyDefinitionUseCurrentValue = @"<current>";
 
     id value = nil;
     BOOL skipWarning = NO;
-    if( [self.propertyValue isKindOfClass:ISSUpdatableValue.class] ) {
+    BOOL updatable = [self.propertyValue isKindOfClass:ISSUpdatableValue.class];
+    if( updatable ) {
         ISSUpdatableValue* updatableValue = self.propertyValue;
         [targetDetails observeUpdatableValue:updatableValue forProperty:self];
         [updatableValue requestUpdate];
@@ -111,10 +122,18 @@ NSObject* const ISSPropertyDefinitionUseCurrentValue = @"<current>";
         value = self.propertyValue;
     }
 
+    // Dynamic values (i.e. relative rects/points) and updatable values may produce a different result even if the value object is the same
+    BOOL diffable = !updatable && !self.dynamicValue;
+    if( onlyIfChanged && diffable && [targetDetails isLastAppliedValue:value forProperty:self] ) {
+        ISSLogTrace(@"Property value not changed since last applied - skipping %@", self);
+        return YES;
+    }
+
     BOOL result = [self.property setValue:value onTarget:targetDetails.uiElement andParameters:self.parameters];
     if( !result && !skipWarning ) {
         ISSLogDebug(@"Unable to set value on %@", targetDetails.uiElement);
     }
+    [targetDetails setLastAppliedValue:(result && diffable ? value : nil) forProperty:self];
     return result;
 }
 
@@ -29,7 +29,22 @@
 NSString* const ISSAnonymousPropertyDefinitionName = @"ISSAnonymousPropertyDefinition";
 
 
-@implementation ISSPropertyDefinition
+/**
+ * Describes how the value of a property is set on a particular (target) class - resolved the first time the property is set on an instance of that class.
+ */
+typedef NS_ENUM(NSInteger, ISSPropertySetterPlan) {
+    ISSPropertySetterPlanDirectSetter, // Setter method is invoked directly (through cached IMP)
+    ISSPropertySetterPlanKVC, // No suitable setter method found, but KVC works (i.e. setValue:forUndefinedKey: or direct ivar access)
+    ISSPropertySetterPlanUnsupported // Property cannot be set on class
+};
+
+
+@implementation ISSPropertyDefinition {
+    NSArray* _keyPathPrefixComponents; // Key path components leading up to the object on which the property is set (nil if name isn't a key path)
+    NSArray* _keyPathPrefixGetters; // Getter selectors (as NSValue) for _keyPathPrefixComponents
+    NSString* _propertyKey; // Last component of key path
+    NSMapTable* _setterPlans; // Class -> NSNumber (ISSPropertySetterPlan)
+}
 
 - (id) initAnonymousPropertyDefinitionWithType:(ISSPropertyType)type {
     return [self initWithName:ISSAnonymousPropertyDefinitionName aliases:@[] type:type];
@@ -84,6 +99,19 @@ NSString* const ISSAnonymousPropertyDefinitionName = @"ISSAnonymousPropertyDefin
         _parameterEnumValues = [parameterEnumValues iss_dictionaryWithLowerCaseKeys];
 
         _nameIsKeyPath = [_name rangeOfString:@"."].location != NSNotFound; // Check if property name contains a "key path prefix"
+        if( _nameIsKeyPath ) {
+            NSArray* keyPathComponents = [_name componentsSeparatedByString:@"."];
+            _keyPathPrefixComponents = [keyPathComponents subarrayWithRange:NSMakeRange(0, keyPathComponents.count - 1)];
+            NSMutableArray* getters = [NSMutableArray array];
+            for(NSString* component in _keyPathPrefixComponents) {
+                [getters addObject:[NSValue valueWithPointer:NSSelectorFromString(component)]];
+            }
+            _keyPathPrefixGetters = [getters copy];
+            _propertyKey = [keyPathComponents lastObject];
+        } else {
+            _propertyKey = _name;
+        }
+        _setterPlans = [NSMapTable strongToStrongObjectsMapTable];
         
         _useIntrospection = useIntrospection;
     }
@@ -94,22 +122,77 @@ NSString* const ISSAnonymousPropertyDefinitionName = @"ISSAnonymousPropertyDefin
     return self.name == ISSAnonymousPropertyDefinitionName;
 }
 
+- (id) targetForKeyPathPrefixOfObject:(id)obj {
+    id target = obj;
+    for(NSUInteger i=0; i<_keyPathPrefixComponents.count && target; i++) {
+        SEL getter = [_keyPathPrefixGetters[i] pointerValue];
+        if( ![target respondsToSelector:getter] ) return nil;
+        target = [target valueForKey:_keyPathPrefixComponents[i]];
+    }
+    return target;
+}
+
 - (BOOL) setValueUsingKVC:(id)value onTarget:(id)obj {
-    @try {
-        if( [value isKindOfClass:ISSLazyValue.class] ) value = [value evaluateWithParameter:obj];
-
-        // Check if value can be transformed to NSValue (to be properly set via KVC)
-        if( [value respondsToSelector:@selector(transformToNSValue)] ) value = [value transformToNSValue];
-
-        [obj setValue:value forKeyPath:self.name]; // Will throw exception if property doesn't exist
-        return YES;
-    } @catch (NSException* e) {
-        // Attempt to set via reflection:
-        BOOL result = [ISSRuntimeIntrospectionUtils invokeSetterForProperty:self.name withValue:value inObject:obj];
-        if( !result ) {
-            ISSLogDebug(@"Unable to set value for property %@ - %@", self.name, e);
+    if( [value isKindOfClass:ISSLazyValue.class] ) value = [value evaluateWithParameter:obj];
+
+    // Check if value can be transformed to NSValue (to be properly set via KVC)
+    if( [value respondsToSelector:@selector(transformToNSValue)] ) value = [value transformToNSValue];
+
+    // Resolve the object on which the property should be set (if property name is a key path)
+    id target = _keyPathPrefixComponents ? [self targetForKeyPathPrefixOfObject:obj] : obj;
+    if( !target ) {
+        ISSLogDebug(@"Unable to set value for property %@ - key path cannot be resolved on %@", self.name, obj);
+        return NO;
+    }
+
+    // Note: plans are cached per actual (isa) class of target, to be consistent with the setter cache of ISSRuntimeIntrospectionUtils
+    Class targetClass = object_getClass(target);
+    NSNumber* plan;
+    @synchronized(self) {
+        plan = [_setterPlans objectForKey:targetClass];
+    }
+
+    if( !plan ) {
+        if( [ISSRuntimeIntrospectionUtils hasSetterForProperty:_propertyKey inObject:target] ) {
+            plan = @(ISSPropertySetterPlanDirectSetter);
+        } else {
+            // No suitable setter - attempt using KVC (only done once per class, to avoid repeatedly taking the exception path)
+            BOOL result = NO;
+            BOOL undefinedKey = NO;
+            @try {
+                [target setValue:value forKey:_propertyKey]; // Will throw exception if property doesn't exist
+                result = YES;
+            } @catch (NSException* e) {
+                ISSLogDebug(@"Unable to set value for property %@ - %@", self.name, e);
+                undefinedKey = [e.name isEqualToString:NSUndefinedKeyException];
+            }
+            // Only mark the property as unsupported for the class if it doesn't exist - other failures may be caused by the particular value being set
+            if( result || undefinedKey ) {
+                @synchronized(self) {
+                    [_setterPlans setObject:@(result ? ISSPropertySetterPlanKVC : ISSPropertySetterPlanUnsupported) forKey:targetClass];
+                }
+            }
+            return result;
         }
-        return result;
+        @synchronized(self) {
+            [_setterPlans setObject:plan forKey:targetClass];
+        }
+    }
+
+    switch( (ISSPropertySetterPlan)[plan integerValue] ) {
+        case ISSPropertySetterPlanDirectSetter: {
+            return [ISSRuntimeIntrospectionUtils invokeSetterForProperty:_propertyKey withValue:value inObject:target];
+        }
+        case ISSPropertySetterPlanKVC: {
+            @try {
+                [target setValue:value forKey:_propertyKey];
+                return YES;
+            } @catch (NSException* e) {
+                ISSLogDebug(@"Unable to set value for property %@ - %@", self.name, e);
+                return NO;
+            }
+        }
+        default: return NO;
     }
 }
 
@@ -21,6 +21,12 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property (nonatomic, strong, readonly) NSDictionary* validPrefixKeyPaths;
 
+/**
+ * Signature identifying the current set of property definitions and valid prefix key paths, i.e. everything that affects the result of parsing a stylesheet.
+ * The signature changes whenever custom properties or prefix key paths are registered, and is used to invalidate cached parse results.
+ */
+@property (nonatomic, strong, readonly) NSString* propertyDefinitionsSignature;
+
 - (NSSet*) propertyDefinitionsForType:(ISSPropertyType)propertyType;
 - (NSSet*) propertyDefinitionsForViewClass:(Class)viewClass;
 - (nullable ISSPropertyDefinition*) propertyDefinitionForProperty:(NSString*)propertyName inClass:(Class)viewClass;
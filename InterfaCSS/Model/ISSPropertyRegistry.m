@@ -157,14 +157,78 @@ static void createSegmentIfNeeded(UISegmentedControl* segmentedControl, NSUInteg
 @property (nonatomic, strong, readwrite) NSDictionary* validPrefixKeyPathsForClass;
 @property (nonatomic, strong, readwrite) NSDictionary* typePropertyDefinitions;
 
-@property (nonatomic, strong) NSDictionary* classesToTypeNames;
-@property (nonatomic, strong) NSDictionary* typeNamesToClasses;
+// Atomic, since type selectors may be resolved (and registered) when parsing stylesheets on background queues
+@property (atomic, strong) NSDictionary* classesToTypeNames;
+@property (atomic, strong) NSDictionary* typeNamesToClasses;
 @property (nonatomic, strong, readwrite) NSDictionary* propertyDefinitionsForClass;
 
 @end
 
 
-@implementation ISSPropertyRegistry
+@implementation ISSPropertyRegistry {
+    NSString* _propertyDefinitionsSignature;
+}
+
+@synthesize propertyDefinitions = _propertyDefinitions, validPrefixKeyPaths = _validPrefixKeyPaths, propertyDefinitionsForClass = _propertyDefinitionsForClass;
+
+// Accessors are synchronized, since property definitions may be looked up when parsing stylesheets on a background queue
+
+- (NSSet*) propertyDefinitions {
+    @synchronized(self) {
+        return _propertyDefinitions;
+    }
+}
+
+- (void) setPropertyDefinitions:(NSSet*)propertyDefinitions {
+    @synchronized(self) {
+        _propertyDefinitions = propertyDefinitions;
+        _propertyDefinitionsSignature = nil;
+    }
+}
+
+- (NSDictionary*) validPrefixKeyPaths {
+    @synchronized(self) {
+        return _validPrefixKeyPaths;
+    }
+}
+
+- (void) setValidPrefixKeyPaths:(NSDictionary*)validPrefixKeyPaths {
+    @synchronized(self) {
+        _validPrefixKeyPaths = validPrefixKeyPaths;
+        _propertyDefinitionsSignature = nil;
+    }
+}
+
+- (NSDictionary*) propertyDefinitionsForClass {
+    @synchronized(self) {
+        return _propertyDefinitionsForClass;
+    }
+}
+
+- (void) setPropertyDefinitionsForClass:(NSDictionary*)propertyDefinitionsForClass {
+    @synchronized(self) {
+        _propertyDefinitionsForClass = propertyDefinitionsForClass;
+    }
+}
+
+- (NSString*) propertyDefinitionsSignature {
+    @synchronized(self) {
+        if( !_propertyDefinitionsSignature ) {
+            NSMutableArray* components = [NSMutableArray arrayWithCapacity:self.propertyDefinitions.count + self.validPrefixKeyPaths.count];
+            for(ISSPropertyDefinition* p in self.propertyDefinitions) {
+                NSArray* names = [p.allNames.allObjects sortedArrayUsingSelector:@selector(compare:)];
+                [components addObject:[NSString stringWithFormat:@"%@:%@:%@:%@:%@", [names componentsJoinedByString:@","], p.uniqueTypeDescription,
+                                       @(p.enumValues.count), @(p.supportsDynamicValue), @(p.overriddenDefinition != nil)]];
+            }
+            for(NSString* prefix in self.validPrefixKeyPaths) {
+                [components addObject:[@"prefix:" stringByAppendingString:prefix]];
+            }
+            [components sortUsingSelector:@selector(compare:)];
+            _propertyDefinitionsSignature = [components componentsJoinedByString:@";"];
+        }
+        return _propertyDefinitionsSignature;
+    }
+}
 
 - (NSSet*) propertyDefinitionsForType:(ISSPropertyType)propertyType {
     return [self.propertyDefinitions filteredSetUsingPredicate:[NSPredicate predicateWithBlock:^BOOL(id evaluatedObject, NSDictionary* bindings) {
@@ -174,9 +238,10 @@ static void createSegmentIfNeeded(UISegmentedControl* segmentedControl, NSUInteg
 
 - (NSSet*) propertyDefinitionsForViewClass:(Class)viewClass {
     NSMutableSet* viewClassProperties = [[NSMutableSet alloc] init];
-    for(Class clazz in self.propertyDefinitionsForClass.allKeys) {
+    NSDictionary* propertyDefinitionsForClass = self.propertyDefinitionsForClass; // Use a single (immutable) snapshot
+    for(Class clazz in propertyDefinitionsForClass.allKeys) {
         if( [viewClass isSubclassOfClass:clazz] ) {
-            [viewClassProperties unionSet:self.propertyDefinitionsForClass[clazz]];
+            [viewClassProperties unionSet:propertyDefinitionsForClass[clazz]];
         }
     }
     return viewClassProperties;
@@ -195,21 +260,20 @@ static void createSegmentIfNeeded(UISegmentedControl* segmentedControl, NSUInteg
 }
 
 - (NSString*) canonicalTypeForClass:(Class)clazz {
-    NSString* type = self.classesToTypeNames[clazz];
-    if( type ) return type;
-    else { // Custom view class or "unsupported" UIKit view class
-        Class superClass = [clazz superclass];
-        if( superClass && superClass != NSObject.class ) return [self canonicalTypeForClass:superClass];
-        else return nil;
+    Class canonicalTypeClass = [self canonicalTypeClassForClass:clazz];
+    @synchronized(self) {
+        return canonicalTypeClass ? self.classesToTypeNames[canonicalTypeClass] : nil;
     }
 }
 
 - (Class) canonicalTypeClassForClass:(Class)clazz {
-    if( self.classesToTypeNames[clazz] ) return clazz;
-    else { // Custom view class or "unsupported" UIKit view class
-        Class superClass = [clazz superclass];
-        if( superClass && superClass != NSObject.class ) return [self canonicalTypeClassForClass:superClass];
-        else return nil;
+    @synchronized(self) {
+        NSDictionary* classesToTypeNames = self.classesToTypeNames;
+        // Custom view class or "unsupported" UIKit view class - use closest registered super class
+        for(Class typeClass = clazz; typeClass && typeClass != NSObject.class; typeClass = [typeClass superclass]) {
+            if( classesToTypeNames[typeClass] ) return typeClass;
+        }
+        return nil;
     }
 }
 
@@ -241,13 +305,15 @@ static void createSegmentIfNeeded(UISegmentedControl* segmentedControl, NSUInteg
 - (void) registerCanonicalTypeClass:(Class)clazz {
     NSString* type = [NSStringFromClass(clazz) lowercaseString];
 
-    NSMutableDictionary* temp = [NSMutableDictionary dictionaryWithDictionary:self.typeNamesToClasses];
-    temp[type] = clazz;
-    self.typeNamesToClasses = [NSDictionary dictionaryWithDictionary:temp];
+    @synchronized(self) {
+        NSMutableDictionary* temp = [NSMutableDictionary dictionaryWithDictionary:self.typeNamesToClasses];
+        temp[type] = clazz;
+        self.typeNamesToClasses = [NSDictionary dictionaryWithDictionary:temp];
 
-    temp = [NSMutableDictionary dictionaryWithDictionary:self.classesToTypeNames];
-    temp[resistanceIsFutile clazz] = type;
-    self.classesToTypeNames = [NSDictionary dictionaryWithDictionary:temp];
+        temp = [NSMutableDictionary dictionaryWithDictionary:self.classesToTypeNames];
+        temp[resistanceIsFutile clazz] = type;
+        self.classesToTypeNames = [NSDictionary dictionaryWithDictionary:temp];
+    }
 
     // Reset all cached data ISSUIElementDetails, since canonical type class may have changed for some elements
     [ISSUIElementDetails resetAllCachedData];
@@ -260,7 +326,9 @@ static void createSegmentIfNeeded(UISegmentedControl* segmentedControl, NSUInteg
 }
 
 - (void) registerCustomProperty:(ISSPropertyDefinition*)propertyDefinition {
-    if( propertyDefinition ) {
+    if( !propertyDefinition ) return;
+    @synchronized(self) { // Lock is recursive - the whole update is performed under the same lock as the accessors
+
         ISSPropertyDefinition* existingDefinition = [self.propertyDefinitions member:propertyDefinition];
         propertyDefinition.overriddenDefinition = existingDefinition;
         
@@ -291,26 +359,36 @@ static void createSegmentIfNeeded(UISegmentedControl* segmentedControl, NSUInteg
 
 - (void) registerValidPrefixKeyPath:(NSString*)prefix {
     if( ![prefix iss_hasData] ) return;
-    NSMutableDictionary* temp = [NSMutableDictionary dictionaryWithDictionary:self.validPrefixKeyPaths];
-    temp[prefix.lowercaseString] = prefix;
-    self.validPrefixKeyPaths = [temp copy];
+    @synchronized(self) {
+        NSMutableDictionary* temp = [NSMutableDictionary dictionaryWithDictionary:self.validPrefixKeyPaths];
+        temp[prefix.lowercaseString] = prefix;
+        self.validPrefixKeyPaths = [temp copy];
+    }
 
     // Reset all cached data ISSUIElementDetails, since valid prefix key paths may have changed for some elements
     [ISSUIElementDetails resetAllCachedData];
 }
 
 - (void) registerValidPrefixKeyPaths:(NSArray*)prefixes {
-    NSMutableDictionary* temp = [NSMutableDictionary dictionaryWithDictionary:self.validPrefixKeyPaths];
-    for(NSString* prefix in prefixes) {
-        if( [prefix iss_hasData] ) temp[prefix.lowercaseString] = prefix;
+    @synchronized(self) {
+        NSMutableDictionary* temp = [NSMutableDictionary dictionaryWithDictionary:self.validPrefixKeyPaths];
+        for(NSString* prefix in prefixes) {
+            if( [prefix iss_hasData] ) temp[prefix.lowercaseString] = prefix;
+        }
+        self.validPrefixKeyPaths = [temp copy];
     }
-    self.validPrefixKeyPaths = [temp copy];
 
     // Reset all cached data ISSUIElementDetails, since valid prefix key paths may have changed for some elements
     [ISSUIElementDetails resetAllCachedData];
 }
 
 - (NSSet*) validPrefixKeyPathsForClass:(Class)clazz {
+    @synchronized(self) {
+        return [self unsynchronizedValidPrefixKeyPathsForClass:clazz];
+    }
+}
+
+- (NSSet*) unsynchronizedValidPrefixKeyPathsForClass:(Class)clazz {
     NSString* className = NSStringFromClass(clazz);
     NSMutableSet* validKeyPathsForClass = self.validPrefixKeyPathsForClass[className];
     if( !validKeyPathsForClass ) {
@@ -71,6 +71,10 @@ typedef NS_ENUM(NSInteger, ISSPseudoClassType) {
 
 @interface ISSPseudoClass : NSObject
 
+@property (nonatomic, readonly) ISSPseudoClassType pseudoClassType;
+@property (nonatomic, readonly) NSInteger a;
+@property (nonatomic, readonly) NSInteger b;
+@property (nonatomic, readonly, nullable) NSString* parameter;
 @property (nonatomic, readonly) NSString* displayDescription;
 
 - (instancetype) initStructuralPseudoClassWithA:(NSInteger)a b:(NSInteger)b type:(ISSPseudoClassType)pseudoClassType;
@@ -81,6 +85,7 @@ typedef NS_ENUM(NSInteger, ISSPseudoClassType) {
 + (instancetype) pseudoClassWithTypeString:(NSString*)typeAsString andParameter:(NSString*)parameter;
 
 + (ISSPseudoClassType) pseudoClassTypeFromString:(NSString*)typeAsString;
++ (nullable NSString*) stringFromPseudoClassType:(ISSPseudoClassType)pseudoClassType;
 
 - (BOOL) matchesElement:(ISSUIElementDetails*)elementDetails;
 
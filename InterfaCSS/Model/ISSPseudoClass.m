@@ -128,6 +128,10 @@ static NSDictionary* stringToPseudoClassType;
     else @throw([NSException exceptionWithName:NSInvalidArgumentException reason:[NSString stringWithFormat:@"Invalid enum class type: %@", typeAsString] userInfo:nil]);
 }
 
++ (NSString*) stringFromPseudoClassType:(ISSPseudoClassType)pseudoClassType {
+    return [[stringToPseudoClassType allKeysForObject:@(pseudoClassType)] firstObject];
+}
+
 - (BOOL) matchesIndex:(NSInteger)indexInParent count:(NSInteger)n reverse:(BOOL)reverse {
     if( indexInParent != NSNotFound ) {
         for(NSInteger i=1; i<=n; i++) {
@@ -14,6 +14,7 @@ NS_ASSUME_NONNULL_BEGIN
 @class ISSPseudoClass;
 @class ISSUIElementDetails;
 @class ISSStylingContext;
+@class ISSStyleClassSet;
 
 
 typedef NS_ENUM(NSInteger, ISSSelectorCombinator) {
@@ -26,9 +27,11 @@ typedef NS_ENUM(NSInteger, ISSSelectorCombinator) {
 @interface ISSSelector : NSObject<NSCopying>
 
 @property (nonatomic, readonly, nullable) Class type;
+@property (nonatomic, readonly) BOOL wildcardType;
 @property (nonatomic, readonly, nullable) NSString* elementId;
 @property (nonatomic, readonly, nullable) NSString* styleClass; // Returns the first style class
 @property (nonatomic, readonly, nullable) NSArray* styleClasses;
+@property (nonatomic, readonly, nullable) ISSStyleClassSet* styleClassSet;
 @property (nonatomic, readonly, nullable) NSArray* pseudoClasses;
 
 @property (nonatomic, readonly) NSUInteger specificity;
@@ -15,6 +15,7 @@
 #import "ISSUIElementDetails.h"
 #import "ISSPropertyRegistry.h"
 #import "ISSStylingContext.h"
+#import "ISSStyleClassSet.h"
 
 
 @implementation ISSSelector {
@@ -32,9 +33,10 @@
         if( styleClasses ) {
             NSMutableArray* lcStyleClasses = [NSMutableArray array];
             for(NSString* styleClass in styleClasses) {
-                [lcStyleClasses addObject:[styleClass lowercaseString]];
+                [lcStyleClasses addObject:[ISSStyleClassSet styleClassForAtom:[ISSStyleClassSet atomForStyleClass:styleClass]]]; // Canonical (lowercase) style class
             }
             _styleClasses = lcStyleClasses;
+            _styleClassSet = [ISSStyleClassSet styleClassSetWithStyleClasses:lcStyleClasses];
         } else _styleClasses = nil;
         if( pseudoClasses.count == 0 ) pseudoClasses = nil;
         _pseudoClasses = pseudoClasses;
@@ -110,11 +112,9 @@
     }
     
     // STYLE CLASSES
-    if( match && self.styleClasses ) {
-        for(NSString* styleClass in self.styleClasses) {
-            match = [elementDetails.styleClasses containsObject:styleClass];
-            if( !match ) break;
-        }
+    if( match && _styleClassSet ) {
+        ISSStyleClassSet* elementStyleClassSet = elementDetails.styleClassSet;
+        match = elementStyleClassSet && [elementStyleClassSet containsStyleClassSet:_styleClassSet];
     }
 
     // PSEUDO CLASSES
@@ -13,10 +13,14 @@
 #import "ISSUIElementDetails.h"
 #import "ISSStylingContext.h"
 #import "ISSNestedElementSelector.h"
+#import "ISSAncestorFilter.h"
 
 
 @implementation ISSSelectorChain {
     BOOL _nestedElenentSelectorChain;
+    BOOL _containsSiblingCombinator;
+    uint32_t* _ancestorFilterHashes; // Hashes of the selectors in the chain that must match an ancestor of the element
+    NSUInteger _ancestorFilterHashCount;
 }
 
 #pragma mark - Utility methods
@@ -94,10 +98,43 @@
         
         _selectorComponents = selectorComponents;
         _hasPseudoClassSelector = hasPseudoClassSelector;
+
+        for(NSUInteger i=1; i<selectorComponents.count; i+=2) {
+            ISSSelectorCombinator combinator = (ISSSelectorCombinator)[selectorComponents[i] integerValue];
+            if( combinator == ISSSelectorCombinatorAdjacentSibling || combinator == ISSSelectorCombinatorGeneralSibling ) _containsSiblingCombinator = YES;
+        }
+
+        [self setupAncestorFilterHashes];
     }
     return self;
 }
 
+- (void) dealloc {
+    free(_ancestorFilterHashes);
+}
+
+- (void) setupAncestorFilterHashes {
+    // Ancestor filtering isn't used for nested element selector chains, since the last step in the chain is evaluated against the owner element
+    if( _nestedElenentSelectorChain ) return;
+
+    // A selector followed by a descendant or child combinator must match an ancestor of the element (selectors followed by sibling combinators match elements with the same parent, i.e. the same ancestors)
+    NSMutableArray* hashes = [NSMutableArray array];
+    for(NSUInteger i=0; i+2<_selectorComponents.count; i+=2) {
+        ISSSelectorCombinator combinator = (ISSSelectorCombinator)[_selectorComponents[i+1] integerValue];
+        if( combinator == ISSSelectorCombinatorDescendant || combinator == ISSSelectorCombinatorChild ) {
+            [ISSAncestorFilter addHashesForSelector:_selectorComponents[i] toArray:hashes];
+        }
+    }
+
+    if( hashes.count ) {
+        _ancestorFilterHashCount = hashes.count;
+        _ancestorFilterHashes = malloc(hashes.count * sizeof(uint32_t));
+        for(NSUInteger i=0; i<hashes.count; i++) {
+            _ancestorFilterHashes[i] = [hashes[i] unsignedIntValue];
+        }
+    }
+}
+
 + (instancetype) selectorChainWithSelector:(ISSSelector*)selector {
     return [self selectorChainWithComponents:@[selector]];
 }
@@ -176,8 +213,21 @@
 - (BOOL) matchesElement:(ISSUIElementDetails*)elementDetails stylingContext:(ISSStylingContext*)stylingContext {
     ISSSelector* lastSelector = [_selectorComponents lastObject];
     if( [lastSelector matchesElement:elementDetails stylingContext:(ISSStylingContext*)stylingContext] ) { // Match last selector...
+        // Siblings are not part of element snapshots, so chains with sibling combinators can only be matched against the actual UI element
+        if( _containsSiblingCombinator && stylingContext.snapshotMatching ) {
+            stylingContext.containsDeclarationsRequiringUIElement = YES;
+            return NO;
+        }
+
         const NSUInteger remainingCount = _selectorComponents.count - 1;
         ISSUIElementDetails* nextUIElementDetails = elementDetails;
+
+        // Quick rejection of chain, if any of the required ancestor selectors cannot be present in the ancestors of the element
+        ISSAncestorFilter* ancestorFilter = stylingContext.ancestorFilter;
+        if( _ancestorFilterHashCount && ancestorFilter && ![ancestorFilter mayContainHashes:_ancestorFilterHashes count:_ancestorFilterHashCount] ) {
+            nextUIElementDetails = nil;
+        }
+
         for(NSUInteger i=remainingCount; i>1 && nextUIElementDetails; i-=2) { // ...then rest of selector chain
             ISSSelectorCombinator combinator = (ISSSelectorCombinator)[_selectorComponents[i - 1] integerValue];
             ISSSelector* selector = _selectorComponents[i-2];
@@ -0,0 +1,47 @@
+//
+//  ISSStyleClassSet.h
+//  Part of InterfaCSS - http://www.github.com/tolo/InterfaCSS
+//
+//  Copyright (c) Tobias Löfstrand, Leafnode AB.
+//  License: MIT (http://www.github.com/tolo/InterfaCSS/LICENSE)
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+/**
+ * Immutable set of style classes, represented as a bitset of style class atoms. Style class names are mapped (case insensitively) to small integer atoms using
+ * a global atom table, which means that membership tests and subset tests (used when matching selectors) can be performed without any string operations.
+ */
+@interface ISSStyleClassSet : NSObject <NSCopying>
+
+/** The (lowercase) style classes contained in this set. */
+@property (nonatomic, readonly) NSSet* styleClasses;
+@property (nonatomic, readonly) NSUInteger count;
+
+/** Returns the atom for the specified style class (case insensitive), registering a new atom if needed. */
++ (NSUInteger) atomForStyleClass:(NSString*)styleClass;
+/** Returns the atom for the specified style class (case insensitive), or `NSNotFound` if no such atom has been registered. */
++ (NSUInteger) existingAtomForStyleClass:(NSString*)styleClass;
+/** Returns the canonical (lowercase) style class name for the specified atom. */
++ (nullable NSString*) styleClassForAtom:(NSUInteger)atom;
+/** Removes all remembered non-canonical spellings of style classes from the atom table (atoms themselves are never removed, since they may be in use). */
++ (void) purgeStyleClassSpellings;
+
+/** Creates a new set from the specified style classes (case insensitive). Returns `nil` if `styleClasses` is empty. */
++ (nullable instancetype) styleClassSetWithStyleClasses:(nullable id<NSFastEnumeration>)styleClasses;
+
+- (BOOL) containsStyleClass:(NSString*)styleClass;
+- (BOOL) containsAtom:(NSUInteger)atom;
+/** Returns `YES` if all the style classes in `styleClassSet` are also contained in this set. */
+- (BOOL) containsStyleClassSet:(ISSStyleClassSet*)styleClassSet;
+
+- (nullable ISSStyleClassSet*) styleClassSetByAddingStyleClass:(NSString*)styleClass;
+- (nullable ISSStyleClassSet*) styleClassSetByRemovingStyleClass:(NSString*)styleClass;
+
+@end
+
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,192 @@
+//
+//  ISSStyleClassSet.m
+//  Part of InterfaCSS - http://www.github.com/tolo/InterfaCSS
+//
+//  Copyright (c) Tobias Löfstrand, Leafnode AB.
+//  License: MIT (http://www.github.com/tolo/InterfaCSS/LICENSE)
+//
+
+#import "ISSStyleClassSet.h"
+
+
+#define ISS_STYLE_CLASS_SET_WORD_BITS 64
+
+
+static NSMutableDictionary* styleClassAtoms; // Style class name (as spelled when registered/looked up) -> atom
+static NSMutableArray* atomStyleClasses; // Atom -> canonical (lowercase) style class name
+
+
+@implementation ISSStyleClassSet {
+    uint64_t* _words;
+    NSUInteger _wordCount; // Trailing zero words are never stored
+}
+
++ (void) initialize {
+    if( self == ISSStyleClassSet.class ) {
+        styleClassAtoms = [[NSMutableDictionary alloc] init];
+        atomStyleClasses = [[NSMutableArray alloc] init];
+    }
+}
+
+- (instancetype) initWithAtoms:(NSIndexSet*)atoms {
+    if( self = [super init] ) {
+        _wordCount = atoms.lastIndex / ISS_STYLE_CLASS_SET_WORD_BITS + 1;
+        _words = calloc(_wordCount, sizeof(uint64_t));
+
+        uint64_t* words = _words;
+        NSMutableSet* styleClasses = [NSMutableSet setWithCapacity:atoms.count];
+        @synchronized(ISSStyleClassSet.class) {
+            [atoms enumerateIndexesUsingBlock:^(NSUInteger atom, BOOL* stop) {
+                words[atom / ISS_STYLE_CLASS_SET_WORD_BITS] |= (1ULL << (atom % ISS_STYLE_CLASS_SET_WORD_BITS));
+                [styleClasses addObject:atomStyleClasses[atom]];
+            }];
+        }
+        _styleClasses = [styleClasses copy];
+    }
+    return self;
+}
+
+- (void) dealloc {
+    free(_words);
+}
+
+
+#pragma mark - Atom table
+
++ (NSUInteger) atomForStyleClass:(NSString*)styleClass registerIfNotFound:(BOOL)registerIfNotFound {
+    @synchronized(ISSStyleClassSet.class) {
+        NSNumber* atom = styleClassAtoms[styleClass];
+        if( atom ) return [atom unsignedIntegerValue];
+
+        // Style class not found using current spelling - lookup (or register) using canonical (lowercase) name
+        NSString* canonicalStyleClass = [styleClass lowercaseString];
+        atom = styleClassAtoms[canonicalStyleClass];
+        if( !atom ) {
+            if( !registerIfNotFound ) return NSNotFound;
+            atom = @(atomStyleClasses.count);
+            [atomStyleClasses addObject:canonicalStyleClass];
+            styleClassAtoms[canonicalStyleClass] = atom;
+        }
+        styleClassAtoms[[styleClass copy]] = atom; // Remember current spelling, to avoid lowercasing the next time
+        return [atom unsignedIntegerValue];
+    }
+}
+
++ (NSUInteger) atomForStyleClass:(NSString*)styleClass {
+    return [self atomForStyleClass:styleClass registerIfNotFound:YES];
+}
+
++ (NSUInteger) existingAtomForStyleClass:(NSString*)styleClass {
+    return [self atomForStyleClass:styleClass registerIfNotFound:NO];
+}
+
++ (NSString*) styleClassForAtom:(NSUInteger)atom {
+    @synchronized(ISSStyleClassSet.class) {
+        return atom < atomStyleClasses.count ? atomStyleClasses[atom] : nil;
+    }
+}
+
++ (void) purgeStyleClassSpellings {
+    @synchronized(ISSStyleClassSet.class) {
+        NSSet* spellings = [styleClassAtoms keysOfEntriesPassingTest:^BOOL(NSString* styleClass, NSNumber* atom, BOOL* stop) {
+            return ![styleClass isEqualToString:atomStyleClasses[atom.unsignedIntegerValue]];
+        }];
+        [styleClassAtoms removeObjectsForKeys:[spellings allObjects]];
+    }
+}
+
+
+#pragma mark - Creation
+
++ (instancetype) styleClassSetWithStyleClasses:(id<NSFastEnumeration>)styleClasses {
+    NSMutableIndexSet* atoms = [NSMutableIndexSet indexSet];
+    for(NSString* styleClass in styleClasses) {
+        [atoms addIndex:[self atomForStyleClass:styleClass]];
+    }
+    return atoms.count ? [[self alloc] initWithAtoms:atoms] : nil;
+}
+
+- (NSMutableIndexSet*) atoms {
+    NSMutableIndexSet* atoms = [NSMutableIndexSet indexSet];
+    for(NSUInteger i=0; i<_wordCount; i++) {
+        uint64_t word = _words[i];
+        while( word ) {
+            NSUInteger bit = (NSUInteger)__builtin_ctzll(word);
+            [atoms addIndex:i * ISS_STYLE_CLASS_SET_WORD_BITS + bit];
+            word &= word - 1;
+        }
+    }
+    return atoms;
+}
+
+- (ISSStyleClassSet*) styleClassSetByAddingStyleClass:(NSString*)styleClass {
+    NSUInteger atom = [self.class atomForStyleClass:styleClass];
+    if( [self containsAtom:atom] ) return self;
+    NSMutableIndexSet* atoms = [self atoms];
+    [atoms addIndex:atom];
+    return [[self.class alloc] initWithAtoms:atoms];
+}
+
+- (ISSStyleClassSet*) styleClassSetByRemovingStyleClass:(NSString*)styleClass {
+    NSUInteger atom = [self.class existingAtomForStyleClass:styleClass];
+    if( ![self containsAtom:atom] ) return self;
+    NSMutableIndexSet* atoms = [self atoms];
+    [atoms removeIndex:atom];
+    return atoms.count ? [[self.class alloc] initWithAtoms:atoms] : nil;
+}
+
+
+#pragma mark - Matching
+
+- (NSUInteger) count {
+    return _styleClasses.count;
+}
+
+- (BOOL) containsAtom:(NSUInteger)atom {
+    if( atom == NSNotFound ) return NO;
+    NSUInteger wordIndex = atom / ISS_STYLE_CLASS_SET_WORD_BITS;
+    return wordIndex < _wordCount && (_words[wordIndex] & (1ULL << (atom % ISS_STYLE_CLASS_SET_WORD_BITS))) != 0;
+}
+
+- (BOOL) containsStyleClass:(NSString*)styleClass {
+    return [self containsAtom:[self.class existingAtomForStyleClass:styleClass]];
+}
+
+- (BOOL) containsStyleClassSet:(ISSStyleClassSet*)styleClassSet {
+    if( styleClassSet->_wordCount > _wordCount ) return NO;
+    for(NSUInteger i=0; i<styleClassSet->_wordCount; i++) {
+        if( (_words[i] & styleClassSet->_words[i]) != styleClassSet->_words[i] ) return NO;
+    }
+    return YES;
+}
+
+
+#pragma mark - NSCopying
+
+- (id) copyWithZone:(NSZone*)zone {
+    return self;
+}
+
+
+#pragma mark - NSObject overrides
+
+- (NSString*) description {
+    return [NSString stringWithFormat:@"ISSStyleClassSet(%@)", [[_styleClasses allObjects] componentsJoinedByString:@", "]];
+}
+
+- (BOOL) isEqual:(id)object {
+    if( object == self ) return YES;
+    if( ![object isKindOfClass:ISSStyleClassSet.class] ) return NO;
+    ISSStyleClassSet* other = object;
+    return _wordCount == other->_wordCount && memcmp(_words, other->_words, _wordCount * sizeof(uint64_t)) == 0;
+}
+
+- (NSUInteger) hash {
+    NSUInteger hash = 0;
+    for(NSUInteger i=0; i<_wordCount; i++) {
+        hash = hash * 31 + (NSUInteger)(_words[i] ^ (_words[i] >> 32));
+    }
+    return hash;
+}
+
+@end
@@ -22,6 +22,13 @@ NS_ASSUME_NONNULL_BEGIN
 
 typedef BOOL (^ISSStyleSheetScopeMatcher)(ISSUIElementDetails* elementDetails);
 
+/** Describes which elements may be affected when a style class or element id of an element is changed. */
+typedef NS_OPTIONS(NSUInteger, ISSStyleInvalidation) {
+    ISSStyleInvalidationElement = 0, // Only the element itself is affected
+    ISSStyleInvalidationDescendants = 1 << 0,
+    ISSStyleInvalidationSiblings = 1 << 1,
+};
+
 extern NSString* const ISSStyleSheetRefreshedNotification;
 extern NSString* const ISSStyleSheetRefreshFailedNotification;
 
@@ -57,6 +64,27 @@ extern NSString* const ISSStyleSheetRefreshFailedNotification;
 @end
 
 
+/**
+ * Immutable snapshot of the declarations of a stylesheet, along with the rule index and invalidation sets built from them. A new rule index is created
+ * whenever the declarations of a stylesheet are replaced, which means a rule index obtained on the main thread can safely be used for matching on a
+ * background queue.
+ */
+@interface ISSStyleSheetRuleIndex : NSObject
+
+@property (nonatomic, readonly, nullable) NSArray* declarations; // ISSPropertyDeclarations
+@property (nonatomic, readonly) NSSet* nestedElementKeyPaths; // Key paths used in nested element selectors
+
+- (instancetype) initWithDeclarations:(nullable NSArray*)declarations;
+
+/** Returns the declarations matching the element, without taking any stylesheet scope into account. */
+- (NSArray*) declarationsMatchingElement:(ISSUIElementDetails*)elementDetails stylingContext:(ISSStylingContext*)stylingContext;
+
+- (ISSStyleInvalidation) invalidationForStyleClass:(NSString*)styleClass;
+- (ISSStyleInvalidation) invalidationForElementId:(NSString*)elementId;
+
+@end
+
+
 /**
  * Represents a loaded stylesheet.
  */
@@ -68,6 +96,8 @@ extern NSString* const ISSStyleSheetRefreshFailedNotification;
 @property (nonatomic, readonly) BOOL refreshable;
 @property (nonatomic, readonly) NSString* displayDescription;
 @property (nonatomic, strong, nullable) ISSStyleSheetScope* scope;
+@property (nonatomic, readonly) NSSet* nestedElementKeyPaths; // Key paths used in nested element selectors in this stylesheet
+@property (nonatomic, readonly) ISSStyleSheetRuleIndex* ruleIndex; // The current declarations and rule index - replaced (not mutated) when the declarations change
 
 - (id) initWithStyleSheetURL:(NSURL*)styleSheetURL declarations:(nullable NSArray*)declarations;
 - (id) initWithStyleSheetURL:(NSURL*)styleSheetURL declarations:(nullable NSArray*)declarations refreshable:(BOOL)refreshable;
@@ -77,6 +107,11 @@ extern NSString* const ISSStyleSheetRefreshFailedNotification;
 
 - (nullable ISSPropertyDeclarations*) findPropertyDeclarationsWithSelectorChain:(ISSSelectorChain*)selectorChain;
 
+/** Returns the elements (other than the element itself) whose styling may be affected by a change of the specified style class, based on the non-rightmost selectors in this stylesheet. */
+- (ISSStyleInvalidation) invalidationForStyleClass:(NSString*)styleClass;
+/** Returns the elements (other than the element itself) whose styling may be affected by a change of the specified element id, based on the non-rightmost selectors in this stylesheet. */
+- (ISSStyleInvalidation) invalidationForElementId:(NSString*)elementId;
+
 - (void) refreshStylesheetWithCompletionHandler:(void (^)(void))completionHandler force:(BOOL)force;
 
 @end
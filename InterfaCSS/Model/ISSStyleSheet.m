@@ -15,6 +15,9 @@
 #import "NSMutableArray+ISSAdditions.h"
 #import "InterfaCSS.h"
 #import "ISSStylingContext.h"
+#import "ISSSelectorChain.h"
+#import "ISSSelector.h"
+#import "ISSNestedElementSelector.h"
 
 
 NSString* const ISSStyleSheetRefreshedNotification = @"ISSStyleSheetRefreshedNotification";
@@ -86,6 +89,134 @@ NSString* const ISSStyleSheetRefreshFailedNotification = @"ISSStyleSheetRefreshF
 @end
 
 
+@implementation ISSStyleSheetRuleIndex {
+    // Rule index - maps the element id, style class or type of the rightmost selector in each selector chain to the indices of the matching declarations
+    NSDictionary* _declarationIndicesByElementId;
+    NSDictionary* _declarationIndicesByStyleClass;
+    NSMapTable* _declarationIndicesByType;
+    NSIndexSet* _universalDeclarationIndices; // Declarations with a wildcard (or nested element) rightmost selector - always candidates
+
+    // Invalidation sets - style classes and element ids used in non-rightmost selectors (i.e. before a descendant/child or sibling combinator)
+    NSSet* _descendantInvalidationStyleClasses;
+    NSSet* _descendantInvalidationElementIds;
+    NSSet* _siblingInvalidationStyleClasses;
+    NSSet* _siblingInvalidationElementIds;
+}
+
+static void addDeclarationIndex(NSUInteger index, id key, id bucketContainer) {
+    NSMutableIndexSet* indices = [bucketContainer objectForKey:key];
+    if( !indices ) {
+        indices = [NSMutableIndexSet indexSet];
+        [bucketContainer setObject:indices forKey:key];
+    }
+    [indices addIndex:index];
+}
+
+- (instancetype) initWithDeclarations:(NSArray*)declarations {
+    if( self = [super init] ) {
+        _declarations = [declarations copy];
+
+        NSMutableDictionary* byElementId = [NSMutableDictionary dictionary];
+        NSMutableDictionary* byStyleClass = [NSMutableDictionary dictionary];
+        NSMapTable* byType = [NSMapTable strongToStrongObjectsMapTable];
+        NSMutableIndexSet* universal = [NSMutableIndexSet indexSet];
+        NSMutableSet* descendantStyleClasses = [NSMutableSet set];
+        NSMutableSet* descendantElementIds = [NSMutableSet set];
+        NSMutableSet* siblingStyleClasses = [NSMutableSet set];
+        NSMutableSet* siblingElementIds = [NSMutableSet set];
+        NSMutableSet* nestedElementKeyPaths = [NSMutableSet set];
+
+        [_declarations enumerateObjectsUsingBlock:^(ISSPropertyDeclarations* propertyDeclarations, NSUInteger idx, BOOL* stop) {
+            for(ISSSelectorChain* selectorChain in propertyDeclarations.selectorChains) {
+                // Bucket each chain by the most selective part of its rightmost selector (id, then first style class, then type), since all of these must match for the chain to match
+                ISSSelector* rightmostSelector = [selectorChain.selectorComponents lastObject];
+                if( [rightmostSelector isKindOfClass:ISSNestedElementSelector.class] ) {
+                    [universal addIndex:idx];
+                    [nestedElementKeyPaths addObject:((ISSNestedElementSelector*)rightmostSelector).nestedElementKeyPath];
+                }
+                else if( rightmostSelector.elementId ) addDeclarationIndex(idx, rightmostSelector.elementId, byElementId);
+                else if( rightmostSelector.styleClass ) addDeclarationIndex(idx, rightmostSelector.styleClass, byStyleClass);
+                else if( rightmostSelector.type ) addDeclarationIndex(idx, rightmostSelector.type, byType);
+                else [universal addIndex:idx];
+
+                // Record the style classes and element ids of the non-rightmost selectors, along with the kind of combinator that follows them
+                NSArray* components = selectorChain.selectorComponents;
+                for(NSUInteger i=0; i+2<components.count; i+=2) {
+                    ISSSelector* selector = components[i];
+                    if( [selector isKindOfClass:ISSNestedElementSelector.class] ) {
+                        [nestedElementKeyPaths addObject:((ISSNestedElementSelector*)selector).nestedElementKeyPath];
+                        continue;
+                    }
+                    ISSSelectorCombinator combinator = (ISSSelectorCombinator)[components[i+1] integerValue];
+                    BOOL siblingCombinator = combinator == ISSSelectorCombinatorAdjacentSibling || combinator == ISSSelectorCombinatorGeneralSibling;
+                    if( selector.elementId ) [(siblingCombinator ? siblingElementIds : descendantElementIds) addObject:selector.elementId];
+                    if( selector.styleClasses ) [(siblingCombinator ? siblingStyleClasses : descendantStyleClasses) addObjectsFromArray:selector.styleClasses];
+                }
+            }
+        }];
+
+        _declarationIndicesByElementId = [byElementId copy];
+        _declarationIndicesByStyleClass = [byStyleClass copy];
+        _declarationIndicesByType = byType;
+        _universalDeclarationIndices = [universal copy];
+        _descendantInvalidationStyleClasses = [descendantStyleClasses copy];
+        _descendantInvalidationElementIds = [descendantElementIds copy];
+        _siblingInvalidationStyleClasses = [siblingStyleClasses copy];
+        _siblingInvalidationElementIds = [siblingElementIds copy];
+        _nestedElementKeyPaths = [nestedElementKeyPaths copy];
+    }
+    return self;
+}
+
+- (NSIndexSet*) candidateDeclarationIndicesForElement:(ISSUIElementDetails*)elementDetails {
+    NSMutableIndexSet* candidates = [_universalDeclarationIndices mutableCopy];
+    if( elementDetails.elementId ) {
+        NSIndexSet* indices = _declarationIndicesByElementId[[elementDetails.elementId lowercaseString]];
+        if( indices ) [candidates addIndexes:indices];
+    }
+    for(NSString* styleClass in elementDetails.styleClasses) {
+        NSIndexSet* indices = _declarationIndicesByStyleClass[styleClass];
+        if( indices ) [candidates addIndexes:indices];
+    }
+    if( elementDetails.canonicalType ) {
+        NSIndexSet* indices = [_declarationIndicesByType objectForKey:elementDetails.canonicalType];
+        if( indices ) [candidates addIndexes:indices];
+    }
+    return candidates;
+}
+
+- (NSArray*) declarationsMatchingElement:(ISSUIElementDetails*)elementDetails stylingContext:(ISSStylingContext*)stylingContext {
+    NSMutableArray* matchingDeclarations = [[NSMutableArray alloc] init];
+    // Only test candidate declarations from the rule index (enumerated in declaration order, to maintain cascade order)
+    [[self candidateDeclarationIndicesForElement:elementDetails] enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL* stop) {
+        ISSPropertyDeclarations* declarations = self->_declarations[idx];
+        ISSPropertyDeclarations* matchingDeclarationBlock = [declarations propertyDeclarationsMatchingElement:elementDetails stylingContext:stylingContext];
+        if ( matchingDeclarationBlock ) {
+            ISSLogTrace(@"Matching declarations: %@", matchingDeclarationBlock);
+            [matchingDeclarations addObject:matchingDeclarationBlock];
+        }
+    }];
+    return matchingDeclarations;
+}
+
+- (ISSStyleInvalidation) invalidationForStyleClass:(NSString*)styleClass {
+    ISSStyleInvalidation invalidation = ISSStyleInvalidationElement;
+    if( [_descendantInvalidationStyleClasses containsObject:styleClass] ) invalidation |= ISSStyleInvalidationDescendants;
+    if( [_siblingInvalidationStyleClasses containsObject:styleClass] ) invalidation |= ISSStyleInvalidationSiblings;
+    return invalidation;
+}
+
+- (ISSStyleInvalidation) invalidationForElementId:(NSString*)elementId {
+    elementId = [elementId lowercaseString];
+    ISSStyleInvalidation invalidation = ISSStyleInvalidationElement;
+    if( [_descendantInvalidationElementIds containsObject:elementId] ) invalidation |= ISSStyleInvalidationDescendants;
+    if( [_siblingInvalidationElementIds containsObject:elementId] ) invalidation |= ISSStyleInvalidationSiblings;
+    return invalidation;
+}
+
+@end
+
+
 @interface ISSStyleSheet ()
 
 @property (nonatomic, readwrite, nullable) NSArray* declarations;
@@ -93,7 +224,9 @@ NSString* const ISSStyleSheetRefreshFailedNotification = @"ISSStyleSheetRefreshF
 @end
 
 
-@implementation ISSStyleSheet
+@implementation ISSStyleSheet {
+    ISSStyleSheetRuleIndex* _ruleIndex;
+}
 
 
 #pragma mark - Lifecycle
@@ -108,7 +241,7 @@ NSString* const ISSStyleSheetRefreshFailedNotification = @"ISSStyleSheetRefreshF
 
 - (id) initWithStyleSheetURL:(NSURL*)styleSheetURL declarations:(NSArray*)declarations refreshable:(BOOL)refreshable scope:(ISSStyleSheetScope*)scope {
    if ( (self = [super initWithURL:styleSheetURL]) ) {
-       _declarations = declarations;
+       _ruleIndex = [[ISSStyleSheetRuleIndex alloc] initWithDeclarations:declarations];
        _refreshable = refreshable;
        _active = YES;
        _scope = scope;
@@ -123,30 +256,38 @@ NSString* const ISSStyleSheetRefreshFailedNotification = @"ISSStyleSheetRefreshF
     return self.resourceURL;
 }
 
+- (NSArray*) declarations {
+    return _ruleIndex.declarations;
+}
+
+- (void) setDeclarations:(NSArray*)declarations {
+    // The declarations and the rule index built from them are replaced together, since a rule index may be in use for matching on a background queue
+    _ruleIndex = [[ISSStyleSheetRuleIndex alloc] initWithDeclarations:declarations];
+}
+
+- (ISSStyleSheetRuleIndex*) ruleIndex {
+    return _ruleIndex;
+}
+
+- (NSSet*) nestedElementKeyPaths {
+    return _ruleIndex.nestedElementKeyPaths;
+}
+
 
 #pragma mark - Matching
 
 - (NSArray*) declarationsMatchingElement:(ISSUIElementDetails*)elementDetails stylingContext:(ISSStylingContext*)stylingContext {
     ISSLogTrace(@"Getting matching declarations for %@:", elementDetails.uiElement);
 
-    NSMutableArray* matchingDeclarations = [[NSMutableArray alloc] init];
-
     if( self.scope && ![self.scope elementInScope:elementDetails] ) {
         ISSLogTrace(@"Element not in scope - skipping: %@", elementDetails.uiElement);
-    } else {
-        for (ISSPropertyDeclarations* declarations in _declarations) {
-            ISSPropertyDeclarations* matchingDeclarationBlock = [declarations propertyDeclarationsMatchingElement:elementDetails stylingContext:stylingContext];
-            if ( matchingDeclarationBlock ) {
-                ISSLogTrace(@"Matching declarations: %@", matchingDeclarationBlock);
-                [matchingDeclarations addObject:matchingDeclarationBlock];
-            }
-        }
+        return [[NSMutableArray alloc] init];
     }
-    return matchingDeclarations;
+    return [_ruleIndex declarationsMatchingElement:elementDetails stylingContext:stylingContext];
 }
 
 - (ISSPropertyDeclarations*) findPropertyDeclarationsWithSelectorChain:(ISSSelectorChain*)selectorChain {
-    for (ISSPropertyDeclarations* declarations in _declarations) {
+    for (ISSPropertyDeclarations* declarations in _ruleIndex.declarations) {
         if ( [declarations containsSelectorChain:selectorChain] ) {
             return declarations;
         }
@@ -155,26 +296,39 @@ NSString* const ISSStyleSheetRefreshFailedNotification = @"ISSStyleSheetRefreshF
 }
 
 
+#pragma mark - Invalidation
+
+- (ISSStyleInvalidation) invalidationForStyleClass:(NSString*)styleClass {
+    return [_ruleIndex invalidationForStyleClass:styleClass];
+}
+
+- (ISSStyleInvalidation) invalidationForElementId:(NSString*)elementId {
+    return [_ruleIndex invalidationForElementId:elementId];
+}
+
+
 #pragma mark - Refreshable stylesheet methods
 
 - (void) refreshStylesheetWithCompletionHandler:(void (^)(void))completionHandler force:(BOOL)force {
     [super refreshWithCompletionHandler:^(BOOL success, NSString* responseString, NSError* error) {
         if( success ) {
             NSTimeInterval t = [NSDate timeIntervalSinceReferenceDate];
-            NSMutableArray* declarations = [[InterfaCSS sharedInstance].parser parse:responseString];
-            if( declarations ) {
-                BOOL hasDeclarations = self.declarations != nil;
-                self.declarations = declarations;
-
-                if( hasDeclarations ) ISSLogDebug(@"Reloaded stylesheet '%@' in %f seconds", [self.styleSheetURL lastPathComponent], ([NSDate timeIntervalSinceReferenceDate] - t));
-                else ISSLogDebug(@"Loaded stylesheet '%@' in %f seconds", [self.styleSheetURL lastPathComponent], ([NSDate timeIntervalSinceReferenceDate] - t));
-
-                completionHandler();
-            } else {
-                ISSLogDebug(@"Remote stylesheet didn't contain any declarations!");
-            }
-            
-            [[NSNotificationCenter defaultCenter] postNotificationName:ISSStyleSheetRefreshedNotification object:self];
+            // Parse on a background queue - the declarations are published (and the completion handler invoked) on the main thread
+            [[InterfaCSS sharedInstance] parseStyleSheetData:responseString completionHandler:^(NSMutableArray* declarations) {
+                if( declarations ) {
+                    BOOL hasDeclarations = self.declarations != nil;
+                    self.declarations = declarations;
+
+                    if( hasDeclarations ) ISSLogDebug(@"Reloaded stylesheet '%@' in %f seconds", [self.styleSheetURL lastPathComponent], ([NSDate timeIntervalSinceReferenceDate] - t));
+                    else ISSLogDebug(@"Loaded stylesheet '%@' in %f seconds", [self.styleSheetURL lastPathComponent], ([NSDate timeIntervalSinceReferenceDate] - t));
+
+                    completionHandler();
+                } else {
+                    ISSLogDebug(@"Remote stylesheet didn't contain any declarations!");
+                }
+
+                [[NSNotificationCenter defaultCenter] postNotificationName:ISSStyleSheetRefreshedNotification object:self];
+            }];
         } else {
             [[NSNotificationCenter defaultCenter] postNotificationName:ISSStyleSheetRefreshFailedNotification object:self];
         }
@@ -192,7 +346,7 @@ NSString* const ISSStyleSheetRefreshFailedNotification = @"ISSStyleSheetRefreshF
 
 - (NSString*) displayDescription {
     NSMutableString* str = [NSMutableString string];
-    for(ISSPropertyDeclarations* declarations in _declarations) {
+    for(ISSPropertyDeclarations* declarations in _ruleIndex.declarations) {
         NSString* descr = declarations.displayDescription;
         descr = [descr stringByReplacingOccurrencesOfString:@"\n" withString:@"\n\t"];
         if( str.length == 0 ) [str appendFormat:@"\n\t%@", descr];
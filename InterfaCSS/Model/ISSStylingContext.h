@@ -11,12 +11,20 @@
 NS_ASSUME_NONNULL_BEGIN
 
 
+@class ISSAncestorFilter;
+
+
 @interface ISSStylingContext : NSObject
 
 @property (nonatomic) BOOL ignorePseudoClasses;
 
 @property (nonatomic) BOOL containsPartiallyMatchedDeclarations;
 
+@property (nonatomic, strong, nullable) ISSAncestorFilter* ancestorFilter; // Ancestor filter valid for the element being matched, if any
+
+@property (nonatomic) BOOL snapshotMatching; // Set when matching against an element snapshot (ISSUIElementDetailsSnapshot), i.e. without access to the actual UI element
+@property (nonatomic) BOOL containsDeclarationsRequiringUIElement; // Set if snapshot matching encountered declarations that can only be matched against the actual UI element
+
 + (instancetype) contextIgnoringPseudoClasses;
 
 @end
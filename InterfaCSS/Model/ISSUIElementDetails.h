@@ -11,16 +11,13 @@
 NS_ASSUME_NONNULL_BEGIN
 
 
-@class ISSLayout, ISSUpdatableValue, ISSPropertyDeclaration;
+@class ISSLayout, ISSUpdatableValue, ISSPropertyDeclaration, ISSElementStyleIdentity, ISSStyleClassSet;
 
 
 extern NSString* const ISSIndexPathKey;
 extern NSString* const ISSPrototypeViewInitializedKey;
 
 
-typedef id _Nullable (^ISSUIElementDetailsVisitorBlock)(ISSUIElementDetails* elementDetails);
-
-
 @interface NSObject (ISSUIElementDetails)
 @property (nonatomic, strong, nullable) ISSUIElementDetails* elementDetailsISS;
 @end
@@ -45,6 +42,7 @@ typedef id _Nullable (^ISSUIElementDetailsVisitorBlock)(ISSUIElementDetails* ele
 @property (nonatomic, weak, readonly, nullable) UIViewController* closestViewController; // Closest ancestor view controller
 
 @property (nonatomic, readonly, nullable) NSArray* childElementsForElement;
+@property (nonatomic, readonly) BOOL childElementsAreSubviews; // YES if the child elements are just the subviews of the element (i.e. a plain view without nested elements), meaning childElementsForElement doesn't have to be built
 @property (nonatomic, readonly, nullable) NSDictionary* validNestedElements;
 
 @property (nonatomic, strong, nullable) NSString* elementId;
@@ -56,16 +54,19 @@ typedef id _Nullable (^ISSUIElementDetailsVisitorBlock)(ISSUIElementDetails* ele
 @property (nonatomic, readonly) BOOL stylesCacheable;
 @property (nonatomic) BOOL cachedStylingInformationDirty;
 
-@property (nonatomic, strong, readonly, nullable) NSString* elementStyleIdentityPath;
+@property (nonatomic, strong, readonly, nullable) ISSElementStyleIdentity* styleIdentity; // Interned identity of the element style identity path - used as key when caching styles
+@property (nonatomic, strong, readonly, nullable) NSString* elementStyleIdentityPath; // Readable representation of styleIdentity, built lazily
 @property (nonatomic, readonly) BOOL ancestorHasElementId;
 @property (nonatomic, strong, nullable) NSString* customElementStyleIdentity;
 @property (nonatomic, readonly) BOOL ancestorUsesCustomElementStyleIdentity;
 
 @property (nonatomic, weak, nullable) NSMutableArray* cachedDeclarations; // Optimization for quick access to cached declarations
+@property (nonatomic, strong, nullable) NSArray* cachedEffectiveStyles; // Merged property declarations of cachedDeclarations - only set if declarations don't contain pseudo classes (cleared when cachedDeclarations changes)
 @property (nonatomic) BOOL stylesFullyResolved;
 
 @property (nonatomic, weak, nullable) Class canonicalType;
 @property (nonatomic, strong, nullable) NSSet* styleClasses;
+@property (nonatomic, strong, nullable) ISSStyleClassSet* styleClassSet; // Atom bitset representation of styleClasses (setting either property updates the other)
 
 @property (nonatomic) BOOL stylingApplied; // Indicates if styles have been applied to element
 @property (nonatomic) BOOL stylingDisabled;
@@ -82,7 +83,7 @@ typedef id _Nullable (^ISSUIElementDetailsVisitorBlock)(ISSUIElementDetails* ele
 
 @property (nonatomic, strong, readonly, nullable) NSMutableDictionary* prototypes;
 
-@property (nonatomic, readonly) BOOL isVisiting;
+@property (nonatomic) NSUInteger traversalEpoch; // Epoch of the last traversal (ISSElementTraversal) that visited the element - used for cycle protection
 
 
 - (id) initWithUIElement:(id)uiElement;
@@ -92,6 +93,9 @@ typedef id _Nullable (^ISSUIElementDetailsVisitorBlock)(ISSUIElementDetails* ele
 + (void) resetAllCachedData;
 - (void) resetCachedData;
 - (void) resetCachedData:(BOOL)resetTypeRelatedInformation;
+- (void) resetCachedStyleIdentity:(BOOL)resetCachedStyles; // Resets the style identity, and optionally the cached declarations and effective styles obtained using it (used when the style identity of an ancestor has changed)
+
+- (nullable ISSElementStyleIdentity*) styleIdentityWithParentStyleIdentity:(nullable ISSElementStyleIdentity*)parentStyleIdentity; // Style identity of this element, given the style identity of the parent element
 
 - (void) typeQualifiedPositionInParent:(NSInteger*)position count:(NSInteger*)count;
 
@@ -105,7 +109,11 @@ typedef id _Nullable (^ISSUIElementDetailsVisitorBlock)(ISSUIElementDetails* ele
 - (void) observeUpdatableValue:(ISSUpdatableValue*)value forProperty:(ISSPropertyDeclaration*)propertyDeclaration;
 - (void) stopObservingUpdatableValueForProperty:(ISSPropertyDeclaration*)propertyDeclaration;
 
-- (nullable id) visitExclusivelyWithScope:(const void*)scope visitorBlock:(ISSUIElementDetailsVisitorBlock)visitorBlock;
+/** Returns `YES` if `value` is the same as the value last applied to this element for the specified property declaration (i.e. the same property and parameters). */
+- (BOOL) isLastAppliedValue:(id)value forProperty:(ISSPropertyDeclaration*)propertyDeclaration;
+- (void) setLastAppliedValue:(nullable id)value forProperty:(ISSPropertyDeclaration*)propertyDeclaration;
+/** Discards the last applied values of all property declarations not present in `propertyDeclarations`. */
+- (void) retainLastAppliedValuesForProperties:(NSArray*)propertyDeclarations;
 
 @end
 
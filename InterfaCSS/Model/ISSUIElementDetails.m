@@ -14,6 +14,8 @@
 #import "ISSUpdatableValue.h"
 #import "ISSPropertyDeclaration.h"
 #import "ISSRuntimeIntrospectionUtils.h"
+#import "ISSElementStyleIdentity.h"
+#import "ISSStyleClassSet.h"
 
 
 NSString* const ISSIndexPathKey = @"ISSIndexPathKey";
@@ -43,16 +45,12 @@ NSString* const ISSUIElementDetailsResetCachedDataNotificationName = @"ISSUIElem
 
 //@property (nonatomic) BOOL hasChangedParent;
 
-@property (nonatomic, strong, readwrite) NSString* elementStyleIdentityPath;
-@property (nonatomic, strong) NSString* elementStyleIdentity;
+@property (nonatomic, strong, readwrite) ISSElementStyleIdentity* styleIdentity;
 
 @property (nonatomic, strong, readwrite) NSDictionary* validNestedElements;
 
 @property (nonatomic, weak, readwrite) UIViewController* closestViewController;
 
-@property (nonatomic, readwrite) BOOL ancestorHasElementId;
-@property (nonatomic, readwrite) BOOL ancestorUsesCustomElementStyleIdentity;
-
 @property (nonatomic, strong, readwrite) NSSet* disabledProperties;
 
 @property (nonatomic, strong) NSMutableDictionary* additionalDetails;
@@ -60,9 +58,7 @@ NSString* const ISSUIElementDetailsResetCachedDataNotificationName = @"ISSUIElem
 @property (nonatomic, strong) NSMutableDictionary* prototypes;
 
 @property (nonatomic, strong) NSMapTable* observedUpdatableValues;
-
-@property (nonatomic, readwrite) BOOL isVisiting;
-@property (nonatomic) const void* visitorScope;
+@property (nonatomic, strong) NSMapTable* lastAppliedValues; // ISSPropertyDeclaration -> last value applied to element
 
 @end
 
@@ -74,7 +70,6 @@ NSString* const ISSUIElementDetailsResetCachedDataNotificationName = @"ISSUIElem
     self = [super init];
     if (self) {
         _uiElement = uiElement;
-        _visitorScope = NULL;
         
         [self parentElement]; // Make sure weak reference to super view is set directly
 
@@ -102,16 +97,14 @@ NSString* const ISSUIElementDetailsResetCachedDataNotificationName = @"ISSUIElem
     
     copy.layout = self.layout;
 
-    copy->_elementStyleIdentity = _elementStyleIdentity;
-    copy->_elementStyleIdentityPath = _elementStyleIdentityPath;
-    copy.ancestorHasElementId = self.ancestorHasElementId;
     copy.customElementStyleIdentity = self.customElementStyleIdentity;
-    copy.ancestorUsesCustomElementStyleIdentity = self.ancestorUsesCustomElementStyleIdentity;
+    copy->_styleIdentity = _styleIdentity;
 
     copy.cachedDeclarations = self.cachedDeclarations;
+    copy.cachedEffectiveStyles = self.cachedEffectiveStyles;
     
     copy.canonicalType = self.canonicalType;
-    copy.styleClasses = self.styleClasses;
+    copy.styleClassSet = self.styleClassSet;
 
     copy.stylingApplied = self.stylingApplied;
     copy.stylingDisabled = self.stylingDisabled;
@@ -138,62 +131,27 @@ NSString* const ISSUIElementDetailsResetCachedDataNotificationName = @"ISSUIElem
     else return [self findParent:parentView.superview ofClass:class];
 }
 
-- (NSString*) classNamesStyleIdentityFragment {
-    if( self.styleClasses.count == 0 ) {
-        return @"";
-    } else {
-        NSArray* styleClasses = [[self.styleClasses allObjects] sortedArrayUsingComparator:^NSComparisonResult(NSString* obj1, NSString* obj2) {
-            return [obj1 compare:obj2];
-        }];
-        NSMutableString* str = [NSMutableString stringWithString:@"["];
-        [str appendString:[styleClasses componentsJoinedByString:@","]];
-        [str appendString:@"]"];
-        return [str copy];
-    }
-}
-
-- (void) updateElementStyleIdentity {
+- (ISSElementStyleIdentity*) styleIdentityWithParentStyleIdentity:(ISSElementStyleIdentity*)parentStyleIdentity {
     if( self.customElementStyleIdentity ) {
-        self.elementStyleIdentity = self.elementStyleIdentityPath = [NSString stringWithFormat:@"@%@%@", self.customElementStyleIdentity, [self classNamesStyleIdentityFragment]]; // Prefix custom style id with @
+        return [ISSElementStyleIdentity identityWithCustomStyleIdentity:self.customElementStyleIdentity styleClasses:self.styleClassSet]; // Custom style id (prefixed with @ in path) - path will only contain the custom style id itself
     }
     else if( self.elementId ) {
-        self.elementStyleIdentity = self.elementStyleIdentityPath = [NSString stringWithFormat:@"#%@%@", self.elementId, [self classNamesStyleIdentityFragment]]; // Prefix element id with #
+        return [ISSElementStyleIdentity identityWithElementId:self.elementId styleClasses:self.styleClassSet]; // Element id (prefixed with # in path) - path will only contain the element id itself
     }
     else if( self.nestedElementKeyPath ) {
-        self.elementStyleIdentity = self.elementStyleIdentityPath = [NSString stringWithFormat:@"$%@", self.nestedElementKeyPath]; // Prefix nested elements with $
-    }
-    else if( self.styleClasses ) {
-        NSMutableString* str = [NSMutableString stringWithString:NSStringFromClass(self.canonicalType)];
-        [str appendString:[self classNamesStyleIdentityFragment]];
-        self.elementStyleIdentity = [str copy];
-    }
-    else {
-        self.elementStyleIdentity = NSStringFromClass(self.canonicalType);
+        return [ISSElementStyleIdentity identityWithNestedElementKeyPath:self.nestedElementKeyPath parent:parentStyleIdentity]; // Nested elements are prefixed with $ in path
+    } else {
+        return [ISSElementStyleIdentity identityWithType:self.canonicalType styleClasses:self.styleClassSet parent:parentStyleIdentity];
     }
 }
 
-- (void) updateElementStyleIdentityPath {
-    // Update style identity of element, if needed
-    [self elementStyleIdentity];
-    
-    if( self.elementId || self.customElementStyleIdentity ) return; // If element uses element Id, or custom style id, elementStyleIdentityPath will have been set by call above, and will only contain the element Id itself
-    
-    if( self.parentElement ) {
+- (void) updateStyleIdentity {
+    ISSElementStyleIdentity* parentStyleIdentity = nil;
+    if( !self.customElementStyleIdentity && !self.elementId && self.parentElement ) { // Parent only part of identity if element has no custom style id or element id
         ISSUIElementDetails* parentDetails = [[InterfaCSS sharedInstance] detailsForUIElement:self.parentElement];
-        NSString* parentStyleIdentityPath = parentDetails.elementStyleIdentityPath;
-        // Check if an ancestor has an element id (i.e. style identity path will contain #someParentElementId) - this information will be used to determine if styles can be cacheable or not
-        self.ancestorHasElementId = [parentStyleIdentityPath hasPrefix:@"#"] || [parentStyleIdentityPath rangeOfString:@" #"].location != NSNotFound;
-        self.ancestorUsesCustomElementStyleIdentity = [parentStyleIdentityPath hasPrefix:@"@"] || [parentStyleIdentityPath rangeOfString:@" @"].location != NSNotFound;
-        
-        // Concatenate parent elementStyleIdentityPath of parent with the elementStyleIdentity of this element, separated by a space:
-        if( parentStyleIdentityPath ) self.elementStyleIdentityPath = [NSString stringWithFormat:@"%@ %@", parentDetails.elementStyleIdentityPath, self.elementStyleIdentity];
-        else self.elementStyleIdentityPath = self.elementStyleIdentity;
-    } else {
-        self.ancestorHasElementId = NO;
-        self.ancestorUsesCustomElementStyleIdentity = NO;
-        
-        self.elementStyleIdentityPath = self.elementStyleIdentity;
+        parentStyleIdentity = parentDetails.styleIdentity;
     }
+    self.styleIdentity = [self styleIdentityWithParentStyleIdentity:parentStyleIdentity];
 }
 
 
@@ -221,12 +179,23 @@ NSString* const ISSUIElementDetailsResetCachedDataNotificationName = @"ISSUIElem
     return self.stylingDisabled && self.stylingApplied;
 }
 
+- (void) setCachedDeclarations:(NSMutableArray*)cachedDeclarations {
+    if( cachedDeclarations != _cachedDeclarations ) _cachedEffectiveStyles = nil; // Merged styles are only valid for the declarations they were created from
+    _cachedDeclarations = cachedDeclarations;
+}
+
 - (BOOL) stylingAppliedAndStatic {
     return self.stylingApplied && !self.stylesContainPseudoClassesOrDynamicProperties;
 }
 
 + (void) resetAllCachedData {
-    [[NSNotificationCenter defaultCenter] postNotificationName:ISSUIElementDetailsResetCachedDataNotificationName object:nil];
+    if( [NSThread isMainThread] ) {
+        [[NSNotificationCenter defaultCenter] postNotificationName:ISSUIElementDetailsResetCachedDataNotificationName object:nil];
+    } else { // May happen when new type selector classes are registered while parsing stylesheets on a background queue
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [[NSNotificationCenter defaultCenter] postNotificationName:ISSUIElementDetailsResetCachedDataNotificationName object:nil];
+        });
+    }
 }
 
 - (void) resetCachedData:(BOOL)resetTypeRelatedInformation {
@@ -236,7 +205,7 @@ NSString* const ISSUIElementDetailsResetCachedDataNotificationName = @"ISSUIElem
     }
     
     // Identity and structure:
-    _elementStyleIdentityPath = nil; // Will result in re-evaluation of elementStyleIdentityPath, ancestorHasElementId and ancestorUsesCustomElementStyleIdentity
+    _styleIdentity = nil; // Will result in re-evaluation of styleIdentity (and thus elementStyleIdentityPath, ancestorHasElementId and ancestorUsesCustomElementStyleIdentity)
     _closestViewController = nil;
     
     // Reset fields related to style caching
@@ -244,12 +213,22 @@ NSString* const ISSUIElementDetailsResetCachedDataNotificationName = @"ISSUIElem
     _stylesFullyResolved = NO;
     _stylesContainPseudoClassesOrDynamicProperties = NO;
     _cachedDeclarations = nil; // Note: this just clears a weak ref - cache will still remain in class InterfaCSS (unless cleared at the same time)
+    _cachedEffectiveStyles = nil;
+    _lastAppliedValues = nil; // Make sure all property values are applied the next time styling is applied
 }
 
 - (void) resetCachedData {
     [self resetCachedData:YES];
 }
 
+- (void) resetCachedStyleIdentity:(BOOL)resetCachedStyles {
+    _styleIdentity = nil;
+    if( resetCachedStyles ) {
+        _cachedDeclarations = nil;
+        _cachedEffectiveStyles = nil;
+    }
+}
+
 - (UIView*) view {
     return [self.uiElement isKindOfClass:UIView.class] ? self.uiElement : nil;
 }
@@ -325,34 +304,44 @@ NSString* const ISSUIElementDetailsResetCachedDataNotificationName = @"ISSUIElem
 
 - (void) setElementId:(NSString*)elementId {
     _elementId = elementId;
-    _elementStyleIdentityPath = _elementStyleIdentity = nil; // Reset style identity to force refresh
+    _styleIdentity = nil; // Reset style identity to force refresh
     _cachedStylingInformationDirty = YES;
 }
 
 - (void) setStyleClasses:(NSSet*)styleClasses {
-    _styleClasses = styleClasses;
-    _elementStyleIdentityPath = _elementStyleIdentity = nil; // Reset style identity to force refresh
+    self.styleClassSet = [ISSStyleClassSet styleClassSetWithStyleClasses:styleClasses];
+}
+
+- (void) setStyleClassSet:(ISSStyleClassSet*)styleClassSet {
+    _styleClassSet = styleClassSet;
+    _styleClasses = styleClassSet.styleClasses;
+    _styleIdentity = nil; // Reset style identity to force refresh
     _cachedStylingInformationDirty = YES;
 }
 
 - (void) setCustomElementStyleIdentity:(NSString*)customElementStyleIdentity {
     _customElementStyleIdentity = customElementStyleIdentity;
-    _elementStyleIdentityPath = _elementStyleIdentity = nil; // Reset style identity to force refresh
+    _styleIdentity = nil; // Reset style identity to force refresh
     _cachedStylingInformationDirty = YES;
 }
 
-- (NSString*) elementStyleIdentity {
-    if( !_elementStyleIdentity ) {
-        [self updateElementStyleIdentity];
+- (ISSElementStyleIdentity*) styleIdentity {
+    if( !_styleIdentity ) {
+        [self updateStyleIdentity];
     }
-    return _elementStyleIdentity;
+    return _styleIdentity;
 }
 
 - (NSString*) elementStyleIdentityPath {
-    if( !_elementStyleIdentityPath ) {
-        [self updateElementStyleIdentityPath];
-    }
-    return _elementStyleIdentityPath;
+    return self.styleIdentity.path;
+}
+
+- (BOOL) ancestorHasElementId {
+    return self.styleIdentity.parent.containsElementId;
+}
+
+- (BOOL) ancestorUsesCustomElementStyleIdentity {
+    return self.styleIdentity.parent.containsCustomStyleIdentity;
 }
 
 - (NSMutableDictionary*) additionalDetails {
@@ -476,6 +465,14 @@ NSString* const ISSUIElementDetailsResetCachedDataNotificationName = @"ISSUIElem
     return _validNestedElements;
 }
 
+- (BOOL) childElementsAreSubviews {
+#if TARGET_OS_TV == 0
+    if( [self.view isKindOfClass:UIToolbar.class] ) return NO;
+#endif
+    if( [self.view isKindOfClass:UINavigationBar.class] || [self.view isKindOfClass:UITabBar.class] ) return NO;
+    return self.validNestedElements.count == 0;
+}
+
 - (NSArray*) childElementsForElement {
     NSMutableOrderedSet* subviews = self.view.subviews ? [[NSMutableOrderedSet alloc] initWithArray:self.view.subviews] : [[NSMutableOrderedSet alloc] init];
     
@@ -561,6 +558,31 @@ NSString* const ISSUIElementDetailsResetCachedDataNotificationName = @"ISSUIElem
     [self.observedUpdatableValues setObject:value forKey:propertyDeclaration];
 }
 
+- (BOOL) isLastAppliedValue:(id)value forProperty:(ISSPropertyDeclaration*)propertyDeclaration {
+    id lastAppliedValue = [self.lastAppliedValues objectForKey:propertyDeclaration];
+    return lastAppliedValue && (lastAppliedValue == value || [lastAppliedValue isEqual:value]);
+}
+
+- (void) setLastAppliedValue:(id)value forProperty:(ISSPropertyDeclaration*)propertyDeclaration {
+    if( value ) {
+        if( !self.lastAppliedValues ) {
+            self.lastAppliedValues = [NSMapTable strongToStrongObjectsMapTable];
+        }
+        [self.lastAppliedValues setObject:value forKey:propertyDeclaration];
+    } else {
+        [self.lastAppliedValues removeObjectForKey:propertyDeclaration];
+    }
+}
+
+- (void) retainLastAppliedValuesForProperties:(NSArray*)propertyDeclarations {
+    if( !self.lastAppliedValues.count ) return;
+
+    NSSet* retainedProperties = [NSSet setWithArray:propertyDeclarations];
+    for(ISSPropertyDeclaration* propertyDeclaration in [[self.lastAppliedValues keyEnumerator] allObjects]) {
+        if( ![retainedProperties containsObject:propertyDeclaration] ) [self.lastAppliedValues removeObjectForKey:propertyDeclaration];
+    }
+}
+
 - (void) stopObservingUpdatableValueForProperty:(ISSPropertyDeclaration*)propertyDeclaration {
     ISSUpdatableValue* value = [self.observedUpdatableValues objectForKey:propertyDeclaration];
     if( value ) {
@@ -576,30 +598,10 @@ NSString* const ISSUIElementDetailsResetCachedDataNotificationName = @"ISSUIElem
     }
 }
 
-- (id) visitExclusivelyWithScope:(const void*)scope visitorBlock:(ISSUIElementDetailsVisitorBlock)visitorBlock {
-    if( !_isVisiting || scope != _visitorScope ) {
-        const void* previousScope = _visitorScope;
-        @try {
-            _isVisiting = YES;
-            _visitorScope = scope;
-            return visitorBlock(self);
-        }
-        @finally {
-            _visitorScope = previousScope;
-            if (_visitorScope == NULL) {
-                _isVisiting = NO;
-            }
-        }
-    } else {
-        return nil; // Already vising element - aborting
-    }
-}
-
-
 #pragma mark - NSObject overrides
 
 - (NSString*) description {
-    return [NSString stringWithFormat:@"ElementDetails(%@)", self.elementStyleIdentity];
+    return [NSString stringWithFormat:@"ElementDetails(%@)", self.styleIdentity];
 }
 
 @end
@@ -0,0 +1,52 @@
+//
+//  ISSUIElementDetailsSnapshot.h
+//  Part of InterfaCSS - http://www.github.com/tolo/InterfaCSS
+//
+//  Copyright (c) Tobias Löfstrand, Leafnode AB.
+//  License: MIT (http://www.github.com/tolo/InterfaCSS/LICENSE)
+//
+
+#import "ISSUIElementDetails.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+/**
+ * Immutable snapshot of the information about an element that is used during selector matching (i.e. type, element id, style classes, style identity and
+ * parent/owner element), which makes it possible to match selectors against the element off the main thread. The parent and owner elements of a snapshot
+ * are themselves snapshots, and a snapshot is its own element details (i.e. `-[InterfaCSS detailsForUIElement:]` returns the snapshot itself). A snapshot has
+ * no reference to the actual UI element, and its style identity is derived from the parent snapshot (which makes it possible to snapshot elements that
+ * haven't been added to their parent yet).
+ */
+@interface ISSUIElementDetailsSnapshot : ISSUIElementDetails
+
+/**
+ * Creates a snapshot of the specified element details - must be called on the main thread. Parent and owner snapshots are set separately.
+ */
+- (instancetype) initWithElementDetails:(ISSUIElementDetails*)elementDetails;
+
+/**
+ * Creates a snapshot (and snapshots of all ancestors) of an element from an element style identity path (see `-[ISSUIElementDetails elementStyleIdentityPath]`),
+ * for instance `UIWindow UIView[main] UITableView UITableViewCell[card] $contentView UILabel`. Returns `nil` if the path cannot be parsed. Styles resolved
+ * for such a snapshot are only cacheable if they are fully resolved (see `-[ISSUIElementDetails stylesFullyResolved]`).
+ */
++ (nullable instancetype) snapshotWithStyleIdentityPath:(NSString*)styleIdentityPath;
+
+@property (nonatomic, strong, nullable) ISSUIElementDetailsSnapshot* parentSnapshot;
+@property (nonatomic, strong, nullable) ISSUIElementDetailsSnapshot* ownerSnapshot;
+
+/** Indicates if the element has been added to the view hierarchy - always `YES` if the parent snapshot has been added to the view hierarchy. */
+@property (nonatomic) BOOL addedToViewHierarchy;
+
+/** The nested element key paths (of the ones used in stylesheets) by which the element is known in its owner element, if any. */
+@property (nonatomic, strong, nullable) NSSet* nestedElementKeyPaths;
+
+/** The declarations matching the element, as resolved from the snapshot. */
+@property (nonatomic, strong, nullable) NSMutableArray* resolvedDeclarations;
+/** The merged and transformed styles of `resolvedDeclarations`, if the styles are fully determined by the element style identity. */
+@property (nonatomic, strong, nullable) NSArray* resolvedStyles;
+
+@end
+
+
+NS_ASSUME_NONNULL_END
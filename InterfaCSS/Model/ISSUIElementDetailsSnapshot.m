@@ -0,0 +1,123 @@
+//
+//  ISSUIElementDetailsSnapshot.m
+//  Part of InterfaCSS - http://www.github.com/tolo/InterfaCSS
+//
+//  Copyright (c) Tobias Löfstrand, Leafnode AB.
+//  License: MIT (http://www.github.com/tolo/InterfaCSS/LICENSE)
+//
+
+#import "ISSUIElementDetailsSnapshot.h"
+
+
+@implementation ISSUIElementDetailsSnapshot {
+    ISSElementStyleIdentity* _snapshotStyleIdentity;
+    BOOL _styleIdentityPathSnapshot;
+}
+
+@synthesize addedToViewHierarchy = _addedToViewHierarchy;
+
+- (instancetype) initWithElementDetails:(ISSUIElementDetails*)elementDetails {
+    if( (self = [super init]) ) {
+        self.canonicalType = elementDetails.canonicalType;
+        self.elementId = elementDetails.elementId;
+        self.styleClassSet = elementDetails.styleClassSet;
+        self.nestedElementKeyPath = elementDetails.nestedElementKeyPath;
+        self.customElementStyleIdentity = elementDetails.customElementStyleIdentity;
+        _addedToViewHierarchy = elementDetails.addedToViewHierarchy;
+    }
+    return self;
+}
+
++ (instancetype) snapshotWithStyleIdentityPath:(NSString*)styleIdentityPath {
+    ISSUIElementDetailsSnapshot* snapshot = nil;
+    NSArray* components = [styleIdentityPath componentsSeparatedByCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]];
+    for(NSString* component in components) {
+        if( component.length == 0 ) continue;
+
+        ISSUIElementDetailsSnapshot* parentSnapshot = snapshot;
+        snapshot = [[self alloc] init];
+
+        // Local path: "Type[class1,class2]", "#elementId[class1]", "@customStyleIdentity[class1]" or "$nestedElementKeyPath"
+        NSString* name = component;
+        NSRange styleClassesRange = [component rangeOfString:@"["];
+        if( styleClassesRange.location != NSNotFound && [component hasSuffix:@"]"] ) {
+            name = [component substringToIndex:styleClassesRange.location];
+            NSString* styleClasses = [component substringWithRange:NSMakeRange(styleClassesRange.location + 1, component.length - styleClassesRange.location - 2)];
+            snapshot.styleClasses = [NSSet setWithArray:[styleClasses componentsSeparatedByString:@","]];
+        }
+        if( name.length == 0 ) return nil;
+
+        unichar prefix = [name characterAtIndex:0];
+        if( prefix == '#' ) {
+            snapshot.elementId = [name substringFromIndex:1];
+        } else if( prefix == '@' ) {
+            snapshot.customElementStyleIdentity = [name substringFromIndex:1];
+        } else if( prefix == '$' ) {
+            snapshot.nestedElementKeyPath = [name substringFromIndex:1];
+            snapshot.nestedElementKeyPaths = [NSSet setWithObject:snapshot.nestedElementKeyPath];
+            snapshot.ownerSnapshot = parentSnapshot;
+        } else {
+            snapshot.canonicalType = NSClassFromString(name);
+            if( !snapshot.canonicalType ) return nil;
+        }
+
+        // Element ids and custom style identities aren't qualified by the parent path
+        if( !snapshot.elementId && !snapshot.customElementStyleIdentity ) {
+            snapshot.parentSnapshot = parentSnapshot;
+            if( !snapshot.ownerSnapshot ) snapshot.ownerSnapshot = parentSnapshot;
+        }
+    }
+    snapshot->_styleIdentityPathSnapshot = YES;
+    return snapshot;
+}
+
+
+#pragma mark - ISSUIElementDetails overrides
+
+- (ISSUIElementDetails*) elementDetailsISS {
+    return self;
+}
+
+- (id) uiElement {
+    return nil;
+}
+
+- (UIView*) view {
+    return nil;
+}
+
+- (id) parentElement {
+    return self.parentSnapshot;
+}
+
+- (id) ownerElement {
+    return self.ownerSnapshot;
+}
+
+- (UIView*) parentView {
+    return nil;
+}
+
+- (UIViewController*) closestViewController {
+    return nil;
+}
+
+- (ISSElementStyleIdentity*) styleIdentity {
+    if( !_snapshotStyleIdentity ) _snapshotStyleIdentity = [self styleIdentityWithParentStyleIdentity:self.parentSnapshot.styleIdentity];
+    return _snapshotStyleIdentity;
+}
+
+- (BOOL) addedToViewHierarchy {
+    return _addedToViewHierarchy || self.parentSnapshot.addedToViewHierarchy;
+}
+
+- (BOOL) stylesCacheable {
+    // A style identity path doesn't say anything about the actual element, so only styles that are fully resolved from the path can be cached
+    return !_styleIdentityPathSnapshot && [super stylesCacheable];
+}
+
+- (NSString*) description {
+    return [NSString stringWithFormat:@"ElementDetailsSnapshot(%@)", self.styleIdentity];
+}
+
+@end
@@ -11,8 +11,22 @@
 NS_ASSUME_NONNULL_BEGIN
 
 
+@class ISSTransformedValueCache;
+
+
 @interface ISSDefaultStyleSheetParser : NSObject <ISSStyleSheetParser>
 
+/**
+ * Use the parser combinator based stylesheet grammar, instead of the (faster) hand-written tokenizer, when parsing stylesheets. Mainly intended for verification
+ * purposes, since both produce the same result. Default is `NO`.
+ */
+@property (nonatomic) BOOL useCombinatorParser;
+
+/**
+ * The (size bounded) cache of transformed property values, shared by all stylesheets parsed by this parser.
+ */
+@property (nonatomic, strong, readonly) ISSTransformedValueCache* transformedValueCache;
+
 @end
 
 
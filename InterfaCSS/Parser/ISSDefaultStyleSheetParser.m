@@ -10,6 +10,8 @@
 
 #import "ISSParser.h"
 #import "ISSParser+CSS.h"
+#import "ISSStyleSheetTokenizer.h"
+#import "ISSTransformedValueCache.h"
 #import "ISSSelector.h"
 #import "ISSNestedElementSelector.h"
 #import "ISSSelectorChain.h"
@@ -142,6 +144,9 @@ static NSObject* ISSLayoutAttributeSizeToFitFlag;
 /**
  * ISSDefaultStyleSheetParser
  */
+@interface ISSDefaultStyleSheetParser () <ISSStyleSheetTokenizerDelegate>
+@end
+
 @implementation ISSDefaultStyleSheetParser {
     // Common parsers
     ISSParser* dot;
@@ -164,9 +169,9 @@ static NSObject* ISSLayoutAttributeSizeToFitFlag;
     NSMutableDictionary* typeToParser;
     ISSParser* enumValueParser;
     ISSParser* enumBitMaskValueParser;
-    NSMutableDictionary* transformedValueCache;
 
     ISSParser* cssParser;
+    ISSStyleSheetTokenizer* tokenizer;
 }
 
 + (void) initialize {
@@ -524,24 +529,15 @@ static NSObject* ISSLayoutAttributeSizeToFitFlag;
 }
 
 - (id) transformValueWithCaching:(NSString*)propertyValue forProperty:(ISSPropertyDefinition*)p {
-    id transformedValue = nil;
-    NSMutableDictionary* cache = nil;
-
     // Caching is not supported for anonymous properties
-    if( !p.anonymous ) {
-        cache = transformedValueCache[p.uniqueTypeDescription];
-        transformedValue = cache[propertyValue];
-        if ( !cache ) {
-            cache = [[NSMutableDictionary alloc] init];
-            transformedValueCache[p.uniqueTypeDescription] = cache;
-        }
-    }
+    BOOL useCache = !p.anonymous;
+    id transformedValue = useCache ? [_transformedValueCache transformedValueForRawValue:propertyValue property:p] : nil;
 
     // Transform value if not already transformed (and cached)
     if( !transformedValue ) {
         transformedValue = [self doTransformValue:propertyValue forProperty:p];
-        if( transformedValue ) { // Update cache with transformed value
-            cache[propertyValue] = transformedValue;
+        if( transformedValue && useCache ) { // Update cache with transformed value
+            [_transformedValueCache setTransformedValue:transformedValue forRawValue:propertyValue property:p];
         }
     }
 
@@ -1238,24 +1234,14 @@ static NSObject* ISSLayoutAttributeSizeToFitFlag;
 
     /** -- Unrecognized line -- **/
     ISSParser* unrecognizedLine = [[self unrecognizedLineParser] transform:^id(id value) {
-        if( [value iss_hasData] ) return [ISSStyleSheetParserBadData badDataWithDescription:[NSString stringWithFormat:@"Unrecognized property line: '%@'", [value iss_trim]]];
+        if( [value iss_hasData] ) return [blockSelf badDataWithDescription:[NSString stringWithFormat:@"Unrecognized property line: '%@'", [value iss_trim]]];
         else return [NSNull null];
     } name:@"unrecognizedLine"];
 
 
     /** -- Property pair -- **/
     ISSParser* propertyPairParser = [[ISSParser iss_propertyPairParser:NO] transform:^id(id value) {
-        ISSPropertyDeclaration* declaration = [blockSelf transformPropertyPair:value];
-        // If this declaration contains a reference to a nested element - return a nested ruleset declaration containing the property declaration, instead of the property declaration itself
-        if( declaration.nestedElementKeyPath ) {
-            ISSSelector* nestedElementSelector = [ISSNestedElementSelector selectorWithNestedElementKeyPath:declaration.nestedElementKeyPath];
-            ISSSelectorChain* chain = [ISSSelectorChain selectorChainWithComponents:@[nestedElementSelector]];
-            ISSSelectorChainsDeclaration* chains = [ISSSelectorChainsDeclaration selectorChainsWithArray:[@[chain] mutableCopy]];
-            chains.properties = [@[declaration] mutableCopy];
-            return chains;
-        } else {
-            return declaration;
-        }
+        return [blockSelf propertyDeclarationWithName:value[0] value:value[1]];
     } name:@"propertyPair"];
 
     
@@ -1264,8 +1250,7 @@ static NSObject* ISSLayoutAttributeSizeToFitFlag;
     
     /** -- Extension/Inheritance -- **/
     ISSParser* extendDeclarationParser = [[ISSParser sequential:@[[ISSParser stringEQIgnoringCase:@"@extend"], optional_s, optionalColon, [ISSParser spaces], selectorChainParser, [ISSParser unichar:';' skipSpaces:YES]]] transform:^id(id value) {
-        ISSSelectorChain* selectorChain = elementOrNil(value, 4);
-        return [ISSDeclarationExtension extensionOfDeclaration:selectorChain];
+        return [blockSelf declarationExtensionWithSelectorChain:elementOrNil(value, 4)];
     } name:@"pseudoClassParameterParser"];
 
 
@@ -1274,7 +1259,7 @@ static NSObject* ISSLayoutAttributeSizeToFitFlag;
     NSCharacterSet* bracesSet = [NSCharacterSet characterSetWithCharactersInString:@"{}"];
     ISSParser* anythingButBraces = [ISSParser takeUntilInSet:bracesSet minCount:1];
     ISSParser* unsupportedNestedRulesetParser = [[anythingButBraces then:[anythingButBraces between:openBraceSkipSpace and:closeBraceSkipSpace]] transform:^id(id value) {
-        return [ISSStyleSheetParserBadData badDataWithDescription:[NSString stringWithFormat:@"Unsupported nested ruleset: '%@'", value]];
+        return [blockSelf badDataWithDescription:[NSString stringWithFormat:@"Unsupported nested ruleset: '%@'", value]];
     } name:@"unsupportedNestedRuleset"];
 
         
@@ -1294,10 +1279,9 @@ static NSObject* ISSLayoutAttributeSizeToFitFlag;
 }
 
 - (ISSParser*) rulesetParserWithContentParser:(ISSParser*)rulesetContentParser selectorsChainsDeclarations:(ISSParser*)selectorsChainsDeclarations {
+    __weak ISSDefaultStyleSheetParser* blockSelf = self;
     return [[selectorsChainsDeclarations then:[rulesetContentParser between:openBraceSkipSpace and:closeBraceSkipSpace]] transform:^id(id value) {
-        ISSSelectorChainsDeclaration* selectorChainsDeclaration = value[0];
-        selectorChainsDeclaration.properties = value[1];
-        return selectorChainsDeclaration;
+        return [blockSelf rulesetWithSelectorChains:value[0] properties:value[1]];
     } name:@"rulesetParser"];
 }
 
@@ -1306,6 +1290,7 @@ static NSObject* ISSLayoutAttributeSizeToFitFlag;
 
 - (id) init {
     if ( (self = [super init]) ) {
+        __weak ISSDefaultStyleSheetParser* blockSelf = self;
         
         /** Common parsers **/
         dot = [ISSParser unichar:'.'];
@@ -1318,20 +1303,8 @@ static NSObject* ISSLayoutAttributeSizeToFitFlag;
         anyName = [ISSParser iss_anythingButWhiteSpaceAndExtendedControlChars:1];
         anythingButControlChars = [ISSParser iss_anythingButBasicControlChars:1];
         
-        plainNumber = [[ISSParser digit] concatMany1];
-        ISSParser* fraction = [[dot then:plainNumber] concat];
-        plainNumber = [[plainNumber then:[ISSParser optional:fraction defaultValue:@""]] concat];
-        
-        ISSParser* plus = [ISSParser unichar:'+' skipSpaces:YES];
-        ISSParser* minus = [ISSParser unichar:'-' skipSpaces:YES];
-        ISSParser* negativeNumber = [[minus keepRight:plainNumber] transform:^id(id value) {
-            return @(-[value doubleValue]);
-        } name:@"negativeNumber"];
-        ISSParser* positiveNumber = [plus keepRight:plainNumber];
-        positiveNumber = [[ISSParser choice:@[positiveNumber, plainNumber]] transform:^id(id value) {
-            return @([value doubleValue]);
-        } name:@"positiveNumber"];
-        numberValue = [ISSParser choice:@[negativeNumber, positiveNumber]];
+        plainNumber = [ISSParser plainNumber];
+        numberValue = [ISSParser signedNumber];
         
         numberOrExpressionValue = [ISSParser iss_mathExpressionParser];
         
@@ -1368,7 +1341,7 @@ static NSObject* ISSLayoutAttributeSizeToFitFlag;
         /** Variables **/
         validVariableNameSet = [ISSParser iss_validIdentifierCharsSet];
         ISSParser* variableParser = [[ISSParser iss_propertyPairParser:YES] transform:^id(id value) {
-            [[InterfaCSS sharedInstance] setValue:value[1] forStyleSheetVariableWithName:value[0]];
+            [blockSelf defineVariableWithName:value[0] value:value[1]];
             return [NSNull null];
         } name:@"variableParser"];
 
@@ -1518,19 +1491,19 @@ static NSObject* ISSLayoutAttributeSizeToFitFlag;
         ISSParser* selectorChain = [[simpleSelector sepBy1Keep:combinators] transform:^id(NSArray* value) {
             id result = [ISSSelectorChain selectorChainWithComponents:value];
             if( !result ) {
-                return [ISSStyleSheetParserBadData badDataWithDescription:[NSString stringWithFormat:@"Invalid selector chain: %@", [value componentsJoinedByString:@" "]]];
+                return [blockSelf badDataWithDescription:[NSString stringWithFormat:@"Invalid selector chain: %@", [value componentsJoinedByString:@" "]]];
             }
             else return result;
         } name:@"selectorChain"];
         
         ISSParser* selectorsChainsDeclarations = [[[selectorChain skipSurroundingSpaces] sepBy1:comma] transform:^id(id value) {
-            if( ![value isKindOfClass:NSArray.class] ) value = @[value];
-            return [ISSSelectorChainsDeclaration selectorChainsWithArray:value];
+            if( ![value isKindOfClass:NSArray.class] ) value = [@[value] mutableCopy];
+            return value;
         } name:@"selectorsChainsDeclaration"];
         
 
         /** Properties **/
-        transformedValueCache = [[NSMutableDictionary alloc] init];
+        _transformedValueCache = [[ISSTransformedValueCache alloc] init];
         ISSParser* propertyDeclarations = [self propertyParsers:selectorsChainsDeclarations commentParser:commentParser selectorChainParser:selectorChain];
 
         
@@ -1540,16 +1513,55 @@ static NSObject* ISSLayoutAttributeSizeToFitFlag;
 
         /** Unrecognized content **/
         ISSParser* unrecognizedContent = [[self unrecognizedLineParser] transform:^id(id value) {
-            if( [value iss_hasData] ) return [ISSStyleSheetParserBadData badDataWithDescription:[NSString stringWithFormat:@"Unrecognized content: '%@'", [value iss_trim]]];
+            if( [value iss_hasData] ) return [blockSelf badDataWithDescription:[NSString stringWithFormat:@"Unrecognized content: '%@'", [value iss_trim]]];
             else return [NSNull null];
         } name:@"unrecognizedContent"];
 
         cssParser = [[ISSParser choice:@[commentParser, variableParser, rulesetParser, unrecognizedContent]] manyActualValues];
+
+
+        /** Tokenizer (hand-written parser front end, producing the same result as cssParser above) **/
+        tokenizer = [[ISSStyleSheetTokenizer alloc] initWithDelegate:self];
     }
     return self;
 }
 
 
+#pragma mark - ISSStyleSheetTokenizerDelegate (also used by the parser combinators above)
+
+- (void) defineVariableWithName:(NSString*)name value:(NSString*)value {
+    [[InterfaCSS sharedInstance] setValue:value forStyleSheetVariableWithName:name];
+}
+
+- (id) propertyDeclarationWithName:(NSString*)name value:(NSString*)value {
+    ISSPropertyDeclaration* declaration = [self transformPropertyPair:@[name, value]];
+    // If this declaration contains a reference to a nested element - return a nested ruleset declaration containing the property declaration, instead of the property declaration itself
+    if( declaration.nestedElementKeyPath ) {
+        ISSSelector* nestedElementSelector = [ISSNestedElementSelector selectorWithNestedElementKeyPath:declaration.nestedElementKeyPath];
+        ISSSelectorChain* chain = [ISSSelectorChain selectorChainWithComponents:@[nestedElementSelector]];
+        ISSSelectorChainsDeclaration* chains = [ISSSelectorChainsDeclaration selectorChainsWithArray:[@[chain] mutableCopy]];
+        chains.properties = [@[declaration] mutableCopy];
+        return chains;
+    } else {
+        return declaration;
+    }
+}
+
+- (id) rulesetWithSelectorChains:(NSMutableArray*)selectorChains properties:(NSMutableArray*)properties {
+    ISSSelectorChainsDeclaration* selectorChainsDeclaration = [ISSSelectorChainsDeclaration selectorChainsWithArray:selectorChains];
+    selectorChainsDeclaration.properties = properties;
+    return selectorChainsDeclaration;
+}
+
+- (id) declarationExtensionWithSelectorChain:(id)selectorChain {
+    return [ISSDeclarationExtension extensionOfDeclaration:selectorChain];
+}
+
+- (id) badDataWithDescription:(NSString*)badDataDescription {
+    return [ISSStyleSheetParserBadData badDataWithDescription:badDataDescription];
+}
+
+
 #pragma mark - Property declaration processing (setup of nested declarations)
 
 - (void) processProperties:(NSMutableArray*)properties withSelectorChains:(NSArray*)_selectorChains andAddToDeclarations:(NSMutableArray*)declarations {
@@ -1611,7 +1623,29 @@ static NSObject* ISSLayoutAttributeSizeToFitFlag;
 
 - (NSMutableArray*) parse:(NSString*)styleSheetData {
     ISSParserStatus status = {};
-    id result = [styleSheetData iss_hasData] ? [cssParser parse:styleSheetData status:&status] : nil;
+    id result = nil;
+    if( [styleSheetData iss_hasData] ) {
+        if( self.useCombinatorParser ) {
+            @synchronized(self) {
+                result = [cssParser parse:styleSheetData status:&status];
+            }
+        } else {
+            // Stylesheets may be parsed concurrently on background queues - since the tokenizer is stateful, a new one is used if the shared one is busy
+            ISSStyleSheetTokenizer* styleSheetTokenizer = nil;
+            @synchronized(self) {
+                styleSheetTokenizer = tokenizer;
+                tokenizer = nil;
+            }
+            if( !styleSheetTokenizer ) styleSheetTokenizer = [[ISSStyleSheetTokenizer alloc] initWithDelegate:self];
+
+            result = [styleSheetTokenizer parse:styleSheetData];
+            status.match = result != nil;
+
+            @synchronized(self) {
+                tokenizer = styleSheetTokenizer;
+            }
+        }
+    }
     if( status.match ) {
         NSMutableArray* declarations = [NSMutableArray array];
         ISSSelectorChainsDeclaration* lastElement = nil;
@@ -0,0 +1,47 @@
+//
+//  ISSMathExpression.h
+//  Part of InterfaCSS - http://www.github.com/tolo/InterfaCSS
+//
+//  Copyright (c) Tobias Löfstrand, Leafnode AB.
+//  License: MIT (http://www.github.com/tolo/InterfaCSS/LICENSE)
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+/**
+ * A compiled arithmetic or logical expression, such as `2 * (10 - 4.5)` or `10 ** 2 > 50 && !(1 = 2)`. Supported operators (in order of precedence) are
+ * `||`, `&&`, equality (`=`, `==`, `!=`, `<>`, `≠`), comparison (`<`, `>`, `<=`, `>=`, `≤`, `≥`), `+`, `-`, `*`, `/`, `%` (remainder), unary `-`, `+` and
+ * `!`, and power (`**` or `^`). Arithmetic is performed in double precision, comparisons and logical operators evaluate to `1` or `0`.
+ *
+ * Expressions are folded into their value when compiled, and compiled expressions are memoized per expression string. Malformed expressions (and
+ * expressions that don't evaluate to a finite number, for instance due to division by zero) never raise exceptions - they simply don't compile.
+ */
+@interface ISSMathExpression : NSObject
+
+/**
+ * Returns the compiled expression for `expressionString`, or `nil` if the expression is malformed.
+ */
++ (nullable ISSMathExpression*) expressionWithString:(NSString*)expressionString;
+
+/**
+ * Evaluates `expressionString`, and returns the result as an `NSNumber`, or `nil` if the expression is malformed.
+ */
++ (nullable NSNumber*) evaluate:(NSString*)expressionString;
+
+/**
+ * Removes all memoized expressions.
+ */
++ (void) clearCache;
+
+@property (nonatomic, strong, readonly) NSString* expressionString;
+@property (nonatomic, readonly) double doubleValue;
+@property (nonatomic, readonly) BOOL boolValue;
+@property (nonatomic, strong, readonly) NSNumber* numberValue;
+
+@end
+
+
+NS_ASSUME_NONNULL_END
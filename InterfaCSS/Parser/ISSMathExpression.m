@@ -0,0 +1,268 @@
+//
+//  ISSMathExpression.m
+//  Part of InterfaCSS - http://www.github.com/tolo/InterfaCSS
+//
+//  Copyright (c) Tobias Löfstrand, Leafnode AB.
+//  License: MIT (http://www.github.com/tolo/InterfaCSS/LICENSE)
+//
+
+#import "ISSMathExpression.h"
+
+#import "NSObject+ISSLogSupport.h"
+
+
+static NSCache* compiledExpressionCache; // Expression string -> ISSMathExpression or NSNull (malformed expression)
+
+
+#pragma mark - Expression scanner
+
+/*
+ * A recursive descent parser over the characters of the expression string. Since expressions consist solely of numeric literals, every sub expression is
+ * folded into its value as soon as it has been parsed.
+ */
+
+typedef struct ISSMathExpressionScanner {
+    const unichar* chars;
+    NSUInteger length;
+    NSUInteger index;
+    NSUInteger depth;
+    BOOL error;
+} ISSMathExpressionScanner;
+
+static const NSUInteger ISSMathExpressionMaxDepth = 128; // Guards against stack exhaustion for (malformed) deeply nested expressions
+
+static double ISSMathExpressionParseOr(ISSMathExpressionScanner* scanner);
+static double ISSMathExpressionParseUnary(ISSMathExpressionScanner* scanner);
+
+static void ISSMathExpressionSkipSpaces(ISSMathExpressionScanner* scanner) {
+    while( scanner->index < scanner->length ) {
+        unichar c = scanner->chars[scanner->index];
+        if( c == ' ' || c == '\t' || c == '\n' || c == '\r' ) scanner->index++;
+        else break;
+    }
+}
+
+static BOOL ISSMathExpressionIsDigit(unichar c) {
+    return c >= '0' && c <= '9';
+}
+
+/*
+ * Skips spaces and consumes the specified operator if it is next in the input. Operators that are prefixes of other operators (e.g. "*" and "**") are
+ * rejected when followed by the character that makes up the longer operator (`notFollowedBy`).
+ */
+static BOOL ISSMathExpressionScanOperator(ISSMathExpressionScanner* scanner, const char* op, unichar notFollowedBy) {
+    ISSMathExpressionSkipSpaces(scanner);
+    NSUInteger opLength = strlen(op);
+    if( scanner->index + opLength > scanner->length ) return NO;
+    for(NSUInteger i = 0; i < opLength; i++) {
+        if( scanner->chars[scanner->index + i] != (unichar)op[i] ) return NO;
+    }
+    if( notFollowedBy && scanner->index + opLength < scanner->length && scanner->chars[scanner->index + opLength] == notFollowedBy ) return NO;
+    scanner->index += opLength;
+    return YES;
+}
+
+static BOOL ISSMathExpressionScanCharacter(ISSMathExpressionScanner* scanner, unichar c) {
+    ISSMathExpressionSkipSpaces(scanner);
+    if( scanner->index < scanner->length && scanner->chars[scanner->index] == c ) {
+        scanner->index++;
+        return YES;
+    }
+    return NO;
+}
+
+static double ISSMathExpressionParseNumber(ISSMathExpressionScanner* scanner) {
+    ISSMathExpressionSkipSpaces(scanner);
+
+    char digits[64];
+    NSUInteger n = 0;
+    BOOL dotFound = NO;
+    BOOL digitFound = NO;
+    for(; scanner->index < scanner->length; scanner->index++) {
+        unichar c = scanner->chars[scanner->index];
+        if( ISSMathExpressionIsDigit(c) ) digitFound = YES;
+        else if( c == '.' && !dotFound ) dotFound = YES;
+        else break;
+
+        if( n == sizeof(digits) - 1 ) { // Unreasonably long number
+            scanner->error = YES;
+            return 0;
+        }
+        digits[n++] = (char)c;
+    }
+    digits[n] = 0;
+
+    if( !digitFound ) {
+        scanner->error = YES;
+        return 0;
+    }
+    return strtod(digits, NULL);
+}
+
+static double ISSMathExpressionParsePrimary(ISSMathExpressionScanner* scanner) {
+    if( ISSMathExpressionScanCharacter(scanner, '(') ) {
+        double value = ISSMathExpressionParseOr(scanner);
+        if( !ISSMathExpressionScanCharacter(scanner, ')') ) scanner->error = YES;
+        return value;
+    }
+    return ISSMathExpressionParseNumber(scanner);
+}
+
+static double ISSMathExpressionParsePower(ISSMathExpressionScanner* scanner) {
+    double value = ISSMathExpressionParsePrimary(scanner);
+    if( !scanner->error && (ISSMathExpressionScanOperator(scanner, "**", 0) || ISSMathExpressionScanCharacter(scanner, '^')) ) {
+        double exponent = ISSMathExpressionParseUnary(scanner); // Right associative
+        value = pow(value, exponent);
+    }
+    return value;
+}
+
+static double ISSMathExpressionParseUnary(ISSMathExpressionScanner* scanner) {
+    if( ++scanner->depth > ISSMathExpressionMaxDepth ) {
+        scanner->error = YES;
+        return 0;
+    }
+
+    double value;
+    if( ISSMathExpressionScanCharacter(scanner, '-') ) value = -ISSMathExpressionParseUnary(scanner);
+    else if( ISSMathExpressionScanCharacter(scanner, '+') ) value = ISSMathExpressionParseUnary(scanner);
+    else if( ISSMathExpressionScanOperator(scanner, "!", '=') ) value = ISSMathExpressionParseUnary(scanner) == 0 ? 1 : 0;
+    else value = ISSMathExpressionParsePower(scanner);
+
+    scanner->depth--;
+    return value;
+}
+
+static double ISSMathExpressionParseMultiplicative(ISSMathExpressionScanner* scanner) {
+    double value = ISSMathExpressionParseUnary(scanner);
+    while( !scanner->error ) {
+        if( ISSMathExpressionScanOperator(scanner, "*", '*') ) value *= ISSMathExpressionParseUnary(scanner);
+        else if( ISSMathExpressionScanCharacter(scanner, '/') ) value /= ISSMathExpressionParseUnary(scanner);
+        else if( ISSMathExpressionScanCharacter(scanner, '%') ) value = fmod(value, ISSMathExpressionParseUnary(scanner));
+        else break;
+    }
+    return value;
+}
+
+static double ISSMathExpressionParseAdditive(ISSMathExpressionScanner* scanner) {
+    double value = ISSMathExpressionParseMultiplicative(scanner);
+    while( !scanner->error ) {
+        if( ISSMathExpressionScanCharacter(scanner, '+') ) value += ISSMathExpressionParseMultiplicative(scanner);
+        else if( ISSMathExpressionScanCharacter(scanner, '-') ) value -= ISSMathExpressionParseMultiplicative(scanner);
+        else break;
+    }
+    return value;
+}
+
+static double ISSMathExpressionParseComparison(ISSMathExpressionScanner* scanner) {
+    double value = ISSMathExpressionParseAdditive(scanner);
+    while( !scanner->error ) {
+        if( ISSMathExpressionScanOperator(scanner, "<=", 0) || ISSMathExpressionScanOperator(scanner, "=<", 0) || ISSMathExpressionScanCharacter(scanner, 0x2264) ) {
+            value = value <= ISSMathExpressionParseAdditive(scanner) ? 1 : 0;
+        } else if( ISSMathExpressionScanOperator(scanner, ">=", 0) || ISSMathExpressionScanOperator(scanner, "=>", 0) || ISSMathExpressionScanCharacter(scanner, 0x2265) ) {
+            value = value >= ISSMathExpressionParseAdditive(scanner) ? 1 : 0;
+        } else if( ISSMathExpressionScanOperator(scanner, "<", '>') ) {
+            value = value < ISSMathExpressionParseAdditive(scanner) ? 1 : 0;
+        } else if( ISSMathExpressionScanCharacter(scanner, '>') ) {
+            value = value > ISSMathExpressionParseAdditive(scanner) ? 1 : 0;
+        } else break;
+    }
+    return value;
+}
+
+static double ISSMathExpressionParseEquality(ISSMathExpressionScanner* scanner) {
+    double value = ISSMathExpressionParseComparison(scanner);
+    while( !scanner->error ) {
+        if( ISSMathExpressionScanOperator(scanner, "==", 0) || ISSMathExpressionScanOperator(scanner, "=", 0) ) {
+            value = value == ISSMathExpressionParseComparison(scanner) ? 1 : 0;
+        } else if( ISSMathExpressionScanOperator(scanner, "!=", 0) || ISSMathExpressionScanOperator(scanner, "<>", 0) || ISSMathExpressionScanCharacter(scanner, 0x2260) ) {
+            value = value != ISSMathExpressionParseComparison(scanner) ? 1 : 0;
+        } else break;
+    }
+    return value;
+}
+
+static double ISSMathExpressionParseAnd(ISSMathExpressionScanner* scanner) {
+    double value = ISSMathExpressionParseEquality(scanner);
+    while( !scanner->error && ISSMathExpressionScanOperator(scanner, "&&", 0) ) {
+        double right = ISSMathExpressionParseEquality(scanner);
+        value = (value != 0 && right != 0) ? 1 : 0;
+    }
+    return value;
+}
+
+static double ISSMathExpressionParseOr(ISSMathExpressionScanner* scanner) {
+    double value = ISSMathExpressionParseAnd(scanner);
+    while( !scanner->error && ISSMathExpressionScanOperator(scanner, "||", 0) ) {
+        double right = ISSMathExpressionParseAnd(scanner);
+        value = (value != 0 || right != 0) ? 1 : 0;
+    }
+    return value;
+}
+
+
+#pragma mark - ISSMathExpression
+
+@implementation ISSMathExpression
+
++ (void) load {
+    compiledExpressionCache = [[NSCache alloc] init];
+}
+
+- (instancetype) initWithExpressionString:(NSString*)expressionString value:(double)value {
+    if( self = [super init] ) {
+        _expressionString = [expressionString copy];
+        _doubleValue = value;
+        _numberValue = @(value);
+    }
+    return self;
+}
+
++ (ISSMathExpression*) compileExpression:(NSString*)expressionString {
+    NSUInteger length = expressionString.length;
+    if( length == 0 ) return nil;
+
+    unichar* chars = malloc(sizeof(unichar) * length);
+    [expressionString getCharacters:chars range:NSMakeRange(0, length)];
+
+    ISSMathExpressionScanner scanner = {.chars = chars, .length = length, .index = 0, .depth = 0, .error = NO};
+    double value = ISSMathExpressionParseOr(&scanner);
+    ISSMathExpressionSkipSpaces(&scanner);
+    BOOL valid = !scanner.error && scanner.index == length && isfinite(value);
+    free(chars);
+
+    if( !valid ) {
+        ISSLogDebug(@"Invalid expression: '%@'", expressionString);
+        return nil;
+    }
+    return [[self alloc] initWithExpressionString:expressionString value:value];
+}
+
++ (ISSMathExpression*) expressionWithString:(NSString*)expressionString {
+    if( !expressionString ) return nil;
+
+    id expression = [compiledExpressionCache objectForKey:expressionString];
+    if( !expression ) {
+        expression = [self compileExpression:expressionString] ?: [NSNull null];
+        [compiledExpressionCache setObject:expression forKey:expressionString];
+    }
+    return expression != [NSNull null] ? expression : nil;
+}
+
++ (NSNumber*) evaluate:(NSString*)expressionString {
+    return [self expressionWithString:expressionString].numberValue;
+}
+
++ (void) clearCache {
+    [compiledExpressionCache removeAllObjects];
+}
+
+- (BOOL) boolValue {
+    return self.doubleValue != 0;
+}
+
+- (NSString*) description {
+    return [NSString stringWithFormat:@"ISSMathExpression(%@ = %@)", self.expressionString, self.numberValue];
+}
+
+@end
@@ -19,6 +19,8 @@ NS_ASSUME_NONNULL_BEGIN
 
 + (ISSParser*) iss_anythingButWhiteSpaceAndExtendedControlChars:(NSUInteger)minCount;
 
++ (NSCharacterSet*) iss_validInitialIdentifierCharacterCharsSet;
+
 + (NSCharacterSet*) iss_validIdentifierCharsSet;
 
 + (ISSParser*) iss_validIdentifierChars:(NSUInteger)minCount;
@@ -29,7 +31,7 @@ NS_ASSUME_NONNULL_BEGIN
 
 + (ISSParser*) iss_mathExpressionParser;
 
-+ (id) iss_parseMathExpression:(NSString*)value;
++ (nullable id) iss_parseMathExpression:(NSString*)value;
 
 + (ISSParser*) iss_parameterStringWithPrefixes:(NSArray*)prefixes;
 
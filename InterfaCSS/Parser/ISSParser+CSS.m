@@ -9,6 +9,7 @@
 #import "ISSParser+CSS.h"
 
 #import "NSString+ISSStringAdditions.h"
+#import "ISSMathExpression.h"
 
 
 @implementation ISSParser (CSS)
@@ -84,24 +85,34 @@
     return [characterSet copy];
 }
 
++ (ISSParser*) iss_expressionParser:(BOOL)logical {
+    ISSParser* expressionStringParser = [self takeUntilInSet:[[self iss_mathExpressionCharsSet] invertedSet] minCount:1];
+    ISSParser* parser = [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
+        ISSParserStatus expressionStatus = *status;
+        NSString* expressionString = [expressionStringParser parse:input status:&expressionStatus];
+        if( expressionStatus.match ) {
+            ISSMathExpression* expression = [ISSMathExpression expressionWithString:expressionString];
+            if( expression ) { // Malformed expressions don't match
+                *status = expressionStatus;
+                return logical ? @(expression.boolValue) : expression.numberValue;
+            }
+        }
+        return [NSNull null];
+    } andName:logical ? @"iss_logicalExpressionParser" : @"iss_mathExpressionParser"];
+    parser.firstCharacterSet = expressionStringParser.firstCharacterSet;
+    return parser;
+}
+
 + (ISSParser*) iss_logicalExpressionParser {
-    NSCharacterSet* invertedCharacterSet = [[self iss_mathExpressionCharsSet] invertedSet];
-    return [[self takeUntilInSet:invertedCharacterSet minCount:1] transform:^id(id value) {
-        NSPredicate* expr = [NSPredicate predicateWithFormat:value];
-        return @([expr evaluateWithObject:nil]);
-    }];
+    return [self iss_expressionParser:YES];
 }
 
 + (ISSParser*) iss_mathExpressionParser {
-    NSCharacterSet* invertedCharacterSet = [[self iss_mathExpressionCharsSet] invertedSet];
-    return [[self takeUntilInSet:invertedCharacterSet minCount:1] transform:^id(id value) {
-        return [self iss_parseMathExpression:value];
-    }];
+    return [self iss_expressionParser:NO];
 }
 
 + (id) iss_parseMathExpression:(NSString*)value {
-    NSExpression* expr = [NSExpression expressionWithFormat:value];
-    return [expr expressionValueWithObject:nil context:nil];
+    return [ISSMathExpression evaluate:value];
 }
 
 + (id) iss_partialParameterStringWithPrefix:(NSString*)prefix input:(NSString*)input status:(ISSParserStatus*)status {
@@ -162,8 +173,18 @@
     return nil;
 }
 
++ (NSCharacterSet*) iss_firstCharacterSetForParameterStringWithPrefixes:(NSArray*)prefixes {
+    NSMutableCharacterSet* firstCharacterSet = [[NSCharacterSet whitespaceAndNewlineCharacterSet] mutableCopy];
+    for(NSString* prefix in prefixes) {
+        NSCharacterSet* prefixCharacterSet = prefix.length ? [self firstCharacterSetIgnoringCaseForString:prefix] : [NSCharacterSet characterSetWithCharactersInString:@"("];
+        if( !prefixCharacterSet ) return nil;
+        [firstCharacterSet formUnionWithCharacterSet:prefixCharacterSet];
+    }
+    return [firstCharacterSet copy];
+}
+
 + (ISSParser*) iss_parameterStringWithPrefixes:(NSArray*)prefixes {
-    return [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
+    ISSParser* parser = [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
         NSUInteger i = status->index;
         ISSParserSkipSpaceAndNewLines(input); // Skip space
         
@@ -177,10 +198,12 @@
         }
         return [NSNull null];
     } andName:@"iss_parameterStringWithPrefixes"];
+    parser.firstCharacterSet = [self iss_firstCharacterSetForParameterStringWithPrefixes:prefixes];
+    return parser;
 }
 
 + (ISSParser*) iss_parameterStringWithPrefix:(NSString*)prefix {
-    return [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
+    ISSParser* parser = [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
         NSUInteger i = status->index;
         ISSParserSkipSpaceAndNewLines(input); // Skip space
         
@@ -194,6 +217,8 @@
             return [NSNull null];
         }
     } andName:@"iss_parameterStringWithPrefix"];
+    parser.firstCharacterSet = [self iss_firstCharacterSetForParameterStringWithPrefixes:prefix ? @[prefix] : @[@""]];
+    return parser;
 }
 
 + (ISSParser*) iss_parameterString {
@@ -252,7 +277,7 @@
 }
 
 + (ISSParser*) iss_commentParser {
-    return [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
+    ISSParser* parser = [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
         NSUInteger i = status->index;
         const NSUInteger len = input.length;
         ISSParserSkipSpaceAndNewLines(input); // Skip space
@@ -305,6 +330,10 @@
         
         return [NSNull null];
     } andName:@"iss_commentParser"];
+    NSMutableCharacterSet* firstCharacterSet = [[NSCharacterSet whitespaceAndNewlineCharacterSet] mutableCopy];
+    [firstCharacterSet addCharactersInString:@"/"];
+    parser.firstCharacterSet = [firstCharacterSet copy];
+    return parser;
 }
 
 + (NSString*) iss_parseEscapedAndParameterizedStringUpToChar:(unichar)char1 orChar:(unichar)char2 inString:(NSString*)input index:(NSUInteger*)index {
@@ -35,6 +35,19 @@ typedef id _Nonnull (^ISSParserTransformerBlock)(id value);
 
 - (id) parse:(NSString*)string status:(ISSParserStatus*)status;
 
+/**
+ * The set of characters this parser can begin a match with (including any leading whitespace it skips), or `nil` if unknown. Used by `choice:` to only try
+ * the alternatives that can match the character at the current input position. Set automatically by the built in matchers and combinators.
+ */
+@property (nonatomic, strong, nullable) NSCharacterSet* firstCharacterSet;
+/**
+ * Indicates if this parser can match without consuming any input, in which case it is always tried by `choice:`, regardless of `firstCharacterSet`.
+ */
+@property (nonatomic) BOOL canMatchEmpty;
+
+/** Returns the set of characters that a case insensitive match of `string` can begin with, or `nil` if it can't be determined. */
++ (nullable NSCharacterSet*) firstCharacterSetIgnoringCaseForString:(nullable NSString*)string;
+
 
 #pragma mark - Combinators
 
@@ -92,6 +105,11 @@ typedef id _Nonnull (^ISSParserTransformerBlock)(id value);
 
 + (ISSParser*) digit;
 
+/** Matches a plain (unsigned) number, i.e. digits optionally followed by a fraction, and returns it as a string. */
++ (ISSParser*) plainNumber;
+/** Matches a number with an optional sign (which may be surrounded by spaces), and returns it as an `NSNumber` (parsed directly from the input). */
++ (ISSParser*) signedNumber;
+
 + (ISSParser*) charMatching:(ISSParserMatchCondition)matcher skipSpaces:(BOOL)skipSpaces name:(NSString*)name;
 
 
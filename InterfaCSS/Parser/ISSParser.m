@@ -13,8 +13,126 @@
 @interface ISSParser ()
 @property (nonatomic, copy) ISSParserBlock parserBlock;
 @property (nonatomic, strong) NSString* name;
+@property (nonatomic, copy) ISSParserMatchCondition charMatcher; // Set for single character parsers (that don't skip spaces), to enable concatMany optimization
 @end
 
+
+#pragma mark - Character buffer access
+
+/*
+ * Tokens are scanned as ranges directly in the character buffer of the input string (using CFStringInlineBuffer), and only materialized as NSString objects
+ * once the full extent of the token is known.
+ */
+
+static inline void ISSParserInitBuffer(CFStringInlineBuffer* buffer, NSString* input, NSUInteger length) {
+    CFStringInitInlineBuffer((__bridge CFStringRef)input, buffer, CFRangeMake(0, (CFIndex)length));
+}
+
+static inline unichar ISSParserCharAt(CFStringInlineBuffer* buffer, NSUInteger index) {
+    return CFStringGetCharacterFromInlineBuffer(buffer, (CFIndex)index);
+}
+
+static inline BOOL ISSParserIsDigit(unichar c) {
+    return c >= '0' && c <= '9';
+}
+
+static NSString* ISSParserSingleCharacterString(unichar c) {
+    static NSString* asciiStrings[128];
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        for(unichar a = 0; a < 128; a++) {
+            asciiStrings[a] = [[NSString alloc] initWithCharacters:&a length:1];
+        }
+    });
+    return c < 128 ? asciiStrings[c] : [[NSString alloc] initWithCharacters:&c length:1];
+}
+
+/*
+ * Scans a plain number (i.e. digits, optionally followed by a fraction) starting at index, and returns the index after the number, or NSNotFound if no
+ * number was found.
+ */
+static NSUInteger ISSParserScanPlainNumber(CFStringInlineBuffer* buffer, NSUInteger index, NSUInteger length) {
+    NSUInteger i = index;
+    while( i < length && ISSParserIsDigit(ISSParserCharAt(buffer, i)) ) i++;
+    if( i == index ) return NSNotFound;
+
+    // Fraction (only if at least one digit follows the dot)
+    if( i + 1 < length && ISSParserCharAt(buffer, i) == '.' && ISSParserIsDigit(ISSParserCharAt(buffer, i + 1)) ) {
+        i += 2;
+        while( i < length && ISSParserIsDigit(ISSParserCharAt(buffer, i)) ) i++;
+    }
+    return i;
+}
+
+static double ISSParserPlainNumberValue(CFStringInlineBuffer* buffer, NSUInteger location, NSUInteger end, NSString* input) {
+    char digits[64];
+    if( (end - location) < sizeof(digits) ) {
+        NSUInteger n = 0;
+        for(NSUInteger i = location; i < end; i++) digits[n++] = (char)ISSParserCharAt(buffer, i); // Only ASCII digits and dot, see ISSParserScanPlainNumber
+        digits[n] = 0;
+        return strtod(digits, NULL);
+    } else {
+        return [[input substringWithRange:NSMakeRange(location, end - location)] doubleValue];
+    }
+}
+
+
+#pragma mark - First character sets
+
+/*
+ * Parsers that know which characters they can begin a match with advertise this through firstCharacterSet, which lets choice: build a dispatch table (for
+ * ASCII characters) at construction time, and only try the alternatives that can match the character at the current input position.
+ */
+
+static const unichar ISSParserDispatchTableSize = 128;
+
+static NSCharacterSet* ISSParserWhitespaceCharacterSet(void) {
+    return [NSCharacterSet whitespaceAndNewlineCharacterSet];
+}
+
+static NSCharacterSet* ISSParserCharacterSetWithCharacter(unichar c) {
+    return [NSCharacterSet characterSetWithRange:NSMakeRange(c, 1)];
+}
+
+static NSCharacterSet* ISSParserUnionCharacterSet(NSCharacterSet* set1, NSCharacterSet* set2) {
+    NSMutableCharacterSet* set = [set1 mutableCopy];
+    [set formUnionWithCharacterSet:set2];
+    return [set copy];
+}
+
+static BOOL ISSParserCanBeginWithCharacter(ISSParser* parser, unichar c) {
+    NSCharacterSet* firstCharacterSet = parser.firstCharacterSet;
+    return !firstCharacterSet || parser.canMatchEmpty || [firstCharacterSet characterIsMember:c];
+}
+
+/*
+ * Builds a table of the parsers to try for each ASCII character (where end of input is represented by 0), or returns nil if dispatching wouldn't rule out any
+ * parsers.
+ */
+static NSArray* ISSParserDispatchTable(NSArray* parsers) {
+    if( parsers.count < 2 ) return nil;
+
+    NSMutableArray* dispatchTable = [NSMutableArray arrayWithCapacity:ISSParserDispatchTableSize];
+    NSMutableDictionary* candidatesForIndexes = [NSMutableDictionary dictionary];
+    BOOL reduced = NO;
+    for(unichar c = 0; c < ISSParserDispatchTableSize; c++) {
+        NSIndexSet* indexes = [parsers indexesOfObjectsPassingTest:^BOOL(ISSParser* parser, NSUInteger idx, BOOL* stop) {
+            return ISSParserCanBeginWithCharacter(parser, c);
+        }];
+        if( indexes.count < parsers.count ) reduced = YES;
+
+        // Share the candidate arrays between characters that dispatch to the same parsers
+        NSArray* candidates = candidatesForIndexes[indexes];
+        if( !candidates ) {
+            candidates = indexes.count == parsers.count ? parsers : [parsers objectsAtIndexes:indexes];
+            candidatesForIndexes[indexes] = candidates;
+        }
+        [dispatchTable addObject:candidates];
+    }
+    return reduced ? [dispatchTable copy] : nil;
+}
+
+
 @implementation ISSParser
 
 - (instancetype) initWithBlock:(ISSParserBlock)block andName:(NSString*)name {
@@ -37,13 +155,38 @@
     return self.name;
 }
 
+- (void) copyFirstCharacterSetFrom:(ISSParser*)parser {
+    self.firstCharacterSet = parser.firstCharacterSet;
+    self.canMatchEmpty = parser.canMatchEmpty;
+}
+
++ (NSCharacterSet*) firstCharacterSetIgnoringCaseForString:(NSString*)string {
+    if( string.length == 0 ) return nil;
+    unichar c = [string characterAtIndex:0];
+    if( c >= ISSParserDispatchTableSize ) return nil; // Only handle case of ASCII characters
+
+    NSMutableCharacterSet* set = [NSMutableCharacterSet characterSetWithRange:NSMakeRange(c, 1)];
+    [set addCharactersInRange:NSMakeRange((unichar)tolower(c), 1)];
+    [set addCharactersInRange:NSMakeRange((unichar)toupper(c), 1)];
+    return [set copy];
+}
+
 
 #pragma mark - Combinators
 
 + (ISSParser*) choice:(NSArray*)parsers {
-    return [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
+    parsers = [parsers copy];
+    NSArray* dispatchTable = ISSParserDispatchTable(parsers);
+
+    ISSParser* choice = [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
+        NSArray* candidates = parsers;
+        if( dispatchTable ) {
+            unichar c = status->index < input.length ? [input characterAtIndex:status->index] : 0;
+            if( c < ISSParserDispatchTableSize ) candidates = dispatchTable[c];
+        }
+
         id value = nil;
-        for(ISSParser* parser in parsers) {
+        for(ISSParser* parser in candidates) {
             value = [parser parse:input status:status];
             if( status->match ) {
                 break;
@@ -51,6 +194,19 @@
         }
         return value ?: [NSNull null];
     } andName:@"choice"];
+
+    // A choice can begin with any character that any of its alternatives can begin with
+    NSMutableCharacterSet* firstCharacterSet = [[NSMutableCharacterSet alloc] init];
+    for(ISSParser* parser in parsers) {
+        if( !parser.firstCharacterSet ) {
+            firstCharacterSet = nil;
+            break;
+        }
+        [firstCharacterSet formUnionWithCharacterSet:parser.firstCharacterSet];
+        if( parser.canMatchEmpty ) choice.canMatchEmpty = YES;
+    }
+    choice.firstCharacterSet = [firstCharacterSet copy];
+    return choice;
 }
 
 - (ISSParser*) parserOr:(ISSParser*)parser {
@@ -58,7 +214,7 @@
 }
 
 + (ISSParser*) sequential:(NSArray*)parsers {
-    return [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
+    ISSParser* sequential = [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
         NSMutableArray* sequentialResult = nil;
         NSUInteger i = status->index;
         for(ISSParser* parser in parsers) {
@@ -76,6 +232,21 @@
         status->index = i;
         return sequentialResult ?: @[];
     } andName:@"sequential"];
+
+    // A sequence can begin with any character that the leading parsers, up to and including the first one that can't match empty, can begin with
+    NSMutableCharacterSet* firstCharacterSet = [[NSMutableCharacterSet alloc] init];
+    BOOL canMatchEmpty = YES;
+    for(ISSParser* parser in parsers) {
+        if( !parser.firstCharacterSet ) return sequential;
+        [firstCharacterSet formUnionWithCharacterSet:parser.firstCharacterSet];
+        if( !parser.canMatchEmpty ) {
+            canMatchEmpty = NO;
+            break;
+        }
+    }
+    sequential.firstCharacterSet = [firstCharacterSet copy];
+    sequential.canMatchEmpty = canMatchEmpty;
+    return sequential;
 }
 
 + (ISSParser*) optional:(ISSParser*)parser {
@@ -83,11 +254,14 @@
 }
 
 + (ISSParser*) optional:(ISSParser*)parser defaultValue:(id)defaultValue {
-    return [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
+    ISSParser* optional = [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
         id value = [parser parse:input status:status];
         status->match = YES;
         return value ?: defaultValue;
     } andName:[NSString stringWithFormat:@"optional(%@)", parser.name]];
+    optional.firstCharacterSet = parser.firstCharacterSet;
+    optional.canMatchEmpty = YES;
+    return optional;
 }
 
 - (ISSParser*) then:(ISSParser*)parser {
@@ -143,7 +317,7 @@
 }
 
 - (ISSParser*) many:(NSUInteger)minCount onlyValid:(BOOL)onlyValid {
-    return [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
+    ISSParser* many = [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
         NSMutableArray* values = [NSMutableArray array];
         const NSUInteger len = input.length;
         
@@ -162,6 +336,9 @@
             return [NSNull null];
         }
     } andName:@"many"];
+    many.firstCharacterSet = self.firstCharacterSet;
+    many.canMatchEmpty = minCount == 0 || self.canMatchEmpty;
+    return many;
 }
 
 - (ISSParser*) sepBy:(ISSParser*)delimiterParser {
@@ -187,7 +364,7 @@
 }
 
 - (ISSParser*) sepBy:(ISSParser*)delimiterParser minCount:(NSUInteger)minCount keep:(BOOL)keep {
-    return [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
+    ISSParser* sepBy = [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
         NSUInteger i = status->index;
         NSUInteger lastValidIndex = i;
         const NSUInteger len = input.length;
@@ -229,6 +406,9 @@
             return [NSNull null];
         }
     } andName:@"sepBy"];
+    sepBy.firstCharacterSet = self.firstCharacterSet;
+    sepBy.canMatchEmpty = minCount == 0 || self.canMatchEmpty;
+    return sepBy;
 }
 
 - (ISSParser*) concat {
@@ -240,12 +420,26 @@
 }
 
 - (ISSParser*) concatMany {
+    // Repeated single character matching is equivalent to (the much cheaper) take while
+    if( self.charMatcher ) {
+        ISSParser* concatMany = [ISSParser takeWhileCharMatches:self.charMatcher initialCharMatcher:nil minCount:0 skipPastEndChar:NO name:@"concatMany"];
+        concatMany.firstCharacterSet = self.firstCharacterSet;
+        concatMany.canMatchEmpty = YES;
+        return concatMany;
+    }
+
     ISSParser* concatMany = [[self many] concat];
     concatMany.name = @"concatMany";
     return concatMany;
 }
 
 - (ISSParser*) concatMany1 {
+    if( self.charMatcher ) {
+        ISSParser* concatMany1 = [ISSParser takeWhileCharMatches:self.charMatcher initialCharMatcher:nil minCount:1 skipPastEndChar:NO name:@"concatMany1"];
+        concatMany1.firstCharacterSet = self.firstCharacterSet;
+        return concatMany1;
+    }
+
     ISSParser* concatMany1 = [[self many1] concat];
     concatMany1.name = @"concatMany1";
     return concatMany1;
@@ -259,7 +453,7 @@
 }
 
 - (ISSParser*) transform:(ISSParserTransformerBlock)transformer name:(NSString*)name {
-    return [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
+    ISSParser* transform = [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
         id value = [self parse:input status:status];
         if( status->match ) {
             return transformer(value);
@@ -267,6 +461,8 @@
             return [NSNull null];
         }
     } andName:name];
+    [transform copyFirstCharacterSetFrom:self];
+    return transform;
 }
 
 
@@ -277,9 +473,12 @@
 }
 
 + (ISSParser*) unichar:(unichar)character skipSpaces:(BOOL)skipSpaces {
-    return [self charMatching:^BOOL(unichar c) {
+    ISSParser* parser = [self charMatching:^BOOL(unichar c) {
         return character == c;
     } skipSpaces:skipSpaces name:@"charInSet"];
+    NSCharacterSet* firstCharacterSet = ISSParserCharacterSetWithCharacter(character);
+    parser.firstCharacterSet = skipSpaces ? ISSParserUnionCharacterSet(firstCharacterSet, ISSParserWhitespaceCharacterSet()) : firstCharacterSet;
+    return parser;
 }
 
 + (ISSParser*) charInSet:(NSCharacterSet*)set {
@@ -287,16 +486,18 @@
 }
 
 + (ISSParser*) charInSet:(NSCharacterSet*)set skipSpaces:(BOOL)skipSpaces {
-    return [self charMatching:^BOOL(unichar c) {
+    ISSParser* parser = [self charMatching:^BOOL(unichar c) {
         return [set characterIsMember:c];
     } skipSpaces:skipSpaces name:@"charInSet"];
+    parser.firstCharacterSet = skipSpaces ? ISSParserUnionCharacterSet(set, ISSParserWhitespaceCharacterSet()) : set;
+    return parser;
 }
 
 + (ISSParser*) stringEQIgnoringCase:(NSString*)matcherString {
     matcherString = [matcherString lowercaseString];
     NSUInteger matcherLength = matcherString.length;
     
-    return [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
+    ISSParser* parser = [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
         NSUInteger i = status->index;
         const NSUInteger len = input.length;
         NSUInteger m = 0;
@@ -312,16 +513,21 @@
         *status = (ISSParserStatus){.match = YES, .index = i};
         return value;
     } andName:[NSString stringWithFormat:@"stringEQIgnoringCase(%@)", matcherString]];
+    parser.firstCharacterSet = [self firstCharacterSetIgnoringCaseForString:matcherString];
+    parser.canMatchEmpty = matcherLength == 0;
+    return parser;
 }
 
 + (ISSParser*) space {
-    return [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
+    ISSParser* space = [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
         if ( status->index < input.length && [[NSCharacterSet whitespaceAndNewlineCharacterSet] characterIsMember:[input characterAtIndex:status->index]] ) {
             status->match = YES;
             status->index++;
         }
         return [NSNull null];
     } andName:@"space"];
+    space.firstCharacterSet = ISSParserWhitespaceCharacterSet();
+    return space;
 }
 
 + (ISSParser*) spaces {
@@ -329,7 +535,7 @@
 }
 
 + (ISSParser*) spaces:(NSUInteger)minCount {
-    return [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
+    ISSParser* spaces = [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
         NSUInteger i = status->index;
         ISSParserSkipSpaceAndNewLines(input);
         if ( (i - status->index) >= minCount ) {
@@ -337,6 +543,9 @@
         }
         return [NSNull null];
     } andName:@"spaces"];
+    spaces.firstCharacterSet = ISSParserWhitespaceCharacterSet();
+    spaces.canMatchEmpty = minCount == 0;
+    return spaces;
 }
 
 - (ISSParser*) skipSurroundingSpaces {
@@ -346,13 +555,15 @@
 }
 
 + (ISSParser*) digit {
-    return [self charMatching:^BOOL(unichar c) {
+    ISSParser* digit = [self charMatching:^BOOL(unichar c) {
         return [[NSCharacterSet decimalDigitCharacterSet] characterIsMember:c];
     } skipSpaces:NO name:@"digit"];
+    digit.firstCharacterSet = [NSCharacterSet decimalDigitCharacterSet];
+    return digit;
 }
 
 + (ISSParser*) charMatching:(ISSParserMatchCondition)matcher skipSpaces:(BOOL)skipSpaces name:(NSString*)name {
-    return [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
+    ISSParser* parser = [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
         NSUInteger i = status->index;
         if( skipSpaces ) ISSParserSkipSpaceAndNewLines(input);
         
@@ -362,10 +573,62 @@
             if( skipSpaces ) ISSParserSkipSpaceAndNewLines(input);
             
             *status = (ISSParserStatus){.match = YES, .index = i};
-            return [NSString stringWithFormat:@"%C", c];
+            return ISSParserSingleCharacterString(c);
         }
         return [NSNull null];
     } andName:name];
+    if( !skipSpaces ) parser.charMatcher = matcher;
+    return parser;
+}
+
++ (ISSParser*) plainNumber {
+    ISSParser* plainNumber = [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
+        const NSUInteger len = input.length;
+        CFStringInlineBuffer buffer;
+        ISSParserInitBuffer(&buffer, input, len);
+
+        NSUInteger end = ISSParserScanPlainNumber(&buffer, status->index, len);
+        if( end == NSNotFound ) return [NSNull null];
+
+        NSString* value = [input substringWithRange:NSMakeRange(status->index, end - status->index)];
+        *status = (ISSParserStatus){.match = YES, .index = end};
+        return value;
+    } andName:@"plainNumber"];
+    plainNumber.firstCharacterSet = [NSCharacterSet characterSetWithRange:NSMakeRange('0', 10)];
+    return plainNumber;
+}
+
++ (ISSParser*) signedNumber {
+    NSCharacterSet* whitespace = [NSCharacterSet whitespaceAndNewlineCharacterSet];
+    ISSParser* signedNumber = [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
+        const NSUInteger len = input.length;
+        CFStringInlineBuffer buffer;
+        ISSParserInitBuffer(&buffer, input, len);
+
+        // Sign (surrounded by optional spaces)
+        NSUInteger i = status->index;
+        while( i < len && [whitespace characterIsMember:ISSParserCharAt(&buffer, i)] ) i++;
+        unichar sign = i < len ? ISSParserCharAt(&buffer, i) : 0;
+        if( sign == '-' || sign == '+' ) {
+            i++;
+            while( i < len && [whitespace characterIsMember:ISSParserCharAt(&buffer, i)] ) i++;
+        } else {
+            sign = 0;
+            i = status->index;
+        }
+
+        NSUInteger end = ISSParserScanPlainNumber(&buffer, i, len);
+        if( end == NSNotFound ) return [NSNull null];
+
+        double value = ISSParserPlainNumberValue(&buffer, i, end, input);
+        *status = (ISSParserStatus){.match = YES, .index = end};
+        return @(sign == '-' ? -value : value);
+    } andName:@"signedNumber"];
+    NSMutableCharacterSet* firstCharacterSet = [NSMutableCharacterSet characterSetWithCharactersInString:@"+-"];
+    [firstCharacterSet addCharactersInRange:NSMakeRange('0', 10)];
+    [firstCharacterSet formUnionWithCharacterSet:whitespace];
+    signedNumber.firstCharacterSet = [firstCharacterSet copy];
+    return signedNumber;
 }
 
 
@@ -375,54 +638,56 @@
     return [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
         NSUInteger i = status->index;
         const NSUInteger len = input.length;
+        CFStringInlineBuffer buffer;
+        ISSParserInitBuffer(&buffer, input, len);
         
         BOOL isBackslash = NO;
+        BOOL containsBackslash = NO;
         for(; i < len; i++) {
-            unichar charAtIndex = [input characterAtIndex:i];
+            unichar charAtIndex = ISSParserCharAt(&buffer, i);
             if( charAtIndex == c && !isBackslash ) {
                 break;
             }
             else {
                 if( charAtIndex == '\\' ) {
-                    if ( isBackslash ) { // Double backslash
-                        isBackslash = NO;
-                    } else { // Backslash found
-                        isBackslash = YES;
-                    }
+                    containsBackslash = YES;
+                    isBackslash = !isBackslash; // Double backslash, or backslash found
                 } else if( isBackslash )  { // Previous character is backslash
                     isBackslash = NO;
                 }
             }
         }
         
-        NSString* string = [input substringWithRange:NSMakeRange(status->index, i - status->index)];
-        NSUInteger stringLength = string.length;
-        for(int c=0; c<stringLength; c++) {
-            unichar charAtIndex = [string characterAtIndex:c];
-            if( charAtIndex == '\\' ) {
-                if ( isBackslash ) { // Double backslash
-                    string = [string stringByReplacingCharactersInRange:NSMakeRange(c, 1) withString:@""];
-                    stringLength = string.length;
-                    c--;
+        NSString* string;
+        if( !containsBackslash ) {
+            string = [input substringWithRange:NSMakeRange(status->index, i - status->index)];
+        } else {
+            // Unescape into a single buffer
+            unichar* unescaped = malloc(sizeof(unichar) * (i - status->index));
+            NSUInteger length = 0;
+            isBackslash = NO;
+            for(NSUInteger location = status->index; location < i; location++) {
+                unichar charAtIndex = ISSParserCharAt(&buffer, location);
+                if( charAtIndex == '\\' ) {
+                    if ( isBackslash ) { // Double backslash - keep only one
+                        isBackslash = NO;
+                    } else { // Backslash found
+                        isBackslash = YES;
+                        unescaped[length++] = charAtIndex;
+                    }
+                } else if( isBackslash )  { // Previous character is backslash
                     isBackslash = NO;
-                } else { // Backslash found
-                    isBackslash = YES;
-                }
-            } else if( isBackslash )  { // Previous character is backslash
-                isBackslash = NO;
-                
-                if( charAtIndex == 'n' ) {
-                    string = [string stringByReplacingCharactersInRange:NSMakeRange(c-1, 2) withString:@"\n"];
-                } else if( charAtIndex == 't' ) {
-                    string = [string stringByReplacingCharactersInRange:NSMakeRange(c-1, 2) withString:@"\t"];
-                } else if( charAtIndex == '\'' || charAtIndex == '\"' ) {
-                    string = [string stringByReplacingCharactersInRange:NSMakeRange(c-1, 1) withString:@""];
+                    
+                    if( charAtIndex == 'n' ) unescaped[length - 1] = '\n';
+                    else if( charAtIndex == 't' ) unescaped[length - 1] = '\t';
+                    else if( charAtIndex == '\'' || charAtIndex == '\"' ) unescaped[length - 1] = charAtIndex; // Escaped quote - remove backslash
+                    else unescaped[length++] = charAtIndex;
                 } else {
-                    c++;
+                    unescaped[length++] = charAtIndex;
                 }
-                stringLength = string.length;
-                c--;
             }
+            string = [[NSString alloc] initWithCharacters:unescaped length:length];
+            free(unescaped);
         }
         
         *status = (ISSParserStatus){.match = YES, .index = i};
@@ -435,9 +700,12 @@
 }
 
 + (ISSParser*) takeUntilInSet:(NSCharacterSet*)characterSet minCount:(NSUInteger)minCount {
-    return [self takeWhileCharMatches:^ BOOL(unichar c) {
+    ISSParser* parser = [self takeWhileCharMatches:^ BOOL(unichar c) {
         return ![characterSet characterIsMember:c];
     } initialCharMatcher:nil minCount:minCount skipPastEndChar:NO name:@"takeUntilInSet"];
+    parser.firstCharacterSet = [characterSet invertedSet];
+    parser.canMatchEmpty = minCount == 0;
+    return parser;
 }
 
 + (ISSParser*) takeWhileInSet:(NSCharacterSet*)characterSet {
@@ -453,13 +721,18 @@
         return [characterSet characterIsMember:c];
     };
     
+    ISSParser* parser;
     if( initialCharSet ) {
-        return [self takeWhileCharMatches:characterSetMatcher initialCharMatcher:^ BOOL(unichar c) {
+        parser = [self takeWhileCharMatches:characterSetMatcher initialCharMatcher:^ BOOL(unichar c) {
             return [initialCharSet characterIsMember:c];
         } minCount:minCount skipPastEndChar:NO name:@"takeWhileInSet"];
+        parser.firstCharacterSet = initialCharSet;
     } else {
-        return [self takeWhileCharMatches:characterSetMatcher initialCharMatcher:nil minCount:minCount skipPastEndChar:NO name:@"takeWhileInSet"];
+        parser = [self takeWhileCharMatches:characterSetMatcher initialCharMatcher:nil minCount:minCount skipPastEndChar:NO name:@"takeWhileInSet"];
+        parser.firstCharacterSet = characterSet;
+        parser.canMatchEmpty = minCount == 0;
     }
+    return parser;
 }
 
 + (ISSParser*) takeUntilChar:(unichar)character {
@@ -467,18 +740,23 @@
 }
 
 + (ISSParser*) takeUntilChar:(unichar)character andSkip:(BOOL)skip minCount:(NSUInteger)minCount {
-    return [self takeWhileCharMatches:^ BOOL(unichar c) {
+    ISSParser* parser = [self takeWhileCharMatches:^ BOOL(unichar c) {
         return c != character;
     } initialCharMatcher:nil minCount:minCount skipPastEndChar:skip name:@"takeUntilChar"];
+    parser.firstCharacterSet = [ISSParserCharacterSetWithCharacter(character) invertedSet];
+    parser.canMatchEmpty = minCount == 0;
+    return parser;
 }
 
 + (ISSParser*) takeWhileCharMatches:(ISSParserMatchCondition)matcher initialCharMatcher:(ISSParserMatchCondition)initialCharMatcher minCount:(NSUInteger)minCount skipPastEndChar:(BOOL)skipPastEndChar name:(NSString*)name {
     return [ISSParser parserWithBlock:^id (NSString* input, ISSParserStatus* status) {
         NSUInteger i = status->index;
         const NSUInteger len = input.length;
+        CFStringInlineBuffer buffer;
+        ISSParserInitBuffer(&buffer, input, len);
         
         if( initialCharMatcher ) {
-            if( i < len && initialCharMatcher([input characterAtIndex:i]) ) {
+            if( i < len && initialCharMatcher(ISSParserCharAt(&buffer, i)) ) {
                 i++;
             } else {
                 return [NSNull null];
@@ -486,7 +764,7 @@
         }
         
         for(; i < len; i++) {
-            if( !matcher([input characterAtIndex:i]) ) {
+            if( !matcher(ISSParserCharAt(&buffer, i)) ) {
                 break;
             }
         }
@@ -509,6 +787,15 @@
 
 @implementation ISSParserWrapper
 
+// The wrapped parser is typically set after the wrapper has been used in other parsers, which will then treat the wrapper as unknown
+- (NSCharacterSet*) firstCharacterSet {
+    return self.wrappedParser.firstCharacterSet;
+}
+
+- (BOOL) canMatchEmpty {
+    return self.wrappedParser.canMatchEmpty;
+}
+
 - (id) parse:(NSString*)string status:(ISSParserStatus*)status {
     return [self.wrappedParser parse:string status:status];
 }
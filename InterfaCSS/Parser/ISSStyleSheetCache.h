@@ -0,0 +1,52 @@
+//
+//  ISSStyleSheetCache.h
+//  Part of InterfaCSS - http://www.github.com/tolo/InterfaCSS
+//
+//  Copyright (c) Tobias Löfstrand, Leafnode AB.
+//  License: MIT (http://www.github.com/tolo/InterfaCSS/LICENSE)
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+@protocol ISSStyleSheetParser;
+
+
+/**
+ * Persistent on-disk cache of stylesheet parse results, for stylesheets that cannot be compiled at build time (see `ISSStyleSheetCompiler`), such as downloaded
+ * stylesheets. Parse results are stored in the compiled stylesheet format, keyed by a hash of the stylesheet content, the parser class, the signature of the
+ * property registry and the stylesheet variables in effect when parsing. Registering custom properties (or prefix key paths) changes the registry
+ * signature, and thus invalidates all previously cached parse results.
+ *
+ * The total size of the cache is limited by `maximumCacheSize` - when exceeded, the least recently used parse results are removed. Pruning is performed when
+ * the cache is created, and whenever a new parse result has been written.
+ */
+@interface ISSStyleSheetCache : NSObject
+
+/**
+ * The default cache directory - "InterfaCSS/StyleSheetCache" in the caches directory of the app.
+ */
++ (NSURL*) defaultCacheDirectoryURL;
+
+@property (nonatomic, strong, readonly) NSURL* cacheDirectoryURL;
+/** The maximum total size (in bytes) of all cached parse results. Default is 10 MB. */
+@property (nonatomic) unsigned long long maximumCacheSize;
+
+- (instancetype) initWithCacheDirectoryURL:(NSURL*)cacheDirectoryURL;
+
+/**
+ * Returns the cached parse result of the specified stylesheet data, if available, otherwise parses the stylesheet data using `parser` and caches the result.
+ */
+- (nullable NSMutableArray*) declarationsForStyleSheetData:(NSString*)styleSheetData parser:(id<ISSStyleSheetParser>)parser;
+
+/**
+ * Removes all cached parse results.
+ */
+- (void) removeAllCachedStyleSheets;
+
+@end
+
+
+NS_ASSUME_NONNULL_END
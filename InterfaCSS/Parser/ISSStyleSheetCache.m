@@ -0,0 +1,172 @@
+//
+//  ISSStyleSheetCache.m
+//  Part of InterfaCSS - http://www.github.com/tolo/InterfaCSS
+//
+//  Copyright (c) Tobias Löfstrand, Leafnode AB.
+//  License: MIT (http://www.github.com/tolo/InterfaCSS/LICENSE)
+//
+
+#import "ISSStyleSheetCache.h"
+
+#import <CommonCrypto/CommonDigest.h>
+
+#import "InterfaCSS.h"
+#import "ISSStyleSheetParser.h"
+#import "ISSStyleSheetCompiler.h"
+#import "ISSPropertyRegistry.h"
+#import "NSObject+ISSLogSupport.h"
+
+
+static const unsigned long long ISSStyleSheetCacheDefaultMaximumCacheSize = 10 * 1024 * 1024;
+
+
+@interface InterfaCSS (ISSStyleSheetCache)
+- (NSDictionary*) styleSheetVariablesSnapshot;
+- (NSArray*) styleSheetVariableDefinitionsRecordedDuringBlock:(void (^)(void))block;
+@end
+
+
+@implementation ISSStyleSheetCache {
+    dispatch_queue_t _ioQueue;
+}
+
++ (NSURL*) defaultCacheDirectoryURL {
+    NSURL* cachesDirectory = [[[NSFileManager defaultManager] URLsForDirectory:NSCachesDirectory inDomains:NSUserDomainMask] firstObject];
+    return [cachesDirectory URLByAppendingPathComponent:@"InterfaCSS/StyleSheetCache" isDirectory:YES];
+}
+
+- (instancetype) initWithCacheDirectoryURL:(NSURL*)cacheDirectoryURL {
+    if( self = [super init] ) {
+        _cacheDirectoryURL = cacheDirectoryURL;
+        _ioQueue = dispatch_queue_create("InterfaCSS.ISSStyleSheetCache", DISPATCH_QUEUE_SERIAL);
+        _maximumCacheSize = ISSStyleSheetCacheDefaultMaximumCacheSize;
+        dispatch_async(_ioQueue, ^{
+            [self pruneCache];
+        });
+    }
+    return self;
+}
+
+
+#pragma mark - Utils
+
+static void ISSStyleSheetCacheKeyAppend(CC_SHA256_CTX* context, NSString* string) {
+    NSData* data = [string dataUsingEncoding:NSUTF8StringEncoding];
+    uint64_t length = data.length;
+    CC_SHA256_Update(context, &length, sizeof(length)); // Length prefix, to keep key components unambiguous
+    CC_SHA256_Update(context, data.bytes, (CC_LONG)data.length);
+}
+
+- (NSString*) cacheKeyForStyleSheetData:(NSString*)styleSheetData parser:(id<ISSStyleSheetParser>)parser variables:(NSDictionary*)variables {
+    CC_SHA256_CTX context;
+    CC_SHA256_Init(&context);
+
+    ISSStyleSheetCacheKeyAppend(&context, NSStringFromClass([parser class]));
+    ISSStyleSheetCacheKeyAppend(&context, [InterfaCSS sharedInstance].propertyRegistry.propertyDefinitionsSignature);
+    // Variables defined before parsing may be referenced by (and thus affect the parse result of) the stylesheet
+    for(NSString* name in [variables.allKeys sortedArrayUsingSelector:@selector(compare:)]) {
+        ISSStyleSheetCacheKeyAppend(&context, name);
+        ISSStyleSheetCacheKeyAppend(&context, variables[name]);
+    }
+    ISSStyleSheetCacheKeyAppend(&context, styleSheetData);
+
+    unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256_Final(digest, &context);
+
+    NSMutableString* key = [NSMutableString stringWithCapacity:CC_SHA256_DIGEST_LENGTH * 2];
+    for(NSUInteger i = 0; i < CC_SHA256_DIGEST_LENGTH; i++) {
+        [key appendFormat:@"%02x", digest[i]];
+    }
+    return key;
+}
+
+- (NSURL*) cacheFileURLForKey:(NSString*)key {
+    return [[self.cacheDirectoryURL URLByAppendingPathComponent:key] URLByAppendingPathExtension:ISSCompiledStyleSheetFileExtension];
+}
+
+/**
+ * Removes the least recently used (i.e. least recently modified, see `declarationsForStyleSheetData:parser:`) parse results until the total size of the cache
+ * is within `maximumCacheSize`. Must be invoked on the IO queue.
+ */
+- (void) pruneCache {
+    NSArray* keys = @[NSURLContentModificationDateKey, NSURLFileSizeKey];
+    NSArray* files = [[NSFileManager defaultManager] contentsOfDirectoryAtURL:self.cacheDirectoryURL includingPropertiesForKeys:keys options:NSDirectoryEnumerationSkipsHiddenFiles error:nil];
+    if( !files.count ) return;
+
+    NSMutableArray* entries = [NSMutableArray arrayWithCapacity:files.count];
+    unsigned long long totalSize = 0;
+    for(NSURL* file in files) {
+        NSDictionary* values = [file resourceValuesForKeys:keys error:nil];
+        NSDate* date = values[NSURLContentModificationDateKey] ?: [NSDate distantPast];
+        NSNumber* size = values[NSURLFileSizeKey] ?: @0;
+        totalSize += size.unsignedLongLongValue;
+        [entries addObject:@[date, size, file]];
+    }
+    if( totalSize <= self.maximumCacheSize ) return;
+
+    [entries sortUsingComparator:^NSComparisonResult(NSArray* entry1, NSArray* entry2) {
+        return [entry1[0] compare:entry2[0]];
+    }];
+    for(NSArray* entry in entries) {
+        if( totalSize <= self.maximumCacheSize ) break;
+        if( [[NSFileManager defaultManager] removeItemAtURL:entry[2] error:nil] ) {
+            totalSize -= [entry[1] unsignedLongLongValue];
+            ISSLogTrace(@"Pruned cached parse result %@", [entry[2] lastPathComponent]);
+        }
+    }
+}
+
+
+#pragma mark - Public interface
+
+- (NSMutableArray*) declarationsForStyleSheetData:(NSString*)styleSheetData parser:(id<ISSStyleSheetParser>)parser {
+    InterfaCSS* interfaCSS = [InterfaCSS sharedInstance];
+    NSDictionary* variablesBeforeParsing = [interfaCSS styleSheetVariablesSnapshot];
+    NSString* key = [self cacheKeyForStyleSheetData:styleSheetData parser:parser variables:variablesBeforeParsing];
+    NSURL* cacheFileURL = [self cacheFileURLForKey:key];
+
+    NSData* cachedData = [NSData dataWithContentsOfURL:cacheFileURL options:NSDataReadingMappedIfSafe error:nil];
+    if( cachedData ) {
+        NSMutableArray* declarations = [ISSStyleSheetCompiler declarationsFromCompiledData:cachedData parser:parser];
+        if( declarations ) {
+            ISSLogTrace(@"Using cached parse result %@", key);
+            dispatch_async(_ioQueue, ^{ // Mark as recently used
+                [[NSFileManager defaultManager] setAttributes:@{NSFileModificationDate: [NSDate date]} ofItemAtPath:cacheFileURL.path error:nil];
+            });
+            return declarations;
+        }
+        ISSLogDebug(@"Ignoring invalid or incompatible cached parse result %@", key);
+    }
+
+    // Record the variables defined by the stylesheet (and nothing else, such as variables defined concurrently by another stylesheet), so that they can be
+    // redefined when the cached parse result is loaded
+    __block NSMutableArray* declarations = nil;
+    NSArray* variables = [interfaCSS styleSheetVariableDefinitionsRecordedDuringBlock:^{
+        declarations = [parser parse:styleSheetData];
+    }];
+    if( !declarations ) return nil;
+
+    NSData* compiledData = [ISSStyleSheetCompiler compiledDataWithDeclarations:declarations variables:variables parser:parser];
+    if( compiledData ) {
+        NSURL* cacheDirectoryURL = self.cacheDirectoryURL;
+        dispatch_async(_ioQueue, ^{
+            NSError* error = nil;
+            if( ![[NSFileManager defaultManager] createDirectoryAtURL:cacheDirectoryURL withIntermediateDirectories:YES attributes:nil error:&error] ||
+                    ![compiledData writeToURL:cacheFileURL options:NSDataWritingAtomic error:&error] ) {
+                ISSLogWarning(@"Error writing cached parse result to '%@' - %@", cacheFileURL, error);
+            }
+            [self pruneCache];
+        });
+    }
+
+    return declarations;
+}
+
+- (void) removeAllCachedStyleSheets {
+    NSURL* cacheDirectoryURL = self.cacheDirectoryURL;
+    dispatch_sync(_ioQueue, ^{
+        [[NSFileManager defaultManager] removeItemAtURL:cacheDirectoryURL error:nil];
+    });
+}
+
+@end
@@ -0,0 +1,71 @@
+//
+//  ISSStyleSheetCompiler.h
+//  Part of InterfaCSS - http://www.github.com/tolo/InterfaCSS
+//
+//  Copyright (c) Tobias Löfstrand, Leafnode AB.
+//  License: MIT (http://www.github.com/tolo/InterfaCSS/LICENSE)
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+@protocol ISSStyleSheetParser;
+
+
+/**
+ * File extension used for compiled stylesheets.
+ */
+extern NSString* const ISSCompiledStyleSheetFileExtension;
+
+
+/**
+ * Compiles stylesheets into a compact binary representation of the parsed `ISSPropertyDeclarations` (i.e. selector chains, property definition references,
+ * stylesheet variables and raw or, where possible, pre-transformed property values), and loads such compiled stylesheets without any text parsing.
+ *
+ * A compiled stylesheet is stored next to the stylesheet it was compiled from, using the file extension `ISSCompiledStyleSheetFileExtension`
+ * (i.e. "styles.css" is compiled to "styles.cssc"). Since compilation depends on the property registry (and thus UIKit), stylesheets are compiled on
+ * device or in the simulator, either using `compileStyleSheetAtURL:toURL:`, or at build time using the command line compiler `isscompile` (a simulator
+ * tool target, see Tools/isscompile/compile-stylesheets.sh for a script that builds and runs it, for instance from a build phase).
+ */
+@interface ISSStyleSheetCompiler : NSObject
+
+/**
+ * Returns the URL of the compiled stylesheet corresponding to the specified stylesheet URL.
+ */
++ (NSURL*) compiledStyleSheetURLForStyleSheetURL:(NSURL*)styleSheetURL;
+
+/**
+ * Parses the specified stylesheet data and returns the compiled representation of it, or `nil` if the stylesheet couldn't be parsed.
+ */
++ (nullable NSData*) compileStyleSheetData:(NSString*)styleSheetData;
+
+/**
+ * Parses the stylesheet at `styleSheetURL` and writes the compiled representation of it to `compiledStyleSheetURL`.
+ */
++ (BOOL) compileStyleSheetAtURL:(NSURL*)styleSheetURL toURL:(NSURL*)compiledStyleSheetURL;
+
+/**
+ * Returns the compiled representation of the specified (already parsed) declarations and the stylesheet variables they were parsed with. Values that can be
+ * transformed at compile time are transformed using the specified parser.
+ */
++ (nullable NSData*) compiledDataWithDeclarations:(NSArray*)declarations variables:(nullable NSArray*)variables parser:(id<ISSStyleSheetParser>)parser;
+
+/**
+ * Builds `ISSPropertyDeclarations` from the specified compiled stylesheet data, and defines any stylesheet variables contained in it. Property values that
+ * aren't pre-transformed will be transformed lazily by `parser`. Returns `nil` if the data isn't valid (or was compiled with an incompatible version).
+ */
++ (nullable NSMutableArray*) declarationsFromCompiledData:(NSData*)compiledData parser:(id<ISSStyleSheetParser>)parser;
+
+/**
+ * Loads the compiled stylesheet for the specified stylesheet URL (which may also be the URL of a compiled stylesheet), if it exists and is up to date with
+ * the stylesheet it was compiled from (if present). The size and modification time of the stylesheet are compared with the ones recorded when compiling, and
+ * the contents of the stylesheet are only hashed if the modification time differs. The compiled stylesheet file is memory mapped. Returns `nil` if there is no (valid) compiled stylesheet.
+ */
++ (nullable NSMutableArray*) loadCompiledStyleSheetForStyleSheetURL:(NSURL*)styleSheetURL parser:(id<ISSStyleSheetParser>)parser;
+
+@end
+
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,760 @@
+//
+//  ISSStyleSheetCompiler.m
+//  Part of InterfaCSS - http://www.github.com/tolo/InterfaCSS
+//
+//  Copyright (c) Tobias Löfstrand, Leafnode AB.
+//  License: MIT (http://www.github.com/tolo/InterfaCSS/LICENSE)
+//
+
+#import "ISSStyleSheetCompiler.h"
+
+#import "InterfaCSS.h"
+#import "ISSStyleSheetParser.h"
+#import "ISSDefaultStyleSheetParser.h"
+#import "ISSPropertyRegistry.h"
+#import "ISSPropertyDefinition.h"
+#import "ISSPropertyDeclarations.h"
+#import "ISSPropertyDeclaration.h"
+#import "ISSSelectorChain.h"
+#import "ISSSelector.h"
+#import "ISSNestedElementSelector.h"
+#import "ISSPseudoClass.h"
+#import "NSObject+ISSLogSupport.h"
+
+
+NSString* const ISSCompiledStyleSheetFileExtension = @"cssc";
+
+
+/*
+ * Compiled stylesheet format (all integers are little endian, strings are referenced by their index in the string table, UINT32_MAX means nil):
+ *
+ *  Header:         "ISSC" | uint32 format version | uint64 source length | int64 source modification time (ms) | uint64 source hash | uint32 string count
+ *  String table:   (uint32 UTF-8 byte length | bytes)*
+ *  Variables:      uint32 count | (string name | string value)*
+ *  Declarations:   uint32 count | (uint32 chain count | chain* | uint8 has extended chain | [chain] | uint32 property count (or nil) | property*)*
+ *  Chain:          uint32 component count | (uint8 component kind | component)*
+ *  Selector:       string type | string element id | uint32 class count | string* | uint32 pseudo class count | (string type | int64 a | int64 b | string parameter)*
+ *  Property:       uint8 recognized | string name | value (unrecognized), or string property name | string nested element key path | uint32 parameter count (or nil) | value* | value
+ *  Value:          uint8 value kind | (string | int64 | double | uint8)
+ */
+static const char ISSCompiledStyleSheetMagic[4] = {'I', 'S', 'S', 'C'};
+static const uint32_t ISSCompiledStyleSheetFormatVersion = 2;
+static const uint32_t ISSCompiledNil = UINT32_MAX;
+static const NSUInteger ISSCompiledStyleSheetHeaderLength = 4 + 4 + 8 + 8 + 8 + 4;
+
+typedef NS_ENUM(uint8_t, ISSCompiledComponentKind) {
+    ISSCompiledComponentKindSelector,
+    ISSCompiledComponentKindNestedElementSelector,
+    ISSCompiledComponentKindCombinator
+};
+
+typedef NS_ENUM(uint8_t, ISSCompiledValueKind) {
+    ISSCompiledValueKindNil,
+    ISSCompiledValueKindRawValue, // Raw (untransformed) property value, transformed lazily when loaded
+    ISSCompiledValueKindCurrentValue,
+    ISSCompiledValueKindBool,
+    ISSCompiledValueKindInteger,
+    ISSCompiledValueKindDouble,
+    ISSCompiledValueKindString
+};
+
+
+static uint64_t ISSCompiledStyleSheetSourceHash(const void* bytes, NSUInteger length) {
+    // 64-bit FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    const uint8_t* b = bytes;
+    for(NSUInteger i = 0; i < length; i++) {
+        hash ^= b[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static BOOL ISSCompiledStyleSheetSourceAttributes(NSURL* styleSheetURL, uint64_t* sourceLength, int64_t* sourceModificationTime) {
+    NSDictionary* attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:styleSheetURL.path error:nil];
+    if( !attributes ) return NO;
+    *sourceLength = [attributes fileSize];
+    *sourceModificationTime = (int64_t)([[attributes fileModificationDate] timeIntervalSince1970] * 1000);
+    return YES;
+}
+
+
+#pragma mark - ISSVariableRecordingStyleSheetParser
+
+@interface ISSDefaultStyleSheetParser (ISSStyleSheetCompiler)
+- (void) defineVariableWithName:(NSString*)name value:(NSString*)value;
+@end
+
+/**
+ * Parser used when compiling stylesheets, that keeps track of the variables defined in the stylesheet (in order of definition).
+ */
+@interface ISSVariableRecordingStyleSheetParser : ISSDefaultStyleSheetParser
+@property (nonatomic, strong, readonly) NSMutableArray* variables;
+@end
+
+@implementation ISSVariableRecordingStyleSheetParser
+
+- (id) init {
+    if ( (self = [super init]) ) {
+        _variables = [[NSMutableArray alloc] init];
+    }
+    return self;
+}
+
+- (void) defineVariableWithName:(NSString*)name value:(NSString*)value {
+    [super defineVariableWithName:name value:value];
+    [self.variables addObject:@[name, value]];
+}
+
+@end
+
+
+#pragma mark - ISSCompiledStyleSheetWriter
+
+@interface ISSCompiledStyleSheetWriter : NSObject
+@property (nonatomic, readonly) BOOL failed;
+- (instancetype) initWithParser:(id<ISSStyleSheetParser>)parser;
+- (void) writeCount:(NSUInteger)count;
+- (void) writeString:(NSString*)string;
+- (void) writeDeclarations:(ISSPropertyDeclarations*)declarations;
+- (NSData*) dataWithSourceLength:(uint64_t)sourceLength sourceModificationTime:(int64_t)sourceModificationTime sourceHash:(uint64_t)sourceHash;
+@end
+
+@implementation ISSCompiledStyleSheetWriter {
+    id<ISSStyleSheetParser> _parser;
+    NSMutableData* _body;
+    NSMutableArray* _strings;
+    NSMutableDictionary* _stringIndexes;
+}
+
+- (instancetype) initWithParser:(id<ISSStyleSheetParser>)parser {
+    if( self = [super init] ) {
+        _parser = parser;
+        _body = [[NSMutableData alloc] init];
+        _strings = [[NSMutableArray alloc] init];
+        _stringIndexes = [[NSMutableDictionary alloc] init];
+    }
+    return self;
+}
+
+- (void) fail:(NSString*)reason {
+    if( !_failed ) ISSLogWarning(@"Unable to compile stylesheet - %@", reason);
+    _failed = YES;
+}
+
+- (void) writeUInt8:(uint8_t)value {
+    [_body appendBytes:&value length:1];
+}
+
+- (void) writeUInt32:(uint32_t)value {
+    value = CFSwapInt32HostToLittle(value);
+    [_body appendBytes:&value length:4];
+}
+
+- (void) writeInt64:(int64_t)value {
+    uint64_t v = CFSwapInt64HostToLittle((uint64_t)value);
+    [_body appendBytes:&v length:8];
+}
+
+- (void) writeDouble:(double)value {
+    CFSwappedFloat64 v = CFConvertFloat64HostToSwapped(value);
+    [_body appendBytes:&v length:8];
+}
+
+- (void) writeCount:(NSUInteger)count {
+    [self writeUInt32:(uint32_t)count];
+}
+
+- (void) writeString:(NSString*)string {
+    if( !string ) {
+        [self writeUInt32:ISSCompiledNil];
+        return;
+    }
+    NSNumber* index = _stringIndexes[string];
+    if( !index ) {
+        index = @(_strings.count);
+        _stringIndexes[string] = index;
+        [_strings addObject:string];
+    }
+    [self writeUInt32:(uint32_t)index.unsignedIntegerValue];
+}
+
+- (void) writeValue:(id)value {
+    if( !value ) {
+        [self writeUInt8:ISSCompiledValueKindNil];
+    } else if( value == ISSPropertyDefinitionUseCurrentValue ) {
+        [self writeUInt8:ISSCompiledValueKindCurrentValue];
+    } else if( [value isKindOfClass:NSString.class] ) {
+        [self writeUInt8:ISSCompiledValueKindString];
+        [self writeString:value];
+    } else if( [value isKindOfClass:NSNumber.class] ) {
+        NSNumber* number = value;
+        const char* objCType = number.objCType;
+        if( CFGetTypeID((__bridge CFTypeRef)number) == CFBooleanGetTypeID() ) {
+            [self writeUInt8:ISSCompiledValueKindBool];
+            [self writeUInt8:number.boolValue ? 1 : 0];
+        } else if( strcmp(objCType, @encode(double)) == 0 || strcmp(objCType, @encode(float)) == 0 ) {
+            [self writeUInt8:ISSCompiledValueKindDouble];
+            [self writeDouble:number.doubleValue];
+        } else {
+            [self writeUInt8:ISSCompiledValueKindInteger];
+            [self writeInt64:number.longLongValue];
+        }
+    } else {
+        [self fail:[NSString stringWithFormat:@"unsupported value: %@", value]];
+    }
+}
+
+- (void) writePropertyValueOfDeclaration:(ISSPropertyDeclaration*)declaration {
+    id value = declaration.propertyValue;
+    if( declaration.lazyPropertyTransformationBlock && [value isKindOfClass:NSString.class] ) {
+        // Pre-transform static values of simple types (the raw value is kept for all other types, and transformed lazily when loaded)
+        ISSPropertyDefinition* property = declaration.property;
+        ISSPropertyType type = property.type;
+        if( !property.supportsDynamicValue && (type == ISSPropertyTypeBool || type == ISSPropertyTypeNumber || type == ISSPropertyTypeEnumType) ) {
+            id transformedValue = [_parser transformValue:value forPropertyDefinition:property replaceVariableReferences:NO];
+            if( [transformedValue isKindOfClass:NSNumber.class] ) {
+                [self writeValue:transformedValue];
+                return;
+            }
+        }
+        [self writeUInt8:ISSCompiledValueKindRawValue];
+        [self writeString:value];
+    } else {
+        [self writeValue:value];
+    }
+}
+
+- (void) writePropertyDeclaration:(ISSPropertyDeclaration*)declaration {
+    if( declaration.unrecognizedName ) {
+        [self writeUInt8:0];
+        [self writeString:declaration.unrecognizedName];
+        [self writeValue:declaration.propertyValue];
+    } else {
+        [self writeUInt8:1];
+        [self writeString:declaration.property.name];
+        [self writeString:declaration.nestedElementKeyPath];
+        if( declaration.parameters ) {
+            [self writeCount:declaration.parameters.count];
+            for(id parameter in declaration.parameters) {
+                [self writeValue:parameter];
+            }
+        } else {
+            [self writeUInt32:ISSCompiledNil];
+        }
+        [self writePropertyValueOfDeclaration:declaration];
+    }
+}
+
+- (void) writeSelector:(ISSSelector*)selector {
+    if( [selector isKindOfClass:ISSNestedElementSelector.class] ) {
+        [self writeUInt8:ISSCompiledComponentKindNestedElementSelector];
+        [self writeString:((ISSNestedElementSelector*)selector).nestedElementKeyPath];
+        return;
+    }
+
+    [self writeUInt8:ISSCompiledComponentKindSelector];
+
+    NSString* type = nil;
+    if( selector.wildcardType ) type = @"*";
+    else if( selector.type ) type = [[InterfaCSS sharedInstance].propertyRegistry canonicalTypeForClass:selector.type] ?: NSStringFromClass(selector.type);
+    [self writeString:type];
+    [self writeString:selector.elementId];
+
+    [self writeCount:selector.styleClasses.count];
+    for(NSString* styleClass in selector.styleClasses) {
+        [self writeString:styleClass];
+    }
+
+    [self writeCount:selector.pseudoClasses.count];
+    for(ISSPseudoClass* pseudoClass in selector.pseudoClasses) {
+        NSString* pseudoClassType = [ISSPseudoClass stringFromPseudoClassType:pseudoClass.pseudoClassType];
+        if( !pseudoClassType ) [self fail:[NSString stringWithFormat:@"unsupported pseudo class: %@", pseudoClass]];
+        [self writeString:pseudoClassType];
+        [self writeInt64:pseudoClass.a];
+        [self writeInt64:pseudoClass.b];
+        [self writeString:pseudoClass.parameter];
+    }
+}
+
+- (void) writeSelectorChain:(ISSSelectorChain*)selectorChain {
+    [self writeCount:selectorChain.selectorComponents.count];
+    for(id component in selectorChain.selectorComponents) {
+        if( [component isKindOfClass:ISSSelector.class] ) {
+            [self writeSelector:component];
+        } else {
+            [self writeUInt8:ISSCompiledComponentKindCombinator];
+            [self writeUInt8:(uint8_t)[component integerValue]];
+        }
+    }
+}
+
+- (void) writeDeclarations:(ISSPropertyDeclarations*)declarations {
+    [self writeCount:declarations.selectorChains.count];
+    for(ISSSelectorChain* selectorChain in declarations.selectorChains) {
+        [self writeSelectorChain:selectorChain];
+    }
+
+    if( declarations.extendedDeclarationSelectorChain ) {
+        [self writeUInt8:1];
+        [self writeSelectorChain:declarations.extendedDeclarationSelectorChain];
+    } else {
+        [self writeUInt8:0];
+    }
+
+    if( declarations.properties ) {
+        [self writeCount:declarations.properties.count];
+        for(ISSPropertyDeclaration* declaration in declarations.properties) {
+            [self writePropertyDeclaration:declaration];
+        }
+    } else {
+        [self writeUInt32:ISSCompiledNil];
+    }
+}
+
+- (NSData*) dataWithSourceLength:(uint64_t)sourceLength sourceModificationTime:(int64_t)sourceModificationTime sourceHash:(uint64_t)sourceHash {
+    NSMutableData* data = [[NSMutableData alloc] initWithCapacity:ISSCompiledStyleSheetHeaderLength + _body.length];
+
+    // Header
+    [data appendBytes:ISSCompiledStyleSheetMagic length:4];
+    uint32_t version = CFSwapInt32HostToLittle(ISSCompiledStyleSheetFormatVersion);
+    [data appendBytes:&version length:4];
+    sourceLength = CFSwapInt64HostToLittle(sourceLength);
+    [data appendBytes:&sourceLength length:8];
+    uint64_t modificationTime = CFSwapInt64HostToLittle((uint64_t)sourceModificationTime);
+    [data appendBytes:&modificationTime length:8];
+    sourceHash = CFSwapInt64HostToLittle(sourceHash);
+    [data appendBytes:&sourceHash length:8];
+    uint32_t stringCount = CFSwapInt32HostToLittle((uint32_t)_strings.count);
+    [data appendBytes:&stringCount length:4];
+
+    // String table
+    for(NSString* string in _strings) {
+        NSData* utf8 = [string dataUsingEncoding:NSUTF8StringEncoding];
+        uint32_t length = CFSwapInt32HostToLittle((uint32_t)utf8.length);
+        [data appendBytes:&length length:4];
+        [data appendData:utf8];
+    }
+
+    [data appendData:_body];
+    return data;
+}
+
+@end
+
+
+#pragma mark - ISSCompiledStyleSheetReader
+
+@interface ISSCompiledStyleSheetReader : NSObject
+@property (nonatomic, readonly) BOOL failed;
+- (instancetype) initWithData:(NSData*)data parser:(id<ISSStyleSheetParser>)parser;
+- (BOOL) readHeaderWithSourceLength:(uint64_t*)sourceLength sourceModificationTime:(int64_t*)sourceModificationTime sourceHash:(uint64_t*)sourceHash;
+- (NSMutableArray*) readStyleSheet;
+@end
+
+@implementation ISSCompiledStyleSheetReader {
+    id<ISSStyleSheetParser> _parser;
+    NSDictionary* _propertyNameToProperty;
+    const uint8_t* _bytes;
+    NSUInteger _length;
+    NSUInteger _position;
+    NSMutableArray* _strings;
+}
+
+- (instancetype) initWithData:(NSData*)data parser:(id<ISSStyleSheetParser>)parser {
+    if( self = [super init] ) {
+        _parser = parser;
+        _bytes = data.bytes;
+        _length = data.length;
+    }
+    return self;
+}
+
+- (void) fail {
+    _failed = YES;
+}
+
+- (BOOL) readBytes:(void*)bytes length:(NSUInteger)length {
+    if( _failed || length > (_length - _position) ) {
+        _failed = YES;
+        memset(bytes, 0, length);
+        return NO;
+    }
+    memcpy(bytes, _bytes + _position, length);
+    _position += length;
+    return YES;
+}
+
+- (uint8_t) readUInt8 {
+    uint8_t value = 0;
+    [self readBytes:&value length:1];
+    return value;
+}
+
+- (uint32_t) readUInt32 {
+    uint32_t value = 0;
+    [self readBytes:&value length:4];
+    return CFSwapInt32LittleToHost(value);
+}
+
+- (uint64_t) readUInt64 {
+    uint64_t value = 0;
+    [self readBytes:&value length:8];
+    return CFSwapInt64LittleToHost(value);
+}
+
+- (double) readDouble {
+    CFSwappedFloat64 value = {0};
+    [self readBytes:&value length:8];
+    return CFConvertFloat64SwappedToHost(value);
+}
+
+- (uint32_t) readCount {
+    uint32_t count = [self readUInt32];
+    if( count != ISSCompiledNil && count > (_length - _position) ) [self fail]; // Each entry occupies at least one byte
+    return count;
+}
+
+- (NSString*) readString {
+    uint32_t index = [self readUInt32];
+    if( index == ISSCompiledNil || _failed ) return nil;
+    if( index >= _strings.count ) {
+        [self fail];
+        return nil;
+    }
+    return _strings[index];
+}
+
+- (BOOL) readHeaderWithSourceLength:(uint64_t*)sourceLength sourceModificationTime:(int64_t*)sourceModificationTime sourceHash:(uint64_t*)sourceHash {
+    char magic[4];
+    [self readBytes:magic length:4];
+    uint32_t version = [self readUInt32];
+    uint64_t length = [self readUInt64];
+    int64_t modificationTime = (int64_t)[self readUInt64];
+    uint64_t hash = [self readUInt64];
+    if( _failed || memcmp(magic, ISSCompiledStyleSheetMagic, 4) != 0 || version != ISSCompiledStyleSheetFormatVersion ) {
+        [self fail];
+        return NO;
+    }
+    if( sourceLength ) *sourceLength = length;
+    if( sourceModificationTime ) *sourceModificationTime = modificationTime;
+    if( sourceHash ) *sourceHash = hash;
+    return YES;
+}
+
+- (void) readStringTable {
+    uint32_t count = [self readCount];
+    _strings = [[NSMutableArray alloc] initWithCapacity:_failed ? 0 : count];
+    for(uint32_t i = 0; i < count && !_failed; i++) {
+        uint32_t length = [self readUInt32];
+        if( _failed || length > (_length - _position) ) {
+            [self fail];
+            break;
+        }
+        NSString* string = [[NSString alloc] initWithBytes:_bytes + _position length:length encoding:NSUTF8StringEncoding];
+        if( !string ) [self fail];
+        else [_strings addObject:string];
+        _position += length;
+    }
+}
+
+- (id) readValueWithRawValueProperty:(ISSPropertyDefinition*)property {
+    switch( [self readUInt8] ) {
+        case ISSCompiledValueKindNil: return nil;
+        case ISSCompiledValueKindCurrentValue: return ISSPropertyDefinitionUseCurrentValue;
+        case ISSCompiledValueKindBool: return @([self readUInt8] != 0);
+        case ISSCompiledValueKindInteger: return @((long long)[self readUInt64]);
+        case ISSCompiledValueKindDouble: return @([self readDouble]);
+        case ISSCompiledValueKindString: return [self readString];
+        case ISSCompiledValueKindRawValue: {
+            if( !property ) [self fail];
+            return [self readString];
+        }
+        default: {
+            [self fail];
+            return nil;
+        }
+    }
+}
+
+- (ISSPropertyDeclaration*) readPropertyDeclaration {
+    if( [self readUInt8] == 0 ) {
+        ISSPropertyDeclaration* unrecognized = [[ISSPropertyDeclaration alloc] initWithUnrecognizedProperty:[self readString] ?: @""];
+        unrecognized.propertyValue = [self readValueWithRawValueProperty:nil];
+        return unrecognized;
+    }
+
+    NSString* propertyName = [self readString];
+    ISSPropertyDefinition* property = propertyName ? _propertyNameToProperty[[propertyName lowercaseString]] : nil;
+    if( !property ) {
+        if( !_failed ) ISSLogDebug(@"Property '%@' in compiled stylesheet not found", propertyName);
+        [self fail];
+        return nil;
+    }
+    NSString* nestedElementKeyPath = [self readString];
+
+    NSMutableArray* parameters = nil;
+    uint32_t parameterCount = [self readCount];
+    if( parameterCount != ISSCompiledNil ) {
+        parameters = [[NSMutableArray alloc] init];
+        for(uint32_t i = 0; i < parameterCount && !_failed; i++) {
+            id parameter = [self readValueWithRawValueProperty:nil];
+            if( parameter ) [parameters addObject:parameter];
+        }
+    }
+
+    ISSPropertyDeclaration* declaration = [[ISSPropertyDeclaration alloc] initWithProperty:property parameters:parameters nestedElementKeyPath:nestedElementKeyPath];
+    NSUInteger valuePosition = _position;
+    id value = [self readValueWithRawValueProperty:property];
+    if( !_failed && _bytes[valuePosition] == ISSCompiledValueKindRawValue ) {
+        // Perform lazy transformation of property value (same as ISSDefaultStyleSheetParser)
+        id<ISSStyleSheetParser> parser = _parser;
+        NSString* rawValue = value;
+        declaration.lazyPropertyTransformationBlock = ^id(ISSPropertyDeclaration* blockDecl) {
+            return [parser transformValue:rawValue forPropertyDefinition:blockDecl.property replaceVariableReferences:NO];
+        };
+    }
+    declaration.propertyValue = value;
+    return declaration;
+}
+
+- (ISSSelector*) readSelector {
+    NSString* type = [self readString];
+    NSString* elementId = [self readString];
+
+    uint32_t styleClassCount = [self readCount];
+    NSMutableArray* styleClasses = styleClassCount && !_failed ? [[NSMutableArray alloc] initWithCapacity:styleClassCount] : nil;
+    for(uint32_t i = 0; i < styleClassCount && !_failed; i++) {
+        NSString* styleClass = [self readString];
+        if( styleClass ) [styleClasses addObject:styleClass];
+    }
+
+    uint32_t pseudoClassCount = [self readCount];
+    NSMutableArray* pseudoClasses = pseudoClassCount && !_failed ? [[NSMutableArray alloc] initWithCapacity:pseudoClassCount] : nil;
+    for(uint32_t i = 0; i < pseudoClassCount && !_failed; i++) {
+        NSString* pseudoClassTypeString = [self readString];
+        NSInteger a = (NSInteger)[self readUInt64];
+        NSInteger b = (NSInteger)[self readUInt64];
+        NSString* parameter = [self readString];
+        if( _failed ) break;
+
+        @try {
+            ISSPseudoClassType pseudoClassType = [ISSPseudoClass pseudoClassTypeFromString:pseudoClassTypeString];
+            if( parameter ) [pseudoClasses addObject:[ISSPseudoClass pseudoClassWithType:pseudoClassType andParameter:parameter]];
+            else [pseudoClasses addObject:[ISSPseudoClass structuralPseudoClassWithA:a b:b type:pseudoClassType]];
+        } @catch (NSException* e) {
+            ISSLogDebug(@"Pseudo class '%@' in compiled stylesheet not supported", pseudoClassTypeString);
+            [self fail];
+        }
+    }
+
+    if( _failed ) return nil;
+    ISSSelector* selector = [ISSSelector selectorWithType:type elementId:elementId styleClasses:styleClasses pseudoClasses:pseudoClasses];
+    if( !selector ) [self fail];
+    return selector;
+}
+
+- (ISSSelectorChain*) readSelectorChain {
+    uint32_t componentCount = [self readCount];
+    NSMutableArray* components = [[NSMutableArray alloc] initWithCapacity:_failed ? 0 : componentCount];
+    for(uint32_t i = 0; i < componentCount && !_failed; i++) {
+        id component = nil;
+        switch( [self readUInt8] ) {
+            case ISSCompiledComponentKindSelector: {
+                component = [self readSelector];
+                break;
+            }
+            case ISSCompiledComponentKindNestedElementSelector: {
+                NSString* nestedElementKeyPath = [self readString];
+                if( nestedElementKeyPath ) component = [ISSNestedElementSelector selectorWithNestedElementKeyPath:nestedElementKeyPath];
+                break;
+            }
+            case ISSCompiledComponentKindCombinator: {
+                component = @((ISSSelectorCombinator)[self readUInt8]);
+                break;
+            }
+        }
+        if( component ) [components addObject:component];
+        else [self fail];
+    }
+
+    ISSSelectorChain* selectorChain = _failed ? nil : [ISSSelectorChain selectorChainWithComponents:components];
+    if( !selectorChain ) [self fail];
+    return selectorChain;
+}
+
+- (ISSPropertyDeclarations*) readDeclarations {
+    uint32_t chainCount = [self readCount];
+    NSMutableArray* selectorChains = [[NSMutableArray alloc] initWithCapacity:_failed ? 0 : chainCount];
+    for(uint32_t i = 0; i < chainCount && !_failed; i++) {
+        ISSSelectorChain* selectorChain = [self readSelectorChain];
+        if( selectorChain ) [selectorChains addObject:selectorChain];
+    }
+
+    ISSSelectorChain* extendedDeclarationSelectorChain = [self readUInt8] ? [self readSelectorChain] : nil;
+
+    NSMutableArray* properties = nil;
+    uint32_t propertyCount = [self readCount];
+    if( propertyCount != ISSCompiledNil ) {
+        properties = [[NSMutableArray alloc] initWithCapacity:_failed ? 0 : propertyCount];
+        for(uint32_t i = 0; i < propertyCount && !_failed; i++) {
+            ISSPropertyDeclaration* declaration = [self readPropertyDeclaration];
+            if( declaration ) [properties addObject:declaration];
+        }
+    }
+
+    if( _failed ) return nil;
+    return [[ISSPropertyDeclarations alloc] initWithSelectorChains:selectorChains andProperties:properties extendedDeclarationSelectorChain:extendedDeclarationSelectorChain];
+}
+
+- (NSMutableArray*) readStyleSheet {
+    if( ![self readHeaderWithSourceLength:NULL sourceModificationTime:NULL sourceHash:NULL] ) return nil;
+    [self readStringTable];
+
+    // Build dictionary of all known (lowercase) property names mapped to ISSPropertyDefinitions (same as ISSDefaultStyleSheetParser)
+    NSMutableDictionary* propertyNameToProperty = [[NSMutableDictionary alloc] init];
+    for(ISSPropertyDefinition* p in [InterfaCSS sharedInstance].propertyRegistry.propertyDefinitions) {
+        for(NSString* lowerCaseAlias in p.allNames) {
+            propertyNameToProperty[lowerCaseAlias] = p;
+        }
+    }
+    _propertyNameToProperty = propertyNameToProperty;
+
+    // Variables
+    NSMutableArray* variables = [[NSMutableArray alloc] init];
+    uint32_t variableCount = [self readCount];
+    for(uint32_t i = 0; i < variableCount && !_failed; i++) {
+        NSString* name = [self readString];
+        NSString* value = [self readString];
+        if( name && value ) [variables addObject:@[name, value]];
+        else [self fail];
+    }
+
+    // Declarations
+    uint32_t declarationsCount = [self readCount];
+    NSMutableArray* result = [[NSMutableArray alloc] initWithCapacity:_failed ? 0 : declarationsCount];
+    for(uint32_t i = 0; i < declarationsCount && !_failed; i++) {
+        ISSPropertyDeclarations* declarations = [self readDeclarations];
+        if( declarations ) [result addObject:declarations];
+    }
+
+    if( _failed ) return nil;
+
+    // Define variables only when the whole compiled stylesheet is valid
+    for(NSArray* variable in variables) {
+        [[InterfaCSS sharedInstance] setValue:variable[1] forStyleSheetVariableWithName:variable[0]];
+    }
+    return result;
+}
+
+@end
+
+
+#pragma mark - ISSStyleSheetCompiler
+
+@implementation ISSStyleSheetCompiler
+
++ (NSURL*) compiledStyleSheetURLForStyleSheetURL:(NSURL*)styleSheetURL {
+    if( [styleSheetURL.pathExtension isEqualToString:ISSCompiledStyleSheetFileExtension] ) return styleSheetURL;
+    return [[styleSheetURL URLByDeletingPathExtension] URLByAppendingPathExtension:ISSCompiledStyleSheetFileExtension];
+}
+
++ (NSData*) compileStyleSheetData:(NSString*)styleSheetData sourceData:(NSData*)sourceData sourceModificationTime:(int64_t)sourceModificationTime {
+    ISSVariableRecordingStyleSheetParser* parser = [[ISSVariableRecordingStyleSheetParser alloc] init];
+    NSMutableArray* declarations = [parser parse:styleSheetData];
+    if( !declarations ) return nil;
+
+    ISSCompiledStyleSheetWriter* writer = [[ISSCompiledStyleSheetWriter alloc] initWithParser:parser];
+    [self writeDeclarations:declarations variables:parser.variables withWriter:writer];
+    return writer.failed ? nil : [writer dataWithSourceLength:sourceData.length sourceModificationTime:sourceModificationTime sourceHash:ISSCompiledStyleSheetSourceHash(sourceData.bytes, sourceData.length)];
+}
+
++ (NSData*) compileStyleSheetData:(NSString*)styleSheetData {
+    return [self compileStyleSheetData:styleSheetData sourceData:[styleSheetData dataUsingEncoding:NSUTF8StringEncoding] sourceModificationTime:0];
+}
+
++ (BOOL) compileStyleSheetAtURL:(NSURL*)styleSheetURL toURL:(NSURL*)compiledStyleSheetURL {
+    NSError* error = nil;
+    NSData* sourceData = [NSData dataWithContentsOfURL:styleSheetURL options:0 error:&error];
+    NSString* styleSheetData = sourceData ? [NSString stringWithContentsOfURL:styleSheetURL usedEncoding:nil error:&error] : nil;
+    if( !styleSheetData ) {
+        ISSLogWarning(@"Error loading stylesheet data from '%@' - %@", styleSheetURL, error);
+        return NO;
+    }
+
+    uint64_t sourceLength = 0;
+    int64_t sourceModificationTime = 0;
+    ISSCompiledStyleSheetSourceAttributes(styleSheetURL, &sourceLength, &sourceModificationTime);
+
+    NSData* compiledData = [self compileStyleSheetData:styleSheetData sourceData:sourceData sourceModificationTime:sourceModificationTime];
+    if( !compiledData ) return NO;
+
+    if( ![compiledData writeToURL:compiledStyleSheetURL options:NSDataWritingAtomic error:&error] ) {
+        ISSLogWarning(@"Error writing compiled stylesheet to '%@' - %@", compiledStyleSheetURL, error);
+        return NO;
+    }
+    return YES;
+}
+
++ (void) writeDeclarations:(NSArray*)declarations variables:(NSArray*)variables withWriter:(ISSCompiledStyleSheetWriter*)writer {
+    [writer writeCount:variables.count];
+    for(NSArray* variable in variables) {
+        [writer writeString:variable[0]];
+        [writer writeString:variable[1]];
+    }
+
+    [writer writeCount:declarations.count];
+    for(ISSPropertyDeclarations* propertyDeclarations in declarations) {
+        [writer writeDeclarations:propertyDeclarations];
+    }
+}
+
++ (NSData*) compiledDataWithDeclarations:(NSArray*)declarations variables:(NSArray*)variables parser:(id<ISSStyleSheetParser>)parser {
+    ISSCompiledStyleSheetWriter* writer = [[ISSCompiledStyleSheetWriter alloc] initWithParser:parser];
+    [self writeDeclarations:declarations variables:variables withWriter:writer];
+    return writer.failed ? nil : [writer dataWithSourceLength:0 sourceModificationTime:0 sourceHash:0];
+}
+
++ (NSMutableArray*) declarationsFromCompiledData:(NSData*)compiledData parser:(id<ISSStyleSheetParser>)parser {
+    ISSCompiledStyleSheetReader* reader = [[ISSCompiledStyleSheetReader alloc] initWithData:compiledData parser:parser];
+    return [reader readStyleSheet];
+}
+
++ (NSMutableArray*) loadCompiledStyleSheetForStyleSheetURL:(NSURL*)styleSheetURL parser:(id<ISSStyleSheetParser>)parser {
+    if( !styleSheetURL.isFileURL ) return nil;
+
+    NSURL* compiledStyleSheetURL = [self compiledStyleSheetURLForStyleSheetURL:styleSheetURL];
+    if( ![[NSFileManager defaultManager] fileExistsAtPath:compiledStyleSheetURL.path] ) return nil;
+
+    NSError* error = nil;
+    NSData* compiledData = [NSData dataWithContentsOfURL:compiledStyleSheetURL options:NSDataReadingMappedIfSafe error:&error];
+    if( !compiledData ) {
+        ISSLogWarning(@"Error loading compiled stylesheet from '%@' - %@", compiledStyleSheetURL, error);
+        return nil;
+    }
+
+    // If the source stylesheet is present - make sure the compiled stylesheet is up to date
+    uint64_t currentSourceLength = 0;
+    int64_t currentSourceModificationTime = 0;
+    if( ![compiledStyleSheetURL isEqual:styleSheetURL] && ISSCompiledStyleSheetSourceAttributes(styleSheetURL, &currentSourceLength, &currentSourceModificationTime) ) {
+        uint64_t sourceLength = 0, sourceHash = 0;
+        int64_t sourceModificationTime = 0;
+        ISSCompiledStyleSheetReader* headerReader = [[ISSCompiledStyleSheetReader alloc] initWithData:compiledData parser:parser];
+        BOOL upToDate = [headerReader readHeaderWithSourceLength:&sourceLength sourceModificationTime:&sourceModificationTime sourceHash:&sourceHash] && sourceLength == currentSourceLength;
+        // Only hash the contents of the source stylesheet if the modification time differs (i.e. file may have been copied or touched without being changed)
+        if( upToDate && sourceModificationTime != currentSourceModificationTime ) {
+            NSData* sourceData = [NSData dataWithContentsOfURL:styleSheetURL options:NSDataReadingMappedIfSafe error:nil];
+            upToDate = sourceData && sourceData.length == sourceLength && sourceHash == ISSCompiledStyleSheetSourceHash(sourceData.bytes, sourceData.length);
+        }
+        if( !upToDate ) {
+            ISSLogDebug(@"Compiled stylesheet '%@' is not up to date - ignoring", [compiledStyleSheetURL lastPathComponent]);
+            return nil;
+        }
+    }
+
+    NSMutableArray* declarations = [self declarationsFromCompiledData:compiledData parser:parser];
+    if( !declarations ) ISSLogWarning(@"Invalid or incompatible compiled stylesheet: '%@'", [compiledStyleSheetURL lastPathComponent]);
+    return declarations;
+}
+
+@end
@@ -0,0 +1,64 @@
+//
+//  ISSStyleSheetTokenizer.h
+//  Part of InterfaCSS - http://www.github.com/tolo/InterfaCSS
+//
+//  Copyright (c) Tobias Löfstrand, Leafnode AB.
+//  License: MIT (http://www.github.com/tolo/InterfaCSS/LICENSE)
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+/**
+ * Protocol used by `ISSStyleSheetTokenizer` to construct the actual result objects (rulesets, property declarations etc) from the tokens found in a stylesheet.
+ */
+@protocol ISSStyleSheetTokenizerDelegate <NSObject>
+
+- (void) defineVariableWithName:(NSString*)name value:(NSString*)value;
+
+- (id) propertyDeclarationWithName:(NSString*)name value:(NSString*)value;
+
+- (id) rulesetWithSelectorChains:(NSMutableArray*)selectorChains properties:(nullable NSMutableArray*)properties;
+
+- (id) declarationExtensionWithSelectorChain:(nullable id)selectorChain;
+
+- (id) badDataWithDescription:(NSString*)badDataDescription;
+
+@end
+
+
+/**
+ * Hand-written, single pass, recursive descent stylesheet parser front end. Parses the structure of a stylesheet (variables, rulesets, selectors, property pairs etc)
+ * directly from a character buffer, and produces the same result as the parser combinator based stylesheet grammar of `ISSDefaultStyleSheetParser`.
+ * Note: property values are not parsed/transformed by this class.
+ */
+@interface ISSStyleSheetTokenizer : NSObject
+
+- (instancetype) initWithDelegate:(id<ISSStyleSheetTokenizerDelegate>)delegate;
+
+/**
+ * Parses the specified stylesheet data into an array of top level result objects (i.e. rulesets and bad data), created by the delegate.
+ */
+- (NSMutableArray*) parse:(NSString*)styleSheetData;
+
+/**
+ * Splits the specified stylesheet data at top level ruleset boundaries (i.e. after closing braces at nesting level zero, outside of comments and quoted strings)
+ * into chunks of at least `chunkLength` characters (except for the last chunk), which can be parsed independently of each other. Any top level variable
+ * definitions found in the stylesheet are added to `variableDefinitions`, in order, as arrays containing the variable name and the complete definition statement.
+ */
++ (NSArray*) splitStyleSheet:(NSString*)styleSheetData intoChunksOfLength:(NSUInteger)chunkLength variableDefinitions:(nullable NSMutableArray*)variableDefinitions;
+
+/**
+ * Same as `splitStyleSheet:intoChunksOfLength:variableDefinitions:`, but additionally adds all variable usages (i.e. definitions and references) found in the
+ * stylesheet to `variableUsages`, in order, as arrays containing the variable name and a boolean `NSNumber` indicating if the usage is a definition. References
+ * in the value of a variable definition are added before the definition itself.
+ */
++ (NSArray*) splitStyleSheet:(NSString*)styleSheetData intoChunksOfLength:(NSUInteger)chunkLength variableDefinitions:(nullable NSMutableArray*)variableDefinitions
+              variableUsages:(nullable NSMutableArray*)variableUsages;
+
+@end
+
+
+NS_ASSUME_NONNULL_END
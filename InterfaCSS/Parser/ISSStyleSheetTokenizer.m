@@ -0,0 +1,807 @@
+//
+//  ISSStyleSheetTokenizer.m
+//  Part of InterfaCSS - http://www.github.com/tolo/InterfaCSS
+//
+//  Copyright (c) Tobias Löfstrand, Leafnode AB.
+//  License: MIT (http://www.github.com/tolo/InterfaCSS/LICENSE)
+//
+
+#import "ISSStyleSheetTokenizer.h"
+
+#import "ISSParser.h"
+#import "ISSParser+CSS.h"
+#import "ISSSelector.h"
+#import "ISSSelectorChain.h"
+#import "ISSPseudoClass.h"
+#import "NSObject+ISSLogSupport.h"
+#import "NSString+ISSStringAdditions.h"
+
+
+/* Character classes (ASCII lookup tables, with fallback to NSCharacterSet for other characters) */
+
+static BOOL whitespaceChars[128];
+static BOOL newlineChars[128];
+static BOOL initialIdentifierChars[128];
+static BOOL identifierChars[128];
+static BOOL digitChars[128];
+static BOOL anyNameTerminatorChars[128];
+
+static NSCharacterSet* whitespaceSet;
+static NSCharacterSet* newlineSet;
+static NSCharacterSet* initialIdentifierSet;
+static NSCharacterSet* identifierSet;
+static NSCharacterSet* digitSet;
+static NSCharacterSet* anyNameTerminatorSet;
+
+static void fillCharacterTable(BOOL* table, NSCharacterSet* characterSet) {
+    for(unichar c = 0; c < 128; c++) {
+        table[c] = [characterSet characterIsMember:c];
+    }
+}
+
+static inline BOOL isCharacterMember(unichar c, const BOOL* table, NSCharacterSet* characterSet) {
+    return c < 128 ? table[c] : [characterSet characterIsMember:c];
+}
+
+#define ISSIsWhitespace(c) isCharacterMember(c, whitespaceChars, whitespaceSet)
+#define ISSIsNewline(c) isCharacterMember(c, newlineChars, newlineSet)
+#define ISSIsInitialIdentifierChar(c) isCharacterMember(c, initialIdentifierChars, initialIdentifierSet)
+#define ISSIsIdentifierChar(c) isCharacterMember(c, identifierChars, identifierSet)
+#define ISSIsDigit(c) isCharacterMember(c, digitChars, digitSet)
+#define ISSIsAnyNameTerminator(c) isCharacterMember(c, anyNameTerminatorChars, anyNameTerminatorSet)
+
+#define ISSCharAt(i) ((i) < _length ? _chars[(i)] : 0)
+#define ISSSkipSpaces(i) while( (i) < _length && ISSIsWhitespace(_chars[(i)]) ) (i)++;
+
+
+static NSArray* nonNullElementArray(NSArray* array) {
+    if( [array indexOfObject:[NSNull null]] != NSNotFound ) {
+        NSMutableArray* cleanArray = [NSMutableArray array];
+        for(id entry in array) {
+            if( entry != [NSNull null] ) [cleanArray addObject:entry];
+        }
+        return cleanArray;
+    }
+    return array;
+}
+
+
+/*
+ * Note: all parse methods below follow the same conventions as ISSParser, i.e. the status is only updated if there is a match, and the returned value is
+ * [NSNull null] if there is no match.
+ */
+@implementation ISSStyleSheetTokenizer {
+    __weak id<ISSStyleSheetTokenizerDelegate> _delegate;
+
+    NSString* _input;
+    const unichar* _chars;
+    NSUInteger _length;
+
+    ISSParser* _quotedStringParser;
+}
+
++ (void) initialize {
+    if( self == ISSStyleSheetTokenizer.class ) {
+        whitespaceSet = [NSCharacterSet whitespaceAndNewlineCharacterSet];
+        newlineSet = [NSCharacterSet newlineCharacterSet];
+        initialIdentifierSet = [ISSParser iss_validInitialIdentifierCharacterCharsSet];
+        identifierSet = [ISSParser iss_validIdentifierCharsSet];
+        digitSet = [NSCharacterSet decimalDigitCharacterSet];
+        NSMutableCharacterSet* _anyNameTerminatorSet = [NSMutableCharacterSet characterSetWithCharactersInString:@",:;{}()"];
+        [_anyNameTerminatorSet formUnionWithCharacterSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]];
+        anyNameTerminatorSet = [_anyNameTerminatorSet copy];
+
+        fillCharacterTable(whitespaceChars, whitespaceSet);
+        fillCharacterTable(newlineChars, newlineSet);
+        fillCharacterTable(initialIdentifierChars, initialIdentifierSet);
+        fillCharacterTable(identifierChars, identifierSet);
+        fillCharacterTable(digitChars, digitSet);
+        fillCharacterTable(anyNameTerminatorChars, anyNameTerminatorSet);
+    }
+}
+
+- (instancetype) initWithDelegate:(id<ISSStyleSheetTokenizerDelegate>)delegate {
+    if( self = [super init] ) {
+        _delegate = delegate;
+
+        // Quoted strings (with escapes) are rare in selectors (only used in pseudo class parameters), so the ISSParser implementation is used for these
+        ISSParser* singleQuote = [ISSParser unichar:'\''];
+        ISSParser* singleQuotedString = [[[singleQuote keepRight:[ISSParser stringWithEscapesUpToUnichar:'\'']] keepLeft:singleQuote] transform:^id(id value) {
+            return [NSString stringWithFormat:@"\'%@\'", value];
+        } name:@"singleQuotedString"];
+        ISSParser* doubleQuote = [ISSParser unichar:'\"'];
+        ISSParser* doubleQuotedString = [[[doubleQuote keepRight:[ISSParser stringWithEscapesUpToUnichar:'\"']] keepLeft:doubleQuote] transform:^id(id value) {
+            return [NSString stringWithFormat:@"\"%@\"", value];
+        } name:@"doubleQuotedString"];
+        _quotedStringParser = [ISSParser choice:@[singleQuotedString, doubleQuotedString]];
+    }
+    return self;
+}
+
+
+#pragma mark - Common tokens
+
+- (NSString*) substringFrom:(NSUInteger)location to:(NSUInteger)end {
+    return [_input substringWithRange:NSMakeRange(location, end - location)];
+}
+
+- (NSString*) identifierAtIndex:(NSUInteger*)index {
+    NSUInteger i = *index;
+    if( i < _length && ISSIsInitialIdentifierChar(_chars[i]) ) {
+        i++;
+        while( i < _length && ISSIsIdentifierChar(_chars[i]) ) i++;
+        NSString* identifier = [self substringFrom:*index to:i];
+        *index = i;
+        return identifier;
+    }
+    return nil;
+}
+
+- (NSString*) plainNumberAtIndex:(NSUInteger*)index {
+    NSUInteger i = *index;
+    while( i < _length && ISSIsDigit(_chars[i]) ) i++;
+    if( i == *index ) return nil;
+
+    // Optional fraction
+    if( ISSCharAt(i) == '.' && (i+1) < _length && ISSIsDigit(_chars[i+1]) ) {
+        i++;
+        while( i < _length && ISSIsDigit(_chars[i]) ) i++;
+    }
+
+    NSString* number = [self substringFrom:*index to:i];
+    *index = i;
+    return number;
+}
+
+- (BOOL) matchChar:(unichar)c skipSpaces:(BOOL)skipSpaces atIndex:(NSUInteger*)index {
+    NSUInteger i = *index;
+    if( skipSpaces ) ISSSkipSpaces(i);
+    if( ISSCharAt(i) == c ) {
+        i++;
+        if( skipSpaces ) ISSSkipSpaces(i);
+        *index = i;
+        return YES;
+    }
+    return NO;
+}
+
+- (BOOL) matchStringIgnoringCase:(const char*)lowercaseString atIndex:(NSUInteger*)index {
+    NSUInteger i = *index;
+    for(; *lowercaseString; lowercaseString++, i++) {
+        unichar c = ISSCharAt(i);
+        if( c < 128 ) c = (unichar)tolower(c);
+        if( c != *lowercaseString ) return NO;
+    }
+    *index = i;
+    return YES;
+}
+
+- (NSString*) takeUntilBraceAtIndex:(NSUInteger*)index {
+    NSUInteger i = *index;
+    while( i < _length && _chars[i] != '{' && _chars[i] != '}' ) i++;
+    if( i == *index ) return nil;
+    NSString* value = [self substringFrom:*index to:i];
+    *index = i;
+    return value;
+}
+
+/**
+ * Equivalent of `+[ISSParser iss_parseEscapedAndParameterizedStringUpToChar:orChar:inString:index:]`.
+ */
+- (NSString*) escapedAndParameterizedStringUpToChar:(unichar)char1 orChar:(unichar)char2 index:(NSUInteger*)index {
+    NSUInteger i = *index;
+
+    BOOL backslashEscape = NO;
+    BOOL inSingleQuote = NO;
+    BOOL inQuote = NO;
+    NSInteger parameterListNesting = 0;
+    NSInteger indexAfterLastNonWhitespaceChar = -1;
+
+    for(; i < _length; i++) {
+        unichar c = _chars[i];
+        BOOL inAnyQuote = inSingleQuote || inQuote;
+        BOOL isWhiteSpace = NO;
+
+        if( c == '\\' ) {
+            backslashEscape = !backslashEscape;
+            continue;
+        }
+
+        // Check if unescaped end char is reached:
+        if( (c == char1 || c == char2) && !inAnyQuote && parameterListNesting == 0 && indexAfterLastNonWhitespaceChar > -1 ) {
+            NSString* value = [self substringFrom:*index to:(NSUInteger)indexAfterLastNonWhitespaceChar];
+            *index = i + 1;
+            return value;
+        }
+        // Invalid chars:
+        else if( (c == '{' || c == '}') && !inAnyQuote ) {
+            break;
+        }
+        // Check for quites and parameter lists:
+        else if( c == '(' && !inAnyQuote ) {
+            parameterListNesting++;
+        }
+        else if( c == ')' && !inAnyQuote ) {
+            parameterListNesting--;
+        }
+        else if( c == '\'' && !inQuote && !backslashEscape ) {
+            inSingleQuote = !inSingleQuote;
+        }
+        else if( c == '\"' && !inSingleQuote && !backslashEscape ) {
+            inQuote = !inQuote;
+        }
+        else if( ISSIsWhitespace(c) ) {
+            isWhiteSpace = YES;
+        }
+
+        if( !isWhiteSpace ) {
+            indexAfterLastNonWhitespaceChar = i + 1;
+        }
+
+        backslashEscape = NO;
+    }
+
+    return nil;
+}
+
+
+#pragma mark - Comments, variables and unrecognized content
+
+- (id) parseComment:(ISSParserStatus*)status {
+    NSUInteger i = status->index;
+    ISSSkipSpaces(i);
+
+    if( ISSCharAt(i) == '/' ) {
+        i++;
+        unichar c = ISSCharAt(i);
+        BOOL singleLineComment = c == '/';
+        if( c == '*' || singleLineComment ) {
+            i++;
+            BOOL commentMatch = NO;
+            if( singleLineComment ) {
+                while( i < _length && !ISSIsNewline(_chars[i]) ) i++;
+                commentMatch = i < _length; // Comment must be terminated by newline
+            } else {
+                BOOL starFound = NO;
+                for(; i < _length; i++) {
+                    c = _chars[i];
+                    if( c == '*' ) {
+                        starFound = YES;
+                    } else if( starFound && c == '/' ) {
+                        commentMatch = YES;
+                        i++;
+                        break;
+                    } else {
+                        starFound = NO;
+                    }
+                }
+            }
+
+            if( commentMatch ) {
+                *status = (ISSParserStatus){.match = YES, .index = i};
+            }
+        }
+    }
+
+    return [NSNull null];
+}
+
+- (id) parseVariable:(ISSParserStatus*)status {
+    NSUInteger i = status->index;
+    ISSSkipSpaces(i);
+
+    if( ISSCharAt(i) != '@' ) return [NSNull null];
+    i++;
+
+    NSString* name = [self identifierAtIndex:&i];
+    if( !name ) return [NSNull null];
+    ISSSkipSpaces(i);
+
+    unichar c = ISSCharAt(i);
+    if( c != ':' && c != '=' ) return [NSNull null];
+    i++;
+    ISSSkipSpaces(i);
+
+    NSString* value = [self escapedAndParameterizedStringUpToChar:';' orChar:0 index:&i];
+    if( value ) {
+        *status = (ISSParserStatus){.match = YES, .index = i + 1};
+        [_delegate defineVariableWithName:name value:value];
+    }
+    return [NSNull null];
+}
+
+- (id) parseUnrecognizedLine:(ISSParserStatus*)status badDataFormat:(NSString*)badDataFormat {
+    NSUInteger i = status->index;
+    ISSSkipSpaces(i);
+
+    NSUInteger location = i;
+    while( location < _length && _chars[location] != '\r' && _chars[location] != '\n' && _chars[location] != '{' && _chars[location] != '}' ) location++;
+    if( location < _length && location != 0 ) {
+        i = location;
+        while( i < _length && (_chars[i] == '\r' || _chars[i] == '\n') ) i++;
+    }
+
+    if( i > status->index ) {
+        NSString* value = [self substringFrom:status->index to:i];
+        *status = (ISSParserStatus){.match = YES, .index = i};
+        if( [value iss_hasData] ) return [_delegate badDataWithDescription:[NSString stringWithFormat:badDataFormat, [value iss_trim]]];
+    }
+    return [NSNull null];
+}
+
+
+#pragma mark - Selectors
+
+- (id) parseStructuralPseudoClassParameters:(ISSParserStatus*)status {
+    // Format: "(an+b)", "(an)", "(even)" or "(odd)"
+    NSUInteger i = status->index;
+    if( ![self matchChar:'(' skipSpaces:NO atIndex:&i] ) return [NSNull null];
+    ISSSkipSpaces(i);
+    NSUInteger parameterIndex = i;
+
+    // an+b / an
+    unichar c = ISSCharAt(i);
+    NSString* aModifier = @"";
+    if( c == '+' || c == '-' ) {
+        aModifier = [NSString stringWithFormat:@"%C", c];
+        i++;
+    }
+    NSString* aValue = [self plainNumberAtIndex:&i] ?: @"1";
+    if( ISSCharAt(i) == 'n' ) {
+        i++;
+        ISSSkipSpaces(i);
+        NSInteger a = [[aModifier stringByAppendingString:aValue] integerValue];
+
+        NSUInteger anIndex = i;
+        c = ISSCharAt(i);
+        if( c == '+' || c == '-' ) {
+            NSString* bModifier = [NSString stringWithFormat:@"%C", c];
+            i++;
+            ISSSkipSpaces(i);
+            NSString* bValue = [self plainNumberAtIndex:&i];
+            if( bValue ) {
+                ISSSkipSpaces(i);
+                if( [self matchChar:')' skipSpaces:NO atIndex:&i] ) {
+                    *status = (ISSParserStatus){.match = YES, .index = i};
+                    return @[@(a), @([[bModifier stringByAppendingString:bValue] integerValue])];
+                }
+            }
+        }
+
+        i = anIndex;
+        if( [self matchChar:')' skipSpaces:NO atIndex:&i] ) {
+            *status = (ISSParserStatus){.match = YES, .index = i};
+            return @[@(a), @0];
+        }
+    }
+
+    // even / odd
+    i = parameterIndex;
+    BOOL even = [self matchStringIgnoringCase:"even" atIndex:&i];
+    if( even || [self matchStringIgnoringCase:"odd" atIndex:&i] ) {
+        ISSSkipSpaces(i);
+        if( [self matchChar:')' skipSpaces:NO atIndex:&i] ) {
+            *status = (ISSParserStatus){.match = YES, .index = i};
+            return even ? @[@2, @0] : @[@2, @1];
+        }
+    }
+
+    return [NSNull null];
+}
+
+- (id) parsePseudoClassParameter:(ISSParserStatus*)status {
+    NSUInteger i = status->index;
+    if( ![self matchChar:'(' skipSpaces:NO atIndex:&i] ) return [NSNull null];
+    ISSSkipSpaces(i);
+
+    ISSParserStatus quotedStringStatus = {.match = NO, .index = i};
+    NSString* parameter = [_quotedStringParser parse:_input status:&quotedStringStatus];
+    if( quotedStringStatus.match ) {
+        i = quotedStringStatus.index;
+    } else {
+        NSUInteger nameIndex = i;
+        while( i < _length && !ISSIsAnyNameTerminator(_chars[i]) ) i++;
+        if( i == nameIndex ) return [NSNull null];
+        parameter = [self substringFrom:nameIndex to:i];
+    }
+
+    ISSSkipSpaces(i);
+    if( ![self matchChar:')' skipSpaces:NO atIndex:&i] ) return [NSNull null];
+
+    *status = (ISSParserStatus){.match = YES, .index = i};
+    return [parameter iss_trimQuotes];
+}
+
+- (id) parsePseudoClass:(ISSParserStatus*)status {
+    NSUInteger i = status->index;
+    if( ![self matchChar:':' skipSpaces:NO atIndex:&i] ) return [NSNull null];
+    NSString* pseudoClassName = [self identifierAtIndex:&i];
+    if( !pseudoClassName ) return [NSNull null];
+
+    // Parameterized pseudo class
+    ISSParserStatus parameterStatus = {.match = NO, .index = i};
+    id pseudoClassParameters = [self parseStructuralPseudoClassParameters:&parameterStatus];
+    if( !parameterStatus.match ) pseudoClassParameters = [self parsePseudoClassParameter:&parameterStatus];
+
+    if( parameterStatus.match ) {
+        *status = parameterStatus;
+        @try {
+            ISSPseudoClassType pseudoClassType = [ISSPseudoClass pseudoClassTypeFromString:pseudoClassName];
+
+            if( [pseudoClassParameters isKindOfClass:NSArray.class] ) {
+                NSArray* p = pseudoClassParameters;
+                return [ISSPseudoClass structuralPseudoClassWithA:[p[0] integerValue] b:[p[1] integerValue] type:pseudoClassType];
+            } else {
+                return [ISSPseudoClass pseudoClassWithType:pseudoClassType andParameter:pseudoClassParameters];
+            }
+        } @catch (NSException* e) {
+            ISSLogWarning(@"Invalid pseudo class: %@", pseudoClassName);
+            return [NSNull null];
+        }
+    }
+    // Simple pseudo class
+    else {
+        *status = (ISSParserStatus){.match = YES, .index = i};
+        @try {
+            return [ISSPseudoClass pseudoClassWithTypeString:pseudoClassName];
+        } @catch (NSException* e) {
+            ISSLogWarning(@"Invalid pseudo class: %@", pseudoClassName);
+            return [NSNull null];
+        }
+    }
+}
+
+- (id) parseSimpleSelector:(ISSParserStatus*)status {
+    // Format: [type][#id][.class1.class2...][:pseudo1:pseudo2...], where at least one of type, id or class must be present
+    NSUInteger i = status->index;
+
+    NSString* type = [self identifierAtIndex:&i];
+    if( !type && ISSCharAt(i) == '*' ) {
+        type = @"*";
+        i++;
+    }
+
+    NSString* elementId = nil;
+    NSUInteger idIndex = i;
+    if( [self matchChar:'#' skipSpaces:NO atIndex:&idIndex] && (elementId = [self identifierAtIndex:&idIndex]) ) {
+        i = idIndex;
+    }
+
+    NSMutableArray* styleClasses = nil;
+    NSUInteger classIndex = i;
+    NSString* styleClass;
+    while( [self matchChar:'.' skipSpaces:NO atIndex:&classIndex] && (styleClass = [self identifierAtIndex:&classIndex]) ) {
+        if( !styleClasses ) styleClasses = [NSMutableArray array];
+        [styleClasses addObject:styleClass];
+        i = classIndex;
+    }
+
+    if( !type && !elementId && !styleClasses ) return [NSNull null];
+
+    NSMutableArray* pseudoClasses = [NSMutableArray array];
+    ISSParserStatus pseudoClassStatus = {.match = NO, .index = i};
+    do {
+        pseudoClassStatus.match = NO;
+        id pseudoClass = [self parsePseudoClass:&pseudoClassStatus];
+        if( pseudoClassStatus.match ) [pseudoClasses addObject:pseudoClass];
+    } while( pseudoClassStatus.match && pseudoClassStatus.index < _length );
+
+    *status = (ISSParserStatus){.match = YES, .index = pseudoClassStatus.index};
+    ISSSelector* selector = [ISSSelector selectorWithType:type elementId:elementId styleClasses:styleClasses pseudoClasses:nonNullElementArray(pseudoClasses)];
+    return selector ?: [NSNull null];
+}
+
+- (id) parseSelectorCombinator:(ISSParserStatus*)status {
+    NSUInteger i = status->index;
+    if( [self matchChar:'~' skipSpaces:YES atIndex:&i] ) {
+        *status = (ISSParserStatus){.match = YES, .index = i};
+        return @(ISSSelectorCombinatorGeneralSibling);
+    } else if( [self matchChar:'+' skipSpaces:YES atIndex:&i] ) {
+        *status = (ISSParserStatus){.match = YES, .index = i};
+        return @(ISSSelectorCombinatorAdjacentSibling);
+    } else if( [self matchChar:'>' skipSpaces:YES atIndex:&i] ) {
+        *status = (ISSParserStatus){.match = YES, .index = i};
+        return @(ISSSelectorCombinatorChild);
+    } else if( i < _length && ISSIsWhitespace(_chars[i]) ) {
+        ISSSkipSpaces(i);
+        *status = (ISSParserStatus){.match = YES, .index = i};
+        return @(ISSSelectorCombinatorDescendant);
+    }
+    return [NSNull null];
+}
+
+- (id) parseSelectorChain:(ISSParserStatus*)status {
+    // Simple selectors separated by combinators (same semantics as ISSParser sepBy1Keep)
+    NSUInteger i = status->index;
+    NSUInteger lastValidIndex = i;
+    BOOL parsingCombinator = NO;
+    NSMutableArray* components = [NSMutableArray array];
+    id lastCombinator = nil;
+
+    while( i < _length ) {
+        ISSParserStatus componentStatus = {.match = NO, .index = i};
+        if( parsingCombinator ) {
+            lastCombinator = [self parseSelectorCombinator:&componentStatus];
+            if( !componentStatus.match ) break;
+        } else {
+            id selector = [self parseSimpleSelector:&componentStatus];
+            if( !componentStatus.match ) break;
+            lastValidIndex = componentStatus.index;
+            if( lastCombinator ) [components addObject:lastCombinator];
+            [components addObject:selector];
+        }
+        parsingCombinator = !parsingCombinator;
+        i = componentStatus.index;
+    }
+
+    if( components.count == 0 ) return [NSNull null];
+
+    *status = (ISSParserStatus){.match = YES, .index = lastValidIndex};
+    id selectorChain = [ISSSelectorChain selectorChainWithComponents:components];
+    if( !selectorChain ) {
+        return [_delegate badDataWithDescription:[NSString stringWithFormat:@"Invalid selector chain: %@", [components componentsJoinedByString:@" "]]];
+    }
+    return selectorChain;
+}
+
+- (NSMutableArray*) parseSelectorChains:(ISSParserStatus*)status {
+    // Selector chains (with surrounding spaces) separated by comma (same semantics as ISSParser sepBy1)
+    NSUInteger i = status->index;
+    NSUInteger lastValidIndex = i;
+    BOOL parsingDelimiter = NO;
+    NSMutableArray* selectorChains = [NSMutableArray array];
+
+    while( i < _length ) {
+        if( parsingDelimiter ) {
+            if( _chars[i] != ',' ) break;
+            i++;
+        } else {
+            NSUInteger chainIndex = i;
+            ISSSkipSpaces(chainIndex);
+            ISSParserStatus chainStatus = {.match = NO, .index = chainIndex};
+            id selectorChain = [self parseSelectorChain:&chainStatus];
+            if( !chainStatus.match ) break;
+            i = chainStatus.index;
+            ISSSkipSpaces(i);
+            lastValidIndex = i;
+            [selectorChains addObject:selectorChain];
+        }
+        parsingDelimiter = !parsingDelimiter;
+    }
+
+    if( selectorChains.count == 0 ) return nil;
+
+    *status = (ISSParserStatus){.match = YES, .index = lastValidIndex};
+    return selectorChains;
+}
+
+
+#pragma mark - Rulesets and property declarations
+
+- (id) parseRuleset:(ISSParserStatus*)status {
+    ISSParserStatus rulesetStatus = {.match = NO, .index = status->index};
+    NSMutableArray* selectorChains = [self parseSelectorChains:&rulesetStatus];
+    if( !rulesetStatus.match ) return [NSNull null];
+
+    NSUInteger i = rulesetStatus.index;
+    if( ![self matchChar:'{' skipSpaces:YES atIndex:&i] ) return [NSNull null];
+
+    rulesetStatus = (ISSParserStatus){.match = NO, .index = i};
+    NSMutableArray* properties = [self parseRulesetContent:&rulesetStatus];
+
+    i = rulesetStatus.index;
+    if( ![self matchChar:'}' skipSpaces:YES atIndex:&i] ) return [NSNull null];
+
+    *status = (ISSParserStatus){.match = YES, .index = i};
+    return [_delegate rulesetWithSelectorChains:selectorChains properties:properties];
+}
+
+- (id) parsePropertyPair:(ISSParserStatus*)status {
+    NSUInteger i = status->index;
+    ISSSkipSpaces(i);
+
+    if( !ISSIsInitialIdentifierChar(ISSCharAt(i)) ) return [NSNull null]; // Make sure name starts with valid initial idenfifier char
+
+    NSString* name = [self escapedAndParameterizedStringUpToChar:':' orChar:'=' index:&i];
+    if( name.length > 0 ) {
+        ISSSkipSpaces(i);
+        NSString* value = [self escapedAndParameterizedStringUpToChar:';' orChar:0 index:&i];
+        if( value ) {
+            *status = (ISSParserStatus){.match = YES, .index = i + 1};
+            return [_delegate propertyDeclarationWithName:name value:value];
+        }
+    }
+    return [NSNull null];
+}
+
+- (id) parseDeclarationExtension:(ISSParserStatus*)status {
+    // Format: "@extend[s][:] selectorChain;"
+    NSUInteger i = status->index;
+    if( ![self matchStringIgnoringCase:"@extend" atIndex:&i] ) return [NSNull null];
+    if( ISSCharAt(i) == 's' ) i++;
+
+    NSUInteger colonIndex = i;
+    ISSSkipSpaces(colonIndex);
+    if( ISSCharAt(colonIndex) == ':' ) i = colonIndex + 1;
+    ISSSkipSpaces(i);
+
+    ISSParserStatus chainStatus = {.match = NO, .index = i};
+    id selectorChain = [self parseSelectorChain:&chainStatus];
+    if( !chainStatus.match ) return [NSNull null];
+
+    i = chainStatus.index;
+    if( ![self matchChar:';' skipSpaces:YES atIndex:&i] ) return [NSNull null];
+
+    *status = (ISSParserStatus){.match = YES, .index = i};
+    return [_delegate declarationExtensionWithSelectorChain:selectorChain];
+}
+
+- (id) parseUnsupportedNestedRuleset:(ISSParserStatus*)status {
+    NSUInteger i = status->index;
+    NSString* prefix = [self takeUntilBraceAtIndex:&i];
+    if( !prefix ) return [NSNull null];
+    if( ![self matchChar:'{' skipSpaces:YES atIndex:&i] ) return [NSNull null];
+    NSString* content = [self takeUntilBraceAtIndex:&i];
+    if( !content ) return [NSNull null];
+    if( ![self matchChar:'}' skipSpaces:YES atIndex:&i] ) return [NSNull null];
+
+    *status = (ISSParserStatus){.match = YES, .index = i};
+    return [_delegate badDataWithDescription:[NSString stringWithFormat:@"Unsupported nested ruleset: '%@'", [@[prefix, content] mutableCopy]]];
+}
+
+- (NSMutableArray*) parseRulesetContent:(ISSParserStatus*)status {
+    NSMutableArray* values = [NSMutableArray array];
+    do {
+        status->match = NO;
+        id value = [self parseComment:status];
+        if( !status->match ) value = [self parsePropertyPair:status];
+        if( !status->match ) value = [self parseRuleset:status];
+        if( !status->match ) value = [self parseDeclarationExtension:status];
+        if( !status->match ) value = [self parseUnsupportedNestedRuleset:status];
+        if( !status->match ) value = [self parseUnrecognizedLine:status badDataFormat:@"Unrecognized property line: '%@'"];
+
+        if( status->match && value != [NSNull null] ) [values addObject:value];
+    } while( status->match && status->index < _length );
+
+    status->match = YES;
+    return values;
+}
+
+
+#pragma mark - Public interface
+
+- (NSMutableArray*) parse:(NSString*)styleSheetData {
+    _input = styleSheetData;
+    _length = styleSheetData.length;
+    _chars = CFStringGetCharactersPtr((__bridge CFStringRef)styleSheetData);
+    unichar* buffer = NULL;
+    if( !_chars ) {
+        buffer = malloc(sizeof(unichar) * MAX(_length, 1));
+        [styleSheetData getCharacters:buffer range:NSMakeRange(0, _length)];
+        _chars = buffer;
+    }
+
+    NSMutableArray* values = [NSMutableArray array];
+    ISSParserStatus status = {.match = NO, .index = 0};
+    do {
+        status.match = NO;
+        id value = [self parseComment:&status];
+        if( !status.match ) value = [self parseVariable:&status];
+        if( !status.match ) value = [self parseRuleset:&status];
+        if( !status.match ) value = [self parseUnrecognizedLine:&status badDataFormat:@"Unrecognized content: '%@'"];
+
+        if( status.match && value != [NSNull null] ) [values addObject:value];
+    } while( status.match && status.index < _length );
+
+    free(buffer);
+    _chars = NULL;
+    _length = 0;
+    _input = nil;
+
+    return values;
+}
+
++ (NSArray*) splitStyleSheet:(NSString*)styleSheetData intoChunksOfLength:(NSUInteger)chunkLength variableDefinitions:(NSMutableArray*)variableDefinitions {
+    return [self splitStyleSheet:styleSheetData intoChunksOfLength:chunkLength variableDefinitions:variableDefinitions variableUsages:nil];
+}
+
++ (NSArray*) splitStyleSheet:(NSString*)styleSheetData intoChunksOfLength:(NSUInteger)chunkLength variableDefinitions:(NSMutableArray*)variableDefinitions
+              variableUsages:(NSMutableArray*)variableUsages {
+    NSUInteger _length = styleSheetData.length;
+    const unichar* _chars = CFStringGetCharactersPtr((__bridge CFStringRef)styleSheetData);
+    unichar* buffer = NULL;
+    if( !_chars ) {
+        buffer = malloc(sizeof(unichar) * MAX(_length, 1));
+        [styleSheetData getCharacters:buffer range:NSMakeRange(0, _length)];
+        _chars = buffer;
+    }
+
+    NSMutableArray* chunks = [NSMutableArray array];
+    NSUInteger chunkStart = 0;
+    NSUInteger nesting = 0;
+    BOOL statementStart = YES; // Only whitespace and comments since the start of the current statement (variable, ruleset or property declaration)
+    for(NSUInteger i = 0; i < _length; i++) {
+        unichar c = _chars[i];
+        if( c == '/' && ISSCharAt(i + 1) == '*' ) { // Multi line comment
+            i += 2;
+            while( i < _length && !(_chars[i] == '*' && ISSCharAt(i + 1) == '/') ) i++;
+            i++;
+        } else if( c == '/' && ISSCharAt(i + 1) == '/' && statementStart ) { // Single line comment (only at the start of a statement, like in the tokenizer)
+            while( i < _length && !ISSIsNewline(_chars[i]) ) i++;
+        } else if( c == '\'' || c == '"' ) { // Quoted string
+            NSUInteger stringStart = i;
+            for(i++; i < _length && _chars[i] != c; i++) {
+                if( _chars[i] == '\\' ) i++;
+            }
+            if( variableUsages ) [self addVariableReferencesInRange:NSMakeRange(stringStart, MIN(i, _length) - stringStart) chars:_chars toUsages:variableUsages styleSheetData:styleSheetData]; // Conservatively treat variable-like text in strings as references
+            statementStart = NO;
+        } else if( c == '{' ) {
+            nesting++;
+            statementStart = YES;
+        } else if( c == '}' ) {
+            if( nesting > 0 ) nesting--;
+            statementStart = YES;
+            if( nesting == 0 && (i + 1 - chunkStart) >= chunkLength ) {
+                [chunks addObject:[styleSheetData substringWithRange:NSMakeRange(chunkStart, i + 1 - chunkStart)]];
+                chunkStart = i + 1;
+            }
+        } else if( c == ';' ) {
+            statementStart = YES;
+        } else if( c == '@' && nesting == 0 && statementStart ) { // Possible variable definition
+            NSUInteger location = i + 1;
+            while( location < _length && ISSIsIdentifierChar(_chars[location]) ) location++;
+            NSString* name = location > (i + 1) ? [styleSheetData substringWithRange:NSMakeRange(i + 1, location - (i + 1))] : nil;
+            ISSSkipSpaces(location);
+            if( name && (ISSCharAt(location) == ':' || ISSCharAt(location) == '=') ) {
+                unichar quote = 0;
+                for(; location < _length && (quote || _chars[location] != ';'); location++) {
+                    if( quote && _chars[location] == '\\' ) location++;
+                    else if( quote && _chars[location] == quote ) quote = 0;
+                    else if( !quote && (_chars[location] == '\'' || _chars[location] == '"') ) quote = _chars[location];
+                }
+                if( location < _length ) {
+                    [variableDefinitions addObject:@[name, [styleSheetData substringWithRange:NSMakeRange(i, location + 1 - i)]]];
+                    if( variableUsages ) {
+                        [self addVariableReferencesInRange:NSMakeRange(i + 1 + name.length, location - (i + 1 + name.length)) chars:_chars toUsages:variableUsages styleSheetData:styleSheetData];
+                        [variableUsages addObject:@[name, @YES]];
+                    }
+                    i = location;
+                    continue;
+                }
+            }
+            if( name ) [variableUsages addObject:@[name, @NO]];
+            statementStart = NO;
+        } else if( c == '@' && variableUsages ) { // Variable reference
+            NSUInteger location = i + 1;
+            while( location < _length && ISSIsIdentifierChar(_chars[location]) ) location++;
+            if( location > (i + 1) ) {
+                [variableUsages addObject:@[[styleSheetData substringWithRange:NSMakeRange(i + 1, location - (i + 1))], @NO]];
+                i = location - 1;
+            }
+            statementStart = NO;
+        } else if( !ISSIsWhitespace(c) ) {
+            statementStart = NO;
+        }
+    }
+    if( chunkStart < _length ) {
+        [chunks addObject:chunkStart == 0 ? styleSheetData : [styleSheetData substringFromIndex:chunkStart]];
+    }
+
+    free(buffer);
+    return chunks;
+}
+
++ (void) addVariableReferencesInRange:(NSRange)range chars:(const unichar*)_chars toUsages:(NSMutableArray*)variableUsages styleSheetData:(NSString*)styleSheetData {
+    NSUInteger end = NSMaxRange(range);
+    for(NSUInteger i = range.location; i < end; i++) {
+        if( _chars[i] != '@' ) continue;
+        NSUInteger location = i + 1;
+        while( location < end && ISSIsIdentifierChar(_chars[location]) ) location++;
+        if( location > (i + 1) ) {
+            [variableUsages addObject:@[[styleSheetData substringWithRange:NSMakeRange(i + 1, location - (i + 1))], @NO]];
+            i = location - 1;
+        }
+    }
+}
+
+@end
@@ -0,0 +1,54 @@
+//
+//  ISSTransformedValueCache.h
+//  Part of InterfaCSS - http://www.github.com/tolo/InterfaCSS
+//
+//  Copyright (c) Tobias Löfstrand, Leafnode AB.
+//  License: MIT (http://www.github.com/tolo/InterfaCSS/LICENSE)
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+@class ISSPropertyDefinition;
+
+
+/**
+ * Default maximum number of values held by an `ISSTransformedValueCache`.
+ */
+extern const NSUInteger ISSTransformedValueCacheDefaultCapacity;
+
+
+/**
+ * Thread safe, size bounded cache of transformed property values, keyed by property type (or property, for enums) and raw property value.
+ *
+ * The cache is divided into a number of shards (selected by the hash of the raw value), each protected by its own lock and evicting its least recently used
+ * values once it has reached its share of the total capacity.
+ */
+@interface ISSTransformedValueCache : NSObject
+
+@property (nonatomic, readonly) NSUInteger capacity;
+
+/** The number of values currently in the cache. */
+@property (nonatomic, readonly) NSUInteger count;
+/** The number of lookups that found a cached value. */
+@property (nonatomic, readonly) NSUInteger hitCount;
+/** The number of lookups that didn't find a cached value. */
+@property (nonatomic, readonly) NSUInteger missCount;
+/** The number of values evicted to keep the cache within its capacity. */
+@property (nonatomic, readonly) NSUInteger evictionCount;
+
+- (instancetype) init;
+- (instancetype) initWithCapacity:(NSUInteger)capacity;
+
+- (nullable id) transformedValueForRawValue:(NSString*)rawValue property:(ISSPropertyDefinition*)property;
+- (void) setTransformedValue:(id)transformedValue forRawValue:(NSString*)rawValue property:(ISSPropertyDefinition*)property;
+
+/** Removes all values from the cache (but doesn't reset the counters). */
+- (void) removeAllValues;
+
+@end
+
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,256 @@
+//
+//  ISSTransformedValueCache.m
+//  Part of InterfaCSS - http://www.github.com/tolo/InterfaCSS
+//
+//  Copyright (c) Tobias Löfstrand, Leafnode AB.
+//  License: MIT (http://www.github.com/tolo/InterfaCSS/LICENSE)
+//
+
+#import "ISSTransformedValueCache.h"
+
+#import <pthread.h>
+
+#import "ISSPropertyDefinition.h"
+
+
+const NSUInteger ISSTransformedValueCacheDefaultCapacity = 4096;
+
+static const NSUInteger ISSTransformedValueCacheShardCount = 8; // Must be a power of two
+
+
+#pragma mark - ISSTransformedValueCacheEntry
+
+@interface ISSTransformedValueCacheEntry : NSObject
+@property (nonatomic, strong) id typeKey;
+@property (nonatomic, strong) NSString* rawValue;
+@property (nonatomic, strong) id value;
+@property (nonatomic, strong) ISSTransformedValueCacheEntry* next; // Towards the least recently used entry
+@property (nonatomic, unsafe_unretained) ISSTransformedValueCacheEntry* previous; // Towards the most recently used entry
+@end
+
+@implementation ISSTransformedValueCacheEntry
+@end
+
+
+#pragma mark - ISSTransformedValueCacheShard
+
+/*
+ * A part of the cache, with its own lock and LRU list. Entries are stored in a two level dictionary (type key -> raw value -> entry), which avoids building
+ * composite keys for lookups.
+ */
+@interface ISSTransformedValueCacheShard : NSObject
+@property (nonatomic, readonly) NSUInteger count;
+@property (nonatomic, readonly) NSUInteger hitCount;
+@property (nonatomic, readonly) NSUInteger missCount;
+@property (nonatomic, readonly) NSUInteger evictionCount;
+@end
+
+@implementation ISSTransformedValueCacheShard {
+    pthread_mutex_t _lock;
+    NSUInteger _capacity;
+    NSMutableDictionary* _entriesForTypeKeys;
+    ISSTransformedValueCacheEntry* _mostRecentlyUsed;
+    ISSTransformedValueCacheEntry* _leastRecentlyUsed;
+}
+
+- (instancetype) initWithCapacity:(NSUInteger)capacity {
+    if( self = [super init] ) {
+        pthread_mutex_init(&_lock, NULL);
+        _capacity = MAX(capacity, (NSUInteger)1);
+        _entriesForTypeKeys = [[NSMutableDictionary alloc] init];
+    }
+    return self;
+}
+
+- (void) dealloc {
+    pthread_mutex_destroy(&_lock);
+}
+
+- (void) unlinkEntry:(ISSTransformedValueCacheEntry*)entry {
+    if( entry.previous ) entry.previous.next = entry.next;
+    else _mostRecentlyUsed = entry.next;
+    if( entry.next ) entry.next.previous = entry.previous;
+    else _leastRecentlyUsed = entry.previous;
+    entry.next = nil;
+    entry.previous = nil;
+}
+
+- (void) linkEntryAsMostRecentlyUsed:(ISSTransformedValueCacheEntry*)entry {
+    entry.next = _mostRecentlyUsed;
+    entry.previous = nil;
+    _mostRecentlyUsed.previous = entry;
+    _mostRecentlyUsed = entry;
+    if( !_leastRecentlyUsed ) _leastRecentlyUsed = entry;
+}
+
+- (id) valueForRawValue:(NSString*)rawValue typeKey:(id)typeKey {
+    id value = nil;
+    pthread_mutex_lock(&_lock);
+    ISSTransformedValueCacheEntry* entry = _entriesForTypeKeys[typeKey][rawValue];
+    if( entry ) {
+        _hitCount++;
+        value = entry.value;
+        if( entry != _mostRecentlyUsed ) {
+            [self unlinkEntry:entry];
+            [self linkEntryAsMostRecentlyUsed:entry];
+        }
+    } else {
+        _missCount++;
+    }
+    pthread_mutex_unlock(&_lock);
+    return value;
+}
+
+- (void) setValue:(id)value forRawValue:(NSString*)rawValue typeKey:(id)typeKey {
+    pthread_mutex_lock(&_lock);
+    NSMutableDictionary* entries = _entriesForTypeKeys[typeKey];
+    if( !entries ) {
+        entries = [[NSMutableDictionary alloc] init];
+        _entriesForTypeKeys[typeKey] = entries;
+    }
+
+    ISSTransformedValueCacheEntry* entry = entries[rawValue];
+    if( entry ) {
+        entry.value = value;
+        [self unlinkEntry:entry];
+    } else {
+        entry = [[ISSTransformedValueCacheEntry alloc] init];
+        entry.typeKey = typeKey;
+        entry.rawValue = [rawValue copy];
+        entry.value = value;
+        entries[entry.rawValue] = entry;
+        _count++;
+    }
+    [self linkEntryAsMostRecentlyUsed:entry];
+
+    // Evict least recently used entries
+    while( _count > _capacity ) {
+        ISSTransformedValueCacheEntry* evicted = _leastRecentlyUsed;
+        [self unlinkEntry:evicted];
+        NSMutableDictionary* evictedEntries = _entriesForTypeKeys[evicted.typeKey];
+        [evictedEntries removeObjectForKey:evicted.rawValue];
+        if( evictedEntries.count == 0 ) [_entriesForTypeKeys removeObjectForKey:evicted.typeKey];
+        _count--;
+        _evictionCount++;
+    }
+    pthread_mutex_unlock(&_lock);
+}
+
+- (void) removeAllValues {
+    pthread_mutex_lock(&_lock);
+    // Break the links between the entries iteratively, to avoid deep recursion when releasing a long list
+    ISSTransformedValueCacheEntry* entry = _mostRecentlyUsed;
+    while( entry ) {
+        ISSTransformedValueCacheEntry* next = entry.next;
+        entry.next = nil;
+        entry = next;
+    }
+    _mostRecentlyUsed = nil;
+    _leastRecentlyUsed = nil;
+    [_entriesForTypeKeys removeAllObjects];
+    _count = 0;
+    pthread_mutex_unlock(&_lock);
+}
+
+- (void) getCount:(NSUInteger*)count hitCount:(NSUInteger*)hitCount missCount:(NSUInteger*)missCount evictionCount:(NSUInteger*)evictionCount {
+    pthread_mutex_lock(&_lock);
+    *count += _count;
+    *hitCount += _hitCount;
+    *missCount += _missCount;
+    *evictionCount += _evictionCount;
+    pthread_mutex_unlock(&_lock);
+}
+
+@end
+
+
+#pragma mark - ISSTransformedValueCache
+
+@implementation ISSTransformedValueCache {
+    NSArray* _shards;
+}
+
+- (instancetype) init {
+    return [self initWithCapacity:ISSTransformedValueCacheDefaultCapacity];
+}
+
+- (instancetype) initWithCapacity:(NSUInteger)capacity {
+    if( self = [super init] ) {
+        _capacity = capacity;
+        NSUInteger shardCapacity = (capacity + ISSTransformedValueCacheShardCount - 1) / ISSTransformedValueCacheShardCount;
+        NSMutableArray* shards = [NSMutableArray arrayWithCapacity:ISSTransformedValueCacheShardCount];
+        for(NSUInteger i=0; i<ISSTransformedValueCacheShardCount; i++) {
+            [shards addObject:[[ISSTransformedValueCacheShard alloc] initWithCapacity:shardCapacity]];
+        }
+        _shards = [shards copy];
+    }
+    return self;
+}
+
+- (void) dealloc {
+    for(ISSTransformedValueCacheShard* shard in _shards) [shard removeAllValues];
+}
+
+/*
+ * Values of enum properties are specific to the property - all other values only depend on the property type.
+ */
+static id ISSTransformedValueCacheTypeKey(ISSPropertyDefinition* property) {
+    if( property.type == ISSPropertyTypeEnumType ) return property.name;
+    else return @(property.type);
+}
+
+- (ISSTransformedValueCacheShard*) shardForRawValue:(NSString*)rawValue {
+    return _shards[rawValue.hash & (ISSTransformedValueCacheShardCount - 1)];
+}
+
+- (id) transformedValueForRawValue:(NSString*)rawValue property:(ISSPropertyDefinition*)property {
+    return [[self shardForRawValue:rawValue] valueForRawValue:rawValue typeKey:ISSTransformedValueCacheTypeKey(property)];
+}
+
+- (void) setTransformedValue:(id)transformedValue forRawValue:(NSString*)rawValue property:(ISSPropertyDefinition*)property {
+    [[self shardForRawValue:rawValue] setValue:transformedValue forRawValue:rawValue typeKey:ISSTransformedValueCacheTypeKey(property)];
+}
+
+- (void) removeAllValues {
+    for(ISSTransformedValueCacheShard* shard in _shards) [shard removeAllValues];
+}
+
+- (void) getCount:(NSUInteger*)count hitCount:(NSUInteger*)hitCount missCount:(NSUInteger*)missCount evictionCount:(NSUInteger*)evictionCount {
+    *count = *hitCount = *missCount = *evictionCount = 0;
+    for(ISSTransformedValueCacheShard* shard in _shards) {
+        [shard getCount:count hitCount:hitCount missCount:missCount evictionCount:evictionCount];
+    }
+}
+
+- (NSUInteger) count {
+    NSUInteger count, hits, misses, evictions;
+    [self getCount:&count hitCount:&hits missCount:&misses evictionCount:&evictions];
+    return count;
+}
+
+- (NSUInteger) hitCount {
+    NSUInteger count, hits, misses, evictions;
+    [self getCount:&count hitCount:&hits missCount:&misses evictionCount:&evictions];
+    return hits;
+}
+
+- (NSUInteger) missCount {
+    NSUInteger count, hits, misses, evictions;
+    [self getCount:&count hitCount:&hits missCount:&misses evictionCount:&evictions];
+    return misses;
+}
+
+- (NSUInteger) evictionCount {
+    NSUInteger count, hits, misses, evictions;
+    [self getCount:&count hitCount:&hits missCount:&misses evictionCount:&evictions];
+    return evictions;
+}
+
+- (NSString*) description {
+    NSUInteger count, hits, misses, evictions;
+    [self getCount:&count hitCount:&hits missCount:&misses evictionCount:&evictions];
+    return [NSString stringWithFormat:@"ISSTransformedValueCache[%lu/%lu values, %lu hits, %lu misses, %lu evictions]", (unsigned long)count,
+            (unsigned long)self.capacity, (unsigned long)hits, (unsigned long)misses, (unsigned long)evictions];
+}
+
+@end
@@ -33,6 +33,12 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (id) dequeueReusablePrototypeHeaderFooterViewWithIdentifierISS:(NSString*)prototypeName;
 
+/**
+ * Prewarms the style caches for table view cells initialized from the prototype with the specified name, so that styles don't have to be resolved when the
+ * first cells are dequeued. See `-[InterfaCSS prewarmStylesForUIElement:inParent:completionHandler:]` for details.
+ */
+- (void) prewarmStylesForPrototypeCellWithIdentifierISS:(NSString*)prototypeName;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -33,4 +33,10 @@
     return view;
 }
 
+- (void) prewarmStylesForPrototypeCellWithIdentifierISS:(NSString*)prototypeName {
+    UIView* cell = [self dequeueReusableCellWithIdentifier:prototypeName]; // Throwaway cell, never returned to the table view
+    [cell setupViewFromPrototypeRegisteredInViewISS:self];
+    if( cell ) [[InterfaCSS sharedInstance] prewarmStylesForUIElement:cell inParent:self completionHandler:nil];
+}
+
 @end
@@ -29,6 +29,8 @@
 
 + (NSInvocation*) findSetterForProperty:(NSString*)propertyName inObject:(id)object;
 
++ (BOOL) hasSetterForProperty:(NSString*)propertyName inObject:(id)object;
+
 + (BOOL) invokeSetterForProperty:(NSString*)propertyName withValue:(id)value inObject:(id)object;
 
 + (id) invokeGetterForKeyPath:(NSString*)keyPath inObject:(id)object;
@@ -8,20 +8,100 @@
 
 #import "ISSRuntimeIntrospectionUtils.h"
 
-#import "NSString+ISSStringAdditions.h"
+#import <UIKit/UIKit.h>
 #import <objc/runtime.h>
+#import <pthread.h>
+
+#import "NSString+ISSStringAdditions.h"
+
+
+typedef NS_ENUM(NSInteger, ISSSetterArgumentType) {
+    ISSSetterArgumentTypeObject,
+    ISSSetterArgumentTypeChar,
+    ISSSetterArgumentTypeShort,
+    ISSSetterArgumentTypeInt,
+    ISSSetterArgumentTypeLong,
+    ISSSetterArgumentTypeLongLong,
+    ISSSetterArgumentTypeUnsignedChar,
+    ISSSetterArgumentTypeUnsignedShort,
+    ISSSetterArgumentTypeUnsignedInt,
+    ISSSetterArgumentTypeUnsignedLong,
+    ISSSetterArgumentTypeUnsignedLongLong,
+    ISSSetterArgumentTypeFloat,
+    ISSSetterArgumentTypeDouble,
+    ISSSetterArgumentTypeBool,
+    ISSSetterArgumentTypeCGRect,
+    ISSSetterArgumentTypeCGPoint,
+    ISSSetterArgumentTypeCGSize,
+    ISSSetterArgumentTypeCGAffineTransform,
+    ISSSetterArgumentTypeUIEdgeInsets,
+    ISSSetterArgumentTypeUIOffset,
+    ISSSetterArgumentTypeUnsupported
+};
+
+
+/**
+ * Setter resolved for a particular class and property - contains the selector, the implementation and the argument type of the setter.
+ */
+@interface ISSCachedSetter : NSObject {
+    @package
+    SEL _selector;
+    IMP _imp;
+    ISSSetterArgumentType _argumentType;
+}
+@end
+
+@implementation ISSCachedSetter
+@end
 
 
 static NSCache* propertyNamesWithClassForClassCache;
 
+static NSMapTable* cachedSettersForClass; // Class -> NSMutableDictionary (property name -> ISSCachedSetter or NSNull)
+static pthread_mutex_t cachedSettersLock = PTHREAD_MUTEX_INITIALIZER;
+
+
+static ISSSetterArgumentType setterArgumentTypeForEncoding(const char* argType) {
+    // Skip type qualifiers (const, in, out etc)
+    while( *argType && strchr("rnNoORV", *argType) ) argType++;
+
+    if( *argType == *@encode(id) ) return ISSSetterArgumentTypeObject;
+    else if( strcmp(argType, @encode(CGRect)) == 0 ) return ISSSetterArgumentTypeCGRect;
+    else if( strcmp(argType, @encode(CGPoint)) == 0 ) return ISSSetterArgumentTypeCGPoint;
+    else if( strcmp(argType, @encode(CGSize)) == 0 ) return ISSSetterArgumentTypeCGSize;
+    else if( strcmp(argType, @encode(CGAffineTransform)) == 0 ) return ISSSetterArgumentTypeCGAffineTransform;
+    else if( strcmp(argType, @encode(UIEdgeInsets)) == 0 ) return ISSSetterArgumentTypeUIEdgeInsets;
+    else if( strcmp(argType, @encode(UIOffset)) == 0 ) return ISSSetterArgumentTypeUIOffset;
+    else if( *argType == *@encode(char) ) return ISSSetterArgumentTypeChar;
+    else if( *argType == *@encode(short) ) return ISSSetterArgumentTypeShort;
+    else if( *argType == *@encode(int) ) return ISSSetterArgumentTypeInt;
+    else if( *argType == *@encode(long) ) return ISSSetterArgumentTypeLong;
+    else if( *argType == *@encode(long long) ) return ISSSetterArgumentTypeLongLong;
+    else if( *argType == *@encode(unsigned char) ) return ISSSetterArgumentTypeUnsignedChar;
+    else if( *argType == *@encode(unsigned short) ) return ISSSetterArgumentTypeUnsignedShort;
+    else if( *argType == *@encode(unsigned int) ) return ISSSetterArgumentTypeUnsignedInt;
+    else if( *argType == *@encode(unsigned long) ) return ISSSetterArgumentTypeUnsignedLong;
+    else if( *argType == *@encode(unsigned long long) ) return ISSSetterArgumentTypeUnsignedLongLong;
+    else if( *argType == *@encode(float) ) return ISSSetterArgumentTypeFloat;
+    else if( *argType == *@encode(double) ) return ISSSetterArgumentTypeDouble;
+    else if( *argType == *@encode(BOOL) ) return ISSSetterArgumentTypeBool;
+    else return ISSSetterArgumentTypeUnsupported;
+}
+
+
 @implementation ISSRuntimeIntrospectionUtils
 
 + (void) load {
     propertyNamesWithClassForClassCache = [[NSCache alloc] init];
+    cachedSettersForClass = [NSMapTable strongToStrongObjectsMapTable];
 }
 
 + (void) clearCaches {
     [propertyNamesWithClassForClassCache removeAllObjects];
+
+    pthread_mutex_lock(&cachedSettersLock);
+    [cachedSettersForClass removeAllObjects];
+    pthread_mutex_unlock(&cachedSettersLock);
 }
 
 + (SEL) findSelectorWithCaseInsensitiveName:(NSString*)name inClass:(Class)clazz {
@@ -192,9 +272,7 @@ static NSCache* propertyNamesWithClassForClassCache;
     return [self findPropertyWithName:propertyName inClass:clazz excludingRootClass:rootClass] != nil;
 }
 
-+ (NSInvocation*) findSetterForProperty:(NSString*)propertyName inObject:(id)object {
-    if( !object || ![propertyName iss_hasData] ) return nil;
-    
++ (NSString*) setterNameForProperty:(NSString*)propertyName inObject:(id)object {
     objc_property_t property = [self findPropertyWithName:propertyName inObject:object];
     NSString* setter = nil;
     if( property ) {
@@ -207,8 +285,50 @@ static NSCache* propertyNamesWithClassForClassCache;
             setter = [NSString stringWithFormat:@"set%@:", [[propertyName substringToIndex:1] uppercaseString]];
         }
     }
-    
-    return [self invocationForSelectorWithName:setter inObject:object];
+    return setter;
+}
+
++ (NSInvocation*) findSetterForProperty:(NSString*)propertyName inObject:(id)object {
+    if( !object || ![propertyName iss_hasData] ) return nil;
+
+    return [self invocationForSelectorWithName:[self setterNameForProperty:propertyName inObject:object] inObject:object];
+}
+
++ (ISSCachedSetter*) resolveSetterForProperty:(NSString*)propertyName inObject:(id)object {
+    NSInvocation* invocation = [self findSetterForProperty:propertyName inObject:object];
+    if( !invocation || invocation.methodSignature.numberOfArguments != 3 ) return nil;
+
+    ISSCachedSetter* setter = [[ISSCachedSetter alloc] init];
+    setter->_selector = invocation.selector;
+    setter->_imp = class_getMethodImplementation(object_getClass(object), invocation.selector);
+    setter->_argumentType = setterArgumentTypeForEncoding([invocation.methodSignature getArgumentTypeAtIndex:2]);
+    if( !setter->_imp || setter->_argumentType == ISSSetterArgumentTypeUnsupported ) return nil;
+    return setter;
+}
+
++ (ISSCachedSetter*) cachedSetterForProperty:(NSString*)propertyName inObject:(id)object {
+    // Note: setters are cached per actual (isa) class of object, to make sure dynamic subclasses (i.e. KVO) get the correct implementation
+    Class clazz = object_getClass(object);
+
+    pthread_mutex_lock(&cachedSettersLock);
+    NSMutableDictionary* settersForClass = [cachedSettersForClass objectForKey:clazz];
+    id setter = settersForClass[propertyName];
+    pthread_mutex_unlock(&cachedSettersLock);
+
+    if( !setter ) {
+        setter = [self resolveSetterForProperty:propertyName inObject:object] ?: [NSNull null];
+
+        pthread_mutex_lock(&cachedSettersLock);
+        settersForClass = [cachedSettersForClass objectForKey:clazz];
+        if( !settersForClass ) {
+            settersForClass = [NSMutableDictionary dictionary];
+            [cachedSettersForClass setObject:settersForClass forKey:clazz];
+        }
+        settersForClass[propertyName] = setter;
+        pthread_mutex_unlock(&cachedSettersLock);
+    }
+
+    return setter != [NSNull null] ? setter : nil;
 }
 
 + (NSInvocation*) findGetterForProperty:(NSString*)propertyName inObject:(id)object {
@@ -224,77 +344,50 @@ static NSCache* propertyNamesWithClassForClassCache;
     return [self invocationForSelectorWithName:getter inObject:object];
 }
 
++ (BOOL) hasSetterForProperty:(NSString*)propertyName inObject:(id)object {
+    if( !object || ![propertyName iss_hasData] ) return NO;
+
+    return [self cachedSetterForProperty:propertyName inObject:object] != nil;
+}
+
 + (BOOL) invokeSetterForProperty:(NSString*)propertyName withValue:(id)value inObject:(id)object {
-    NSInvocation* invocation = [self findSetterForProperty:propertyName inObject:object];
-    if( !invocation ) return NO;
-    
-    const char* argType = [invocation.methodSignature getArgumentTypeAtIndex:2];
-    
-    void* argValue = nil;
-    
-    if( *argType == *@encode(id) ) {
-        [invocation setArgument:&value atIndex:2];
-    }
-    else if( *argType == *@encode(char) ) {
-        char v = [value charValue];
-        argValue = &v;
-    }
-    else if( *argType == *@encode(short) ) {
-        short v = [value shortValue];
-        argValue = &v;
-    }
-    else if( *argType == *@encode(int) ) {
-        int v = [value intValue];
-        argValue = &v;
-    }
-    else if( *argType == *@encode(long) ) {
-        long v = [value longValue];
-        argValue = &v;
-    }
-    else if( *argType == *@encode(long long) ) {
-        long long v = [value longLongValue];
-        argValue = &v;
-    }
-    else if( *argType == *@encode(unsigned char) ) {
-        unsigned char v = [value unsignedCharValue];
-        argValue = &v;
-    }
-    else if( *argType == *@encode(unsigned short) ) {
-        unsigned short v = [value unsignedShortValue];
-        argValue = &v;
-    }
-    else if( *argType == *@encode(unsigned int) ) {
-        unsigned int v = [value unsignedIntValue];
-        argValue = &v;
-    }
-    else if( *argType == *@encode(unsigned long) ) {
-        unsigned long v = [value unsignedLongValue];
-        argValue = &v;
-    }
-    else if( *argType == *@encode(unsigned long long) ) {
-        unsigned long long v = [value unsignedLongLongValue];
-        argValue = &v;
-    }
-    else if( *argType == *@encode(float) ) {
-        float v = [value floatValue];
-        argValue = &v;
-    }
-    else if( *argType == *@encode(double) ) {
-        double v = [value doubleValue];
-        argValue = &v;
-    }
-    else if( *argType == *@encode(BOOL) ) {
-        BOOL v = [value boolValue];
-        argValue = &v;
-    } else {
-        return NO;
+    if( !object || ![propertyName iss_hasData] ) return NO;
+
+    ISSCachedSetter* setter = [self cachedSetterForProperty:propertyName inObject:object];
+    if( !setter ) return NO;
+
+    SEL sel = setter->_selector;
+    IMP imp = setter->_imp;
+    switch( setter->_argumentType ) {
+        case ISSSetterArgumentTypeObject: ((void (*)(id, SEL, id))imp)(object, sel, value); break;
+        case ISSSetterArgumentTypeChar: ((void (*)(id, SEL, char))imp)(object, sel, [value charValue]); break;
+        case ISSSetterArgumentTypeShort: ((void (*)(id, SEL, short))imp)(object, sel, [value shortValue]); break;
+        case ISSSetterArgumentTypeInt: ((void (*)(id, SEL, int))imp)(object, sel, [value intValue]); break;
+        case ISSSetterArgumentTypeLong: ((void (*)(id, SEL, long))imp)(object, sel, [value longValue]); break;
+        case ISSSetterArgumentTypeLongLong: ((void (*)(id, SEL, long long))imp)(object, sel, [value longLongValue]); break;
+        case ISSSetterArgumentTypeUnsignedChar: ((void (*)(id, SEL, unsigned char))imp)(object, sel, [value unsignedCharValue]); break;
+        case ISSSetterArgumentTypeUnsignedShort: ((void (*)(id, SEL, unsigned short))imp)(object, sel, [value unsignedShortValue]); break;
+        case ISSSetterArgumentTypeUnsignedInt: ((void (*)(id, SEL, unsigned int))imp)(object, sel, [value unsignedIntValue]); break;
+        case ISSSetterArgumentTypeUnsignedLong: ((void (*)(id, SEL, unsigned long))imp)(object, sel, [value unsignedLongValue]); break;
+        case ISSSetterArgumentTypeUnsignedLongLong: ((void (*)(id, SEL, unsigned long long))imp)(object, sel, [value unsignedLongLongValue]); break;
+        case ISSSetterArgumentTypeFloat: ((void (*)(id, SEL, float))imp)(object, sel, [value floatValue]); break;
+        case ISSSetterArgumentTypeDouble: ((void (*)(id, SEL, double))imp)(object, sel, [value doubleValue]); break;
+        case ISSSetterArgumentTypeBool: ((void (*)(id, SEL, BOOL))imp)(object, sel, [value boolValue]); break;
+        default: {
+            // Struct arguments - value must be an NSValue containing a value of the correct type
+            if( ![value isKindOfClass:NSValue.class] ) return NO;
+            switch( setter->_argumentType ) {
+                case ISSSetterArgumentTypeCGRect: ((void (*)(id, SEL, CGRect))imp)(object, sel, [value CGRectValue]); break;
+                case ISSSetterArgumentTypeCGPoint: ((void (*)(id, SEL, CGPoint))imp)(object, sel, [value CGPointValue]); break;
+                case ISSSetterArgumentTypeCGSize: ((void (*)(id, SEL, CGSize))imp)(object, sel, [value CGSizeValue]); break;
+                case ISSSetterArgumentTypeCGAffineTransform: ((void (*)(id, SEL, CGAffineTransform))imp)(object, sel, [value CGAffineTransformValue]); break;
+                case ISSSetterArgumentTypeUIEdgeInsets: ((void (*)(id, SEL, UIEdgeInsets))imp)(object, sel, [value UIEdgeInsetsValue]); break;
+                case ISSSetterArgumentTypeUIOffset: ((void (*)(id, SEL, UIOffset))imp)(object, sel, [value UIOffsetValue]); break;
+                default: return NO;
+            }
+        }
     }
-    
-    if( argValue ) {
-        [invocation setArgument:argValue atIndex:2];
-    }   
-    [invocation invoke];
-    
+
     return YES;
 }
 
@@ -12,4 +12,10 @@
 
 - (void) iss_addAndReplaceUniqueObjectsInArray:(NSArray*)array;
 
+/**
+ * Adds the objects in each of the specified arrays (in order), replacing any previously added equal object, i.e. the last occurrence of an object wins and determines its position.
+ * Equivalent to calling `iss_addAndReplaceUniqueObjectsInArray:` for each array, but runs in linear time (uses `hash` and `isEqual:`).
+ */
+- (void) iss_addAndReplaceUniqueObjectsInArrays:(NSArray*)arrays;
+
 @end
\ No newline at end of file
@@ -17,4 +17,26 @@
     }
 }
 
+- (void) iss_addAndReplaceUniqueObjectsInArrays:(NSArray*)arrays {
+    NSMutableArray* allObjects = [NSMutableArray arrayWithArray:self];
+    for(NSArray* array in arrays) {
+        [allObjects addObjectsFromArray:array];
+    }
+
+    // Find index of last occurrence of each unique object
+    NSMapTable* lastOccurrences = [NSMapTable strongToStrongObjectsMapTable];
+    NSUInteger index = 0;
+    for(id element in allObjects) {
+        [lastOccurrences setObject:@(index++) forKey:element];
+    }
+
+    // Only keep the last occurrence of each object
+    [self removeAllObjects];
+    index = 0;
+    for(id element in allObjects) {
+        if( [[lastOccurrences objectForKey:element] unsignedIntegerValue] == index ) [self addObject:element];
+        index++;
+    }
+}
+
 @end
\ No newline at end of file
@@ -0,0 +1,48 @@
+#!/bin/bash
+#
+#  compile-stylesheets.sh
+#  Part of InterfaCSS - http://www.github.com/tolo/InterfaCSS
+#
+#  Copyright (c) Tobias Löfstrand, Leafnode AB.
+#  License: MIT (http://www.github.com/tolo/InterfaCSS/LICENSE)
+#
+#  Compiles one or more stylesheets into the binary format loaded by ISSStyleSheetCompiler (i.e. "styles.css" is compiled to "styles.cssc", next to the
+#  source file). The isscompile tool is built (using the iOS simulator SDK) if needed, and then run in a booted simulator.
+#
+#  Usage: compile-stylesheets.sh <stylesheet.css> [<stylesheet.css> ...]
+#
+#  Environment:
+#    ISSCOMPILE_SIMULATOR - the UDID (or name) of the simulator device to run the tool in (defaults to "booted").
+#    ISSCOMPILE_BUILD_DIR - the directory in which the tool is built (defaults to "build/isscompile" in the InterfaCSS project directory).
+#
+#  Example "Run Script" build phase (placed before "Copy Bundle Resources", with the .css files as input files and the .cssc files as output files):
+#
+#    "${SRCROOT}/Vendor/InterfaCSS/Tools/isscompile/compile-stylesheets.sh" "${SRCROOT}/MyApp/styles.css"
+#
+
+set -e
+
+if [ $# -lt 1 ]; then
+    echo "Usage: $(basename "$0") <stylesheet.css> [<stylesheet.css> ...]" >&2
+    exit 1
+fi
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+PROJECT_DIR="$(cd "$SCRIPT_DIR/../.." && pwd)"
+BUILD_DIR="${ISSCOMPILE_BUILD_DIR:-$PROJECT_DIR/build/isscompile}"
+SIMULATOR="${ISSCOMPILE_SIMULATOR:-booted}"
+TOOL="$BUILD_DIR/Release-iphonesimulator/isscompile"
+
+mkdir -p "$BUILD_DIR"
+
+# Build the tool with a clean environment, since the build settings exported to a build phase script would otherwise leak into the build of the tool
+env -i PATH="$PATH" HOME="$HOME" xcodebuild -project "$PROJECT_DIR/InterfaCSS.xcodeproj" -target isscompile -configuration Release -sdk iphonesimulator \
+    SYMROOT="$BUILD_DIR" build > "$BUILD_DIR/build.log" 2>&1 || { echo "error: Failed to build isscompile (see $BUILD_DIR/build.log)" >&2; exit 1; }
+
+# The tool runs in the simulator, which shares the file system of the host, but not the current directory - hence absolute paths are passed
+STYLESHEETS=()
+for STYLESHEET in "$@"; do
+    STYLESHEETS+=("$(cd "$(dirname "$STYLESHEET")" && pwd)/$(basename "$STYLESHEET")")
+done
+
+xcrun simctl spawn "$SIMULATOR" "$TOOL" "${STYLESHEETS[@]}"
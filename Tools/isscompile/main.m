@@ -0,0 +1,39 @@
+//
+//  main.m
+//  Part of InterfaCSS - http://www.github.com/tolo/InterfaCSS
+//
+//  Copyright (c) Tobias Löfstrand, Leafnode AB.
+//  License: MIT (http://www.github.com/tolo/InterfaCSS/LICENSE)
+//
+//  Build time stylesheet compiler - compiles one or more stylesheets into the binary format loaded by ISSStyleSheetCompiler (i.e. "styles.css" is compiled
+//  to "styles.cssc", next to the source file). Since the InterfaCSS property registry depends on UIKit, this tool is built against the iOS simulator SDK
+//  (target "isscompile", linked with libInterfaCSS.a), and run in a simulator using for instance: xcrun simctl spawn booted isscompile path/to/styles.css [...]
+//  See compile-stylesheets.sh, which builds and runs the tool, and can be used from a build phase.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "ISSStyleSheetCompiler.h"
+
+
+int main(int argc, const char* argv[]) {
+    @autoreleasepool {
+        if( argc < 2 ) {
+            fprintf(stderr, "Usage: isscompile <stylesheet.css> [<stylesheet.css> ...]\n");
+            return 1;
+        }
+
+        int result = 0;
+        for(int i=1; i<argc; i++) {
+            NSURL* styleSheetURL = [NSURL fileURLWithPath:[NSString stringWithUTF8String:argv[i]]];
+            NSURL* compiledStyleSheetURL = [ISSStyleSheetCompiler compiledStyleSheetURLForStyleSheetURL:styleSheetURL];
+            if( [ISSStyleSheetCompiler compileStyleSheetAtURL:styleSheetURL toURL:compiledStyleSheetURL] ) {
+                printf("Compiled %s -> %s\n", styleSheetURL.path.UTF8String, compiledStyleSheetURL.path.UTF8String);
+            } else {
+                fprintf(stderr, "Error compiling %s\n", styleSheetURL.path.UTF8String);
+                result = 1;
+            }
+        }
+        return result;
+    }
+}